@@ -10,6 +10,11 @@
 #include "hesiod/app/app_settings.hpp"
 #include "hesiod/app/enum_mappings.hpp"
 #include "hesiod/app/style_settings.hpp"
+#include "hesiod/model/export_queue.hpp"
+#include "hesiod/model/nodes/import_cache.hpp"
+#include "hesiod/model/nodes/node_data_store.hpp"
+#include "hesiod/model/nodes/node_output_cache.hpp"
+#include "hesiod/model/profiler.hpp"
 #include "hesiod/model/project_model.hpp"
 
 namespace hesiod
@@ -32,7 +37,7 @@ public:
   // --- Project management
   void new_project();
   void load_project_model(const std::string &fname);
-  void save_project_model(const std::string &fname) const;
+  void save_project_model(const std::string &fname, bool save_node_data = true);
 
   // --- Data
   void load_node_documentation();
@@ -44,11 +49,27 @@ public:
 
   // project
   std::unique_ptr<ProjectModel> project_model;
+
+  // node outputs, shared by all the graphs
+  NodeOutputCache node_output_cache;
+
+  // computed node outputs saved along with the project file
+  NodeDataStore node_data_store;
+
+  // decoded Import* files, shared by all the graphs
+  ImportCache import_cache;
+
+  // files written by the Export* nodes, in the background
+  ExportQueue export_queue;
+
+  // node evaluations timing and memory
+  Profiler profiler;
 };
 
 // helpers
 
 std::string get_config_file_path(const QString &app_name, bool portable_mode);
 std::string get_config_file_path_auto(const QString &app_name);
+std::string get_node_cache_dir_default();
 
 } // namespace hesiod
\ No newline at end of file
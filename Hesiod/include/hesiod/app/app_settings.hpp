@@ -26,6 +26,28 @@ struct AppSettings
   struct Model
   {
     bool allow_broadcast_receive_within_same_graph = true;
+
+    // graph update
+    bool enable_parallel_update = false;    // compute independent nodes concurrently
+    bool deterministic_update_order = true; // publish results in topological order
+    int  update_thread_count = 0;           // 0: use hardware concurrency
+    bool enable_async_update = false;       // GUI edits evaluated off the GUI thread
+    bool enable_tile_update = false;        // only recompute tiles affected by edits
+    bool enable_progressive_update = false; // coarse preview first, then full resolution
+    int  preview_resolution = 256;          // coarse preview resolution (largest side)
+    bool enable_profiling = false;          // record node evaluations for export
+    bool enable_async_export = true;        // Export* nodes write files in the background
+
+    // node output cache
+    bool        enable_node_cache = false; // reuse outputs of identical computations
+    int         node_cache_budget_mb = 1024;
+    bool        enable_disk_cache = false; // persist the cache between sessions
+    int         node_cache_disk_budget_mb = 8192;
+    std::string node_cache_dir = ""; // default: user cache location
+
+    // computed node outputs saved next to the project file (<project>.hsd.data/)
+    bool enable_node_data_store = false;
+    bool node_data_compression = true;
   } model;
 
   struct Colors
@@ -97,6 +119,8 @@ struct AppSettings
     int  width = 512;
     int  height = 512;
     bool add_heighmap_skirt = true;
+    bool enable_mesh_lod = true;     // mesh resolution from the viewport size
+    int  max_mesh_resolution = 2048; // when the LOD is enabled
   } viewer;
 
   struct Window // main window
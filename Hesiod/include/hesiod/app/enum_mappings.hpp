@@ -108,7 +108,8 @@ static struct EnumMappings
   const std::map<std::string, int> heightmap_export_format_map = {
       {"png (8 bit)", ExportFormat::PNG8BIT},
       {"png (16 bit)", ExportFormat::PNG16BIT},
-      {"raw (16 bit, Unity)", ExportFormat::RAW16BIT}};
+      {"raw (16 bit, Unity)", ExportFormat::RAW16BIT},
+      {"tiff (32 bit float, tiled)", ExportFormat::TIFF32BIT}};
 
   const std::map<std::string, int> interpolation_method2d_map = {
       {"Delaunay", hmap::InterpolationMethod2D::ITP2D_DELAUNAY},
@@ -35,7 +35,7 @@ public:
   ~HesiodApplication();
 
   void load_project_model_and_ui(const std::string &fname = "", bool keep_name = true);
-  void save_project_model_and_ui(const std::string &fname);
+  void save_project_model_and_ui(const std::string &fname, bool save_node_data = true);
   void save_backup(const std::string &fname);
   void show();
 
@@ -51,6 +51,7 @@ private slots:
   // --- User actions
   void on_application_settings_action();
   void on_export_batch();
+  void on_export_profiling();
   void on_load();
   void on_load_ready_made();
   void on_new();
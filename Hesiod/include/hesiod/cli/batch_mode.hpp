@@ -2,6 +2,7 @@
    License. The full license is in the file LICENSE, distributed with this software. */
 #pragma once
 #include <fstream>
+#include <vector>
 
 // in this order, required by args.hxx
 #include "highmap/algebra.hpp"
@@ -14,6 +15,7 @@ static std::istream &operator>>(std::istream &is, glm::ivec2 &vec2)
 }
 #include <args.hxx>
 
+#include "hesiod/model/export_queue.hpp"
 #include "hesiod/model/graph/graph_config.hpp"
 
 namespace hesiod::cli
@@ -21,12 +23,43 @@ namespace hesiod::cli
 
 int parse_args(args::ArgumentParser &parser, int argc, char *argv[]);
 
-void run_batch_mode(const std::string &filename,
+// returns false if any file could not be exported. The exports go through
+// 'p_export_queue' if provided, the application queue otherwise, and are written by the
+// graph update itself if 'async_export' is false (whatever the application settings)
+bool run_batch_mode(const std::string &filename,
                     const glm::ivec2  &shape,
                     const glm::ivec2  &tiling,
                     float              overlap,
-                    const GraphConfig *p_input_model_config = nullptr);
+                    const GraphConfig *p_input_model_config = nullptr,
+                    ExportQueue       *p_export_queue = nullptr,
+                    bool               async_export = true);
 void run_node_inventory();
+
+// executes the jobs (project, shape, tiling, seed offset, output directory) of a JSON or
+// CSV manifest, one after the other within the same process (imported files are loaded
+// once). The completed jobs are stored in a state file (default:
+// <manifest>.state.json) and are skipped when the queue is run again. Returns 1 if a
+// job failed
+int run_job_queue(const std::string &manifest_fname, const std::string &state_fname = "");
+
+// times every node type over a matrix of shapes, tilings and CPU compute modes, the
+// results are written to a CSV or JSON file (by extension). Returns the number of
+// regressions against the baseline (a JSON file written by a previous run), if any
+int run_benchmark(const std::string      &fname,
+                  const std::vector<int> &shapes,
+                  int                     nrepeat,
+                  const std::string      &filter = "",
+                  const std::string      &baseline_fname = "",
+                  float                   tolerance = 0.1f);
+
+// loads, updates and exports every project (.hsd) found in the directories, for each
+// shape, and writes the timings per project and per node type to a CSV or JSON file
+int run_project_benchmark(const std::string              &fname,
+                          const std::vector<std::string> &dirs,
+                          const std::vector<int>         &shapes,
+                          const glm::ivec2               &tiling,
+                          const std::string              &filter = "");
+
 void run_snapshot_generation();
 
 } // namespace hesiod::cli
\ No newline at end of file
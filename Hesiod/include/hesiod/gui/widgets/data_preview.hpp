@@ -5,6 +5,7 @@
 
 #include <QContextMenuEvent>
 #include <QLabel>
+#include <QTimer>
 
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
@@ -29,14 +30,22 @@ static std::map<std::string, PreviewType> preview_type_map = {
     // {"Slope/elev. heatmap", PreviewType::SLOPE_ELEVATION_HEATMAP},
 };
 
+struct PreviewRenderState; // forward
+
 // =====================================
 // DataPreview
 // =====================================
+
+// node data thumbnail. Updates are coalesced (at most one per frame), deferred while
+// the preview is hidden or out of the node editor view, and rendered by a pool of
+// workers shared by all the previews, the latest request of a preview superseding the
+// pending ones
 class DataPreview : public QLabel
 {
 public:
   DataPreview() = default;
   DataPreview(std::weak_ptr<BaseNode> model, QWidget *parent = nullptr);
+  ~DataPreview() override;
 
   const QPixmap &get_preview_pixmap() const;
 
@@ -46,12 +55,21 @@ public slots:
 
 protected:
   void contextMenuEvent(QContextMenuEvent *event) override;
+  bool eventFilter(QObject *watched, QEvent *event) override; // node editor views
+  void showEvent(QShowEvent *event) override;
 
 private:
-  std::weak_ptr<BaseNode> model;
-  int                     preview_port_index;
-  PreviewType             preview_type = PreviewType::GRAYSCALE;
-  QPixmap                 preview_pixmap;
+  bool is_in_viewport();
+  void render_preview(); // submit the rendering of the current data
+  void set_preview_image(const QImage &image, uint64_t generation);
+
+  std::weak_ptr<BaseNode>             model;
+  int                                 preview_port_index;
+  PreviewType                         preview_type = PreviewType::GRAYSCALE;
+  QPixmap                             preview_pixmap;
+  QTimer                             *update_timer = nullptr;
+  bool                                is_update_pending = false;
+  std::shared_ptr<PreviewRenderState> render_state; // shared with the workers
 };
 
 } // namespace hesiod
\ No newline at end of file
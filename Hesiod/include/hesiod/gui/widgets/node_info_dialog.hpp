@@ -9,6 +9,7 @@
 #include <QWidget>
 
 #include "hesiod/gui/widgets/graph_node_widget.hpp"
+#include "hesiod/gui/widgets/region_probe_widget.hpp"
 
 namespace hesiod
 {
@@ -48,10 +49,11 @@ private:
   std::string               node_id;
 
   // UI
-  QVBoxLayout    *layout;
-  QGridLayout    *grid_ports;
-  QGridLayout    *grid_info;
-  QPlainTextEdit *editor;
+  QVBoxLayout       *layout;
+  QGridLayout       *grid_ports;
+  QGridLayout       *grid_info;
+  QPlainTextEdit    *editor;
+  RegionProbeWidget *probe = nullptr; // only for nodes with heightmap ports
 };
 
 } // namespace hesiod
\ No newline at end of file
@@ -0,0 +1,65 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <functional>
+#include <vector>
+
+#include <QImage>
+#include <QTimer>
+#include <QWidget>
+
+#include "hesiod/model/nodes/base_node.hpp"
+
+namespace hesiod
+{
+
+// =====================================
+// RegionProbeWidget
+// =====================================
+
+// heightmap inspection. The overview comes from the preview pyramid, hovering it shows
+// the full resolution value under the cursor, a zoomed view around it (mouse wheel to
+// zoom) and the profile along the hovered row. Full resolution data is fetched on
+// demand, in a single pass reading the tiles overlapping the probed region only, and
+// deferred while the graph is evaluated
+class RegionProbeWidget : public QWidget
+{
+  Q_OBJECT
+
+public:
+  RegionProbeWidget() = default;
+  RegionProbeWidget(std::function<BaseNode *()> get_node, QWidget *parent = nullptr);
+
+  void set_port_index(int new_port_index);
+  void update_overview(); // to be called when the node data changed
+
+protected:
+  void leaveEvent(QEvent *event) override;
+  void mouseMoveEvent(QMouseEvent *event) override;
+  void paintEvent(QPaintEvent *event) override;
+  void wheelEvent(QWheelEvent *event) override;
+
+private:
+  void update_probe(); // fetch the full resolution data around the probe
+
+  std::function<BaseNode *()> get_node; // nullptr once the node is gone
+  int                         port_index = -1;
+  QTimer                     *probe_timer = nullptr;
+
+  // probe
+  bool               is_probing = false;
+  glm::vec2          probe_pos = {0.f, 0.f};        // unit coordinates
+  glm::vec4          zoom_bbox = {0.f, 1.f, 0.f, 1.f}; // zoomed window
+  int                zoom_cells = 64;                // zoomed window width, in cells
+  float              probe_value = 0.f;
+  std::vector<float> profile;
+
+  // rendering
+  QImage     overview;
+  QImage     zoom;
+  float      vmin = 0.f;
+  float      vmax = 1.f;
+  glm::ivec2 source_shape = {0, 0};
+};
+
+} // namespace hesiod
@@ -8,6 +8,15 @@
 namespace hesiod
 {
 
+std::vector<uint8_t> generate_rgba_image(const std::vector<const hmap::Array *> &rgba);
 std::vector<uint8_t> generate_selector_image(hmap::Array &array);
 
+// water surface (elevation + water depth) extended by one cell over the dry cells
+// bordering the water, using the lowest neighboring water surface, to avoid truncated
+// cells at the water/ground interface. Dry cells are set to 'cut_value'
+void generate_water_surface(const hmap::Array &elevation,
+                            const hmap::Array &water_depth,
+                            float              cut_value,
+                            hmap::Array       &surface);
+
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "qtr/render_widget.hpp"
 
 #include "hesiod/gui/widgets/viewers/viewer.hpp"
+#include "hesiod/gui/widgets/viewers/viewer_lod_cache.hpp"
 
 namespace hesiod
 {
@@ -43,11 +44,20 @@ protected:
   void resizeEvent(QResizeEvent *) override;
 
 private:
+  void            clear_renderer(); // renderer data and upload caches
   ViewerNodeParam get_default_view_param() const override;
+  int             get_mesh_lod(const glm::ivec2 &shape) const; // from the viewport size
   void            update_renderer() override;
 
   ViewerType         viewer_type;
   qtr::RenderWidget *p_renderer = nullptr;
+
+  // data sent to the renderer, only uploaded again when its content changed
+  ViewerLodCache elevation_cache;
+  ViewerLodCache water_cache; // elevation and water depth
+  ViewerLodCache color_cache;
+  ViewerLodCache normal_map_cache;
+  bool           uploaded_skirt = false;
 };
 
 } // namespace hesiod
\ No newline at end of file
@@ -0,0 +1,58 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "highmap/virtual_array/virtual_array.hpp"
+
+#include "hesiod/model/nodes/tile_dirty_tracker.hpp"
+
+namespace hesiod
+{
+
+// =====================================
+// ViewerLodCache
+// =====================================
+
+// reduced copy of the heightmap (or texture channels) sent to the 3D renderer. The
+// data is decimated to the LOD level (power of two reduction factor) tile by tile, and
+// only the tiles whose content changed since the previous update are decimated again.
+// The data is not hashed here (GUI thread), the changes are identified by the hashes
+// computed along with the node outputs
+class ViewerLodCache
+{
+public:
+  ViewerLodCache() = default;
+
+  // true if the data changed and needs to be sent to the renderer. 'channel_hashes'
+  // (one per channel, see BaseNode::get_output_tile_hashes) identify the modified
+  // tiles, 'data_hash' (see BaseNode::get_output_hash) the unmodified data when the
+  // tile hashes are not known. Everything is decimated again if neither is known
+  bool update(const std::vector<hmap::VirtualArray *> &channels,
+              int                                      new_lod,
+              const glm::ivec2                        &tile_shape,
+              const hmap::ComputeMode                 &cm,
+              const std::vector<const TileHashes *>   &channel_hashes = {},
+              uint64_t                                 data_hash = 0);
+
+  void clear(); // next update sends the data again
+
+  const hmap::Array &get_array(size_t channel = 0) const;
+  int                get_lod() const;
+  glm::ivec2         get_shape() const;
+  glm::ivec2         get_source_shape() const;
+
+  // coarsest LOD keeping at least 'resolution' cells along the largest dimension
+  static int get_lod_for_resolution(const glm::ivec2 &shape, int resolution);
+
+private:
+  std::vector<hmap::Array> arrays;
+  TileHashes               tile_hashes;   // hash of the channels, for each source tile
+  uint64_t                 data_hash = 0; // 0 if unknown
+  glm::ivec2               source_shape = {0, 0};
+  int                      lod = -1;
+};
+
+} // namespace hesiod
@@ -0,0 +1,88 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hesiod
+{
+
+struct ExportReport
+{
+  size_t                   ncompleted = 0;
+  size_t                   nfailed = 0;
+  size_t                   nsuperseded = 0; // replaced by a newer export of the same file
+  std::vector<std::string> failures;        // labels of the latest failed exports
+};
+
+// =====================================
+// ExportQueue
+// =====================================
+
+// background I/O pipeline of the Export* nodes, so that graph evaluation does not wait
+// on the disk. Tasks must only use data they own (snapshot of the node inputs). Exports
+// of the same file are written in submission order, and a pending export is replaced
+// when a newer one of the same file is submitted
+class ExportQueue
+{
+public:
+  explicit ExportQueue(size_t nthreads = 2); // I/O bound, a few threads are enough
+  ~ExportQueue();                            // pending exports are written first
+
+  ExportQueue(const ExportQueue &) = delete;
+  ExportQueue &operator=(const ExportQueue &) = delete;
+
+  // 'key' identifies the output (file name), the task returns false on failure
+  void submit(const std::string    &key,
+              const std::string    &label,
+              std::function<bool()> task);
+
+  // synchronous export, executed on the calling thread and recorded in the report like
+  // the queued ones. Returns false on failure
+  bool run(const std::string &label, const std::function<bool()> &task);
+
+  // barrier, waits for all the submitted exports and returns the report of the exports
+  // completed since the previous flush
+  ExportReport flush();
+
+  size_t get_npending() const; // queued or running
+
+  // the exports of a synchronous queue are written by the caller (see 'run'), whatever
+  // the application settings
+  bool is_synchronous() const { return this->synchronous; }
+  void set_synchronous(bool new_synchronous) { this->synchronous = new_synchronous; }
+
+private:
+  struct Job
+  {
+    std::string           label;
+    std::function<bool()> task;
+  };
+
+  static bool execute(const std::string &label, const std::function<bool()> &task);
+
+  void record(const std::string &label, bool success); // lock must be held
+  void worker_loop();
+
+  std::vector<std::thread>   workers; // started on first submit
+  size_t                     nthreads;
+  std::deque<std::string>    order;   // keys of the queued jobs, FIFO
+  std::map<std::string, Job> queued;  // one job per key
+  std::set<std::string>      running; // keys being written
+  ExportReport               report;
+  mutable std::mutex         mutex;
+  std::condition_variable    cv_job;
+  std::condition_variable    cv_done;
+  bool                       stop = false;
+  std::atomic<bool>          synchronous = false;
+};
+
+} // namespace hesiod
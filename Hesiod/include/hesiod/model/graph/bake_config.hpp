@@ -4,6 +4,8 @@
 
 #include "nlohmann/json.hpp"
 
+#include "highmap/algebra.hpp"
+
 namespace hesiod
 {
 
@@ -31,4 +33,11 @@ void override_export_nodes_settings(const std::string           &fname,
                                     unsigned int                 random_seeds_increment,
                                     const BakeConfig            &bake_settings);
 
+// rough memory footprint of a batch computation at the given heightmap shape
+size_t estimate_batch_memory(const glm::ivec2 &shape);
+
+// number of variants baked concurrently, bounded by the CPU cores (each bake computes
+// its tiles in parallel) and by the available memory, estimated from the resolution
+int get_bake_worker_count(const BakeConfig &bake_settings);
+
 } // namespace hesiod
\ No newline at end of file
@@ -0,0 +1,67 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace hesiod
+{
+
+class GraphNode; // forward
+
+// =====================================
+// GraphEvaluator
+// =====================================
+
+// runs the updates of a GraphNode on a background thread. Requests are merged and a
+// new request cancels the in-flight evaluation when both share nodes, the cancelled
+// roots are evaluated again with the new request (latest edit wins)
+class GraphEvaluator
+{
+public:
+  GraphEvaluator() = delete;
+  explicit GraphEvaluator(GraphNode *p_graph_node);
+  ~GraphEvaluator();
+
+  GraphEvaluator(const GraphEvaluator &) = delete;
+  GraphEvaluator &operator=(const GraphEvaluator &) = delete;
+
+  // --- Requests ---
+  void request_update(const std::string &node_id = ""); // empty id: whole graph
+  void cancel();
+
+  // cancel the in-flight evaluation (its roots are kept pending) and prevent any new
+  // evaluation from starting until the returned lock is released, to be used before
+  // modifying the graph structure
+  std::unique_lock<std::recursive_mutex> suspend();
+
+  // same if no evaluation is in flight, no lock otherwise
+  std::unique_lock<std::recursive_mutex> try_suspend();
+
+  // --- State ---
+  bool        is_busy() const;
+  static bool is_worker_thread(); // true when called from an evaluation thread
+
+private:
+  void worker_loop();
+
+  GraphNode              *p_graph_node; // owner
+  std::thread             worker;
+  mutable std::mutex      mutex;
+  std::recursive_mutex    run_mutex; // held during an evaluation
+  std::condition_variable cv;
+  std::set<std::string>   pending_ids;
+  std::set<std::string>   running_ids;
+  std::set<std::string>   running_roots;
+  bool                    full_update_pending = false;
+  bool                    full_update_running = false;
+  bool                    busy = false;
+  bool                    stop = false;
+  std::atomic<bool>       cancel_flag = false;
+};
+
+} // namespace hesiod
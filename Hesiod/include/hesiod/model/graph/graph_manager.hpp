@@ -12,7 +12,8 @@
 namespace hesiod
 {
 
-class GraphNode; // forward
+class ExportQueue; // forward
+class GraphNode;   // forward
 class GraphConfig;
 
 // =====================================
@@ -41,6 +42,10 @@ public:
   void set_graph_order(const std::vector<std::string> &new_graph_order);
   void set_id(const std::string &new_id);
 
+  // queue of the exports of all the graphs, not owned (nullptr for the application
+  // queue). To be set before the graphs are loaded
+  void set_p_export_queue(ExportQueue *new_p_export_queue);
+
   // --- GraphNode management ---
   std::string add_graph_node(const std::shared_ptr<GraphNode> &p_graph_node,
                              const std::string                &graph_id = "");
@@ -78,6 +83,7 @@ private:
   std::vector<std::string> graph_order;
   BroadcastMap             broadcast_params;
   FlattenConfig            export_param;
+  ExportQueue             *p_export_queue = nullptr;
 };
 
 } // namespace hesiod
@@ -1,7 +1,10 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General Public
    License. The full license is in the file LICENSE, distributed with this software. */
 #pragma once
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
 
 #include "nlohmann/json.hpp"
 
@@ -10,11 +13,15 @@
 
 #include "hesiod/model/graph/broadcast_param.hpp"
 #include "hesiod/model/graph/graph_config.hpp"
+#include "hesiod/model/nodes/preview_pyramid.hpp"
+#include "hesiod/model/nodes/tile_dirty_tracker.hpp"
 
 namespace hesiod
 {
 
-class BaseNode; // forward
+class BaseNode;       // forward
+class ExportQueue;    // forward
+class GraphEvaluator; // forward
 
 // =====================================
 // GraphNode
@@ -26,6 +33,7 @@ class GraphNode : public gnode::Graph,
 public:
   GraphNode() = delete;
   GraphNode(const std::string &id, const std::shared_ptr<GraphConfig> &config);
+  ~GraphNode();
 
   std::shared_ptr<GraphNode> get_shared();
 
@@ -47,11 +55,29 @@ public:
   void         update() override;
   void         update(const std::string &node_id) override;
 
+  // --- Asynchronous update ---
+
+  // background update (when enabled in the settings, synchronous update otherwise), a
+  // new request supersedes the in-flight evaluation of the same nodes
+  void request_update(const std::string &node_id = "");
+  void cancel_async_update();
+
+  // blocks until the in-flight background evaluation is stopped, no evaluation can
+  // start until the lock is released (required before modifying the graph structure)
+  std::unique_lock<std::recursive_mutex> suspend_async_update();
+
+  // same without cancelling the in-flight evaluation, false (and no lock) if there is
+  // one (for short reads of the node data from the GUI)
+  bool try_suspend_async_update(std::unique_lock<std::recursive_mutex> &lock);
+
   // --- Inter-graph Broadcasting ---
   BroadcastMap *get_p_broadcast_params() { return this->p_broadcast_params; }
   void          set_p_broadcast_params(BroadcastMap *new_p_broadcast_params);
   void          on_broadcast_node_updated(const std::string &tag);
 
+  // --- Exports ---
+  void set_p_export_queue(ExportQueue *new_p_export_queue); // nullptr, application queue
+
   // --- Others... ---
   void reseed(bool backward);
 
@@ -75,12 +101,36 @@ public:
 
 private:
   // --- Helpers ---
-  void setup_new_broadcast_node(BaseNode *p_node);
-  void setup_new_receive_node(BaseNode *p_node);
+  std::vector<std::string> get_downstream_node_ids(const std::string &node_id) const;
+  std::vector<std::string> get_upstream_node_ids(
+      const std::vector<std::string> &node_ids) const;
+  uint64_t                 get_upstream_hash(const std::string &node_id,
+                                             int                port_index) const;
+  const TileHashes        *get_upstream_tile_hashes(const std::string &node_id,
+                                                    int                port_index) const;
+  std::shared_ptr<const PreviewPyramid> get_upstream_preview_pyramid(
+      const std::string &node_id,
+      int                port_index) const;
+  void                     setup_new_broadcast_node(BaseNode *p_node);
+  void                     setup_new_receive_node(BaseNode *p_node);
+  std::shared_lock<std::shared_mutex> try_lock_upstream_data(const std::string &node_id,
+                                                             int port_index) const;
+  bool                     update_parallel(const std::vector<std::string> &node_ids,
+                                           const std::atomic<bool> *p_cancel = nullptr);
+
+  // coarse evaluation of the nodes and the nodes feeding them, published right away, then
+  // full resolution evaluation of the nodes
+  bool update_progressive(const std::vector<std::string> &node_ids,
+                          const std::atomic<bool>        *p_cancel = nullptr);
+
+  friend class GraphEvaluator;
 
   // --- Members ---
-  std::shared_ptr<GraphConfig> config;
-  BroadcastMap                *p_broadcast_params = nullptr; // own by GraphManager
+  std::shared_ptr<GraphConfig>    config;
+  BroadcastMap                   *p_broadcast_params = nullptr; // own by GraphManager
+  ExportQueue                    *p_export_queue = nullptr;     // see GraphManager
+  std::atomic<bool>               is_scheduling = false; // callbacks emitted by scheduler
+  std::unique_ptr<GraphEvaluator> evaluator; // created on the first async request
 };
 
 } // namespace hesiod
@@ -2,9 +2,13 @@
    License. The full license is in the file LICENSE, distributed with this software. */
 #pragma once
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <functional>
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <utility>
 
@@ -15,6 +19,9 @@
 
 #include "hesiod/model/graph/graph_config.hpp"
 #include "hesiod/model/nodes/node_runtime_info.hpp"
+#include "hesiod/model/nodes/preview_pyramid.hpp"
+#include "hesiod/model/nodes/region_query.hpp"
+#include "hesiod/model/nodes/tile_dirty_tracker.hpp"
 
 // clang-format off
 #define CONFIG(obj) obj.get_config_ref()->shape, obj.get_config_ref()->tile_shape, obj.get_config_ref()->halo, obj.get_config_ref()->storage_mode
@@ -24,7 +31,9 @@
 namespace hesiod
 {
 
-class GraphNode; // forward
+class ExportQueue;         // forward
+class GraphNode;           // forward
+struct NodeOutputsBackup; // forward
 
 // helper
 std::string map_type_name(const std::string &typeid_name);
@@ -38,6 +47,7 @@ public:
   // --- Constructors ---
   BaseNode() = default;
   BaseNode(const std::string &label, std::weak_ptr<GraphConfig> config);
+  ~BaseNode();
 
   std::shared_ptr<BaseNode> get_shared();
 
@@ -46,6 +56,12 @@ public:
   std::shared_ptr<const GraphConfig> get_config_ref() const;
   void                               propagate_config_change();
 
+  // transient configuration (progressive update, owned by the caller), the outputs are
+  // reallocated right away or, if 'deferred', at the beginning of the next compute so
+  // that the current outputs remain readable until they are replaced
+  void set_config_ref(std::weak_ptr<GraphConfig> new_config, bool deferred = false);
+  void apply_pending_config(); // reallocates now if a deferred config is pending
+
   // --- Runtime info ---
   NodeRuntimeInfo get_runtime_info() const;
   float           get_memory_usage() const;
@@ -61,6 +77,44 @@ public:
   // --- Compute ---
   void compute() override;
   void set_compute_fct(std::function<void(BaseNode &node)> new_compute_fct);
+  void set_compute_failed(); // by the compute function, outputs invalid as if cancelled
+
+  // --- Cancellation (set by the graph scheduler, can be checked between tiles) ---
+  bool is_cancelled() const;
+  void set_cancel_flag(const std::atomic<bool> *new_p_cancel_flag);
+
+  // --- Content hash (node type, attributes, config and upstream hashes) ---
+  uint64_t compute_hash(); // 0 if the outputs cannot be identified
+  uint64_t get_output_hash() const;
+
+  // --- Tile-level incremental update (only the tiles affected by an upstream change
+  // are recomputed when the node has a tile-local dependency) ---
+  TileDependency    get_tile_dependency() const;
+  void              set_tile_dependency(TileDependency new_tile_dependency);
+  const TileHashes *get_output_tile_hashes(int port_index) const;
+  bool              is_tile_dirty(const hmap::TileRegion &region) const;
+  void              add_computed_tile() const; // see TileSpan, for the runtime info
+  void              add_tile_cpu_time(int64_t ns) const; // idem, ignored on node thread
+
+  // --- Read access to the data of a port from another thread (GUI). Not granted while
+  // the data is being computed or if its compute was cancelled, input ports lock the
+  // upstream node ---
+  std::shared_lock<std::shared_mutex> try_lock_data(int port_index) const;
+
+  // --- Preview pyramid of a heightmap port (built on the first request after each
+  // compute; input ports read the one of the upstream output). nullptr if not a
+  // heightmap or if the data is being computed ---
+  std::shared_ptr<const PreviewPyramid> get_preview_pyramid(int port_index);
+
+  // --- Region queries on a heightmap port (full resolution data, only the tiles
+  // overlapping the queries are read, in a single pass). False if not a heightmap, if
+  // the data is being computed or if the graph is being evaluated ---
+  bool query_probe(int port_index, RegionProbe &probe);
+
+  // --- Outputs backup (keeps the resolution-dependent outputs and their hash while the
+  // node is evaluated with a transient configuration) ---
+  void backup_outputs();
+  void restore_outputs(); // to be called after the configuration has been restored
 
   // --- Serialization ---
   virtual void           json_from(nlohmann::json const &json);
@@ -113,17 +167,69 @@ public:
   std::function<void(const std::string &id)> compute_finished;
   std::function<void(const std::string &id)> compute_started;
 
+  // --- Upstream data hash for an input port (0 if unknown), set by the GraphNode
+  std::function<uint64_t(int port_index)> get_upstream_hash;
+
+  // --- Upstream tile hashes for an input port (nullptr if unknown), set by the GraphNode
+  std::function<const TileHashes *(int port_index)> get_upstream_tile_hashes;
+
+  // --- Upstream preview pyramid for an input port (nullptr if unknown), set by the
+  // GraphNode
+  std::function<std::shared_ptr<const PreviewPyramid>(int port_index)>
+      get_upstream_preview_pyramid;
+
+  // --- Read access to the upstream data of an input port (not granted if unknown), set
+  // by the GraphNode
+  std::function<std::shared_lock<std::shared_mutex>(int port_index)>
+      try_lock_upstream_data;
+
+  // --- Queue of the exports of the node (application queue if unknown), set by the
+  // GraphNode
+  std::function<ExportQueue &()> get_export_queue;
+
+  // --- Suspension of the background evaluation of the graph, only if it is idle (see
+  // GraphNode::try_suspend_async_update), set by the GraphNode
+  std::function<bool(std::unique_lock<std::recursive_mutex> &lock)>
+      try_suspend_async_update;
+
 private:
+#ifdef HESIOD_DEBUG_CHECKS
+  void check_partial_update(); // compare with a full recompute
+#endif
+  uint64_t compute_parameters_hash() const; // node type, attributes and config
+  size_t   count_tiles_to_compute() const;
+  void     reallocate_outputs();  // data lock must be held
+  bool     swap_pending_config(); // true if a deferred config was pending
+
   // --- Members ---
   std::map<std::string, std::unique_ptr<attr::AbstractAttribute>> attr = {};
 
   std::vector<std::string>            attr_ordered_key = {};
   std::string                         category;
   std::string                         comment;
-  std::weak_ptr<GraphConfig>          config; // owned by GraphNode
+  std::weak_ptr<GraphConfig>          config;         // owned by GraphNode
+  std::weak_ptr<GraphConfig>          pending_config; // see set_config_ref
+  mutable std::mutex                  config_mutex;
   nlohmann::json                      documentation;
   NodeRuntimeInfo                     runtime_info;
   std::function<void(BaseNode &node)> compute_fct = nullptr;
+  const std::atomic<bool>            *p_cancel_flag = nullptr; // owned by the scheduler
+  uint64_t                            output_hash = 0;
+  TileDependency                      tile_dependency = TileDependency::TDP_GLOBAL;
+  TileDirtyTracker                    tile_tracker;
+  std::unique_ptr<NodeOutputsBackup>  outputs_backup;
+  mutable std::shared_mutex           data_mutex;             // held while computing
+  std::atomic<bool>                   is_data_valid = true;   // false if cancelled/failed
+  mutable std::atomic<size_t>         ntiles_computed = 0;    // during the last compute
+  mutable std::atomic<int64_t>        tiles_cpu_time = 0;     // ns, other threads, idem
+  std::thread::id                     compute_thread;         // during the last compute
+  std::atomic<bool>                   compute_failed = false; // see set_compute_failed
+
+  std::map<int, std::shared_ptr<const PreviewPyramid>> preview_pyramids;
+  std::mutex                                           preview_pyramids_mutex;
+
+  std::map<int, RegionTileCache> region_caches; // tiles read by the probes, per port
+  std::mutex                     region_caches_mutex;
 };
 
 // =====================================
@@ -152,6 +258,7 @@ enum ExportFormat : int
   PNG8BIT,
   PNG16BIT,
   RAW16BIT,
+  TIFF32BIT,
 };
 
 enum MaskCombineMethod : int
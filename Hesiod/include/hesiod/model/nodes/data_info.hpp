@@ -16,15 +16,28 @@ namespace hesiod
 
 template <typename T> std::string get_data_info(BaseNode *node, const std::string &key)
 {
+  // not readable while being computed (heightmaps are read through their preview
+  // pyramid)
+  std::shared_lock<std::shared_mutex> data_lock;
+
+  if constexpr (!std::is_same_v<T, hmap::VirtualArray>)
+  {
+    data_lock = node->try_lock_data(node->get_port_index(key));
+    if (!data_lock.owns_lock())
+      return "-";
+  }
+
   auto *p_val = node->get_value_ref<T>(key);
   if (!p_val)
     return "-";
 
   if constexpr (std::is_same_v<T, hmap::VirtualArray>)
   {
-    return std::format("[{:.2e}, {:.2e}]",
-                       p_val->min(node->cfg().cm_cpu),
-                       p_val->max(node->cfg().cm_cpu));
+    auto sp_pyramid = node->get_preview_pyramid(node->get_port_index(key));
+    if (!sp_pyramid)
+      return "-";
+
+    return std::format("[{:.2e}, {:.2e}]", sp_pyramid->get_min(), sp_pyramid->get_max());
   }
   else if constexpr (std::is_same_v<T, hmap::VirtualTexture>)
   {
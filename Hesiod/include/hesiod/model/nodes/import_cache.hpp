@@ -0,0 +1,83 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "highmap/array.hpp"
+#include "highmap/tensor.hpp"
+
+#include "hesiod/model/nodes/raster_source.hpp"
+
+namespace hesiod
+{
+
+// =====================================
+// ImportCache
+// =====================================
+
+// decoded image files of the Import* nodes, shared by all the graphs (and by the jobs of
+// the batch queue mode) so that a file used by several nodes or projects is decoded
+// once. Entries are identified by the file path, its modification time and the decoding
+// options, and evicted in least-recently-used order beyond the memory budget
+class ImportCache
+{
+public:
+  ImportCache() = default;
+
+  ImportCache(const ImportCache &) = delete;
+  ImportCache &operator=(const ImportCache &) = delete;
+
+  // decode the file on a cache miss, nullptr if the file cannot be read
+  std::shared_ptr<const hmap::Array>  get_array(const std::filesystem::path &fname,
+                                                bool                         flip_y);
+  std::shared_ptr<const hmap::Tensor> get_tensor(const std::filesystem::path &fname,
+                                                 bool                         flip_y);
+
+  // supported TIFF files are memory-mapped (the mapped size is counted in the budget)
+  // and only the windows being read are decoded, the other formats are decoded whole
+  std::shared_ptr<const RasterSource> get_raster(const std::filesystem::path &fname,
+                                                 bool                         flip_y);
+
+  void clear();
+
+  // --- Budget ---
+  size_t get_budget() const;
+  void   set_budget(size_t new_budget_bytes);
+
+  // --- Stats ---
+  size_t get_memory_usage() const;
+  size_t get_nhits() const;
+  size_t get_nmisses() const;
+
+private:
+  struct Entry
+  {
+    std::shared_ptr<const hmap::Array>  array;
+    std::shared_ptr<const hmap::Tensor> tensor;
+    std::shared_ptr<const RasterSource> raster;
+    size_t                              bytes = 0;
+    std::list<std::string>::iterator    lru_it;
+  };
+
+  std::string get_key(const std::filesystem::path &fname,
+                      bool                         flip_y,
+                      const std::string           &kind) const; // empty if no file
+  Entry      *find(const std::string &key);                     // lock must be held
+  void        insert(const std::string &key, Entry &&entry);    // lock must be held
+  void        evict();                                          // lock must be held
+
+  std::map<std::string, Entry> entries;
+  std::list<std::string>       lru; // most recently used first
+  mutable std::mutex           mutex;
+  size_t                       budget = 512ULL * 1024ULL * 1024ULL; // bytes
+  size_t                       memory_usage = 0;
+  size_t                       nhits = 0;
+  size_t                       nmisses = 0;
+};
+
+} // namespace hesiod
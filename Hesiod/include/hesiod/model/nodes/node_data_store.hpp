@@ -0,0 +1,72 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <set>
+
+namespace hesiod
+{
+
+class BaseNode;     // forward
+class ProjectModel; // forward
+
+// =====================================
+// NodeDataStore
+// =====================================
+
+// optional sidecar of a project file (<project>.hsd.data/ directory) holding the
+// computed node outputs, so that a project can be reopened without recomputing its
+// graphs. One file per node output set, named after the node hash (see
+// BaseNode::compute_hash): a node is restored only if its parameters and inputs match
+// the ones the data was computed with.
+//
+// Heightmaps and textures are stored as a grid of chunks (one per tile, optionally
+// deflate-compressed) preceded by a chunk table, clouds and paths as plain arrays. The
+// files are memory-mapped on restore and each tile only decodes the chunks it
+// overlaps. The restore itself is not lazy: hmap::VirtualArray has no hook to load a
+// tile on its first access, so all the chunks are decoded into the node outputs when
+// the node is restored (the storage mode of the outputs, e.g. on disk, is unchanged)
+class NodeDataStore
+{
+public:
+  NodeDataStore() = default;
+
+  NodeDataStore(const NodeDataStore &) = delete;
+  NodeDataStore &operator=(const NodeDataStore &) = delete;
+
+  // --- Project binding (empty file name to detach) ---
+  void                  attach(const std::filesystem::path &project_fname);
+  std::filesystem::path get_dir() const;
+
+  bool restore(uint64_t key, BaseNode &node); // true if restored
+  bool save(uint64_t key, BaseNode &node, bool compress);
+
+  // store the outputs of all the computed (and up to date) nodes of the project, and
+  // remove the files of the nodes that no longer exist or changed since the last save.
+  // Background evaluations are suspended meanwhile
+  void save_project(ProjectModel &project, bool compress);
+
+  // --- Stats ---
+  size_t get_nrestored() const;
+
+  static std::filesystem::path get_dir(const std::filesystem::path &project_fname);
+  static bool                  is_storable(const BaseNode &node);
+
+  // --- Single file access (also used by the node output cache) ---
+  static bool read_file(const std::filesystem::path &path, uint64_t key, BaseNode &node);
+  static bool write_file(const std::filesystem::path &path,
+                         uint64_t                     key,
+                         BaseNode                    &node,
+                         bool                         compress);
+
+private:
+  std::filesystem::path get_entry_path(uint64_t key) const; // empty if detached
+
+  std::filesystem::path dir;
+  mutable std::mutex    mutex;
+  size_t                nrestored = 0;
+};
+
+} // namespace hesiod
@@ -109,6 +109,7 @@ DECLARE_NODE(export_as_cubemap)
 DECLARE_NODE(export_asset)
 DECLARE_NODE(export_cloud)
 DECLARE_NODE(export_cloud_to_ply)
+DECLARE_NODE(export_lod_pyramid)
 DECLARE_NODE(export_normal_map)
 DECLARE_NODE(export_path)
 DECLARE_NODE(export_points_to_ply)
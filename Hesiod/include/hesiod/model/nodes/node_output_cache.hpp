@@ -0,0 +1,99 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "highmap/virtual_array/virtual_array.hpp"
+
+namespace hesiod
+{
+
+class BaseNode; // forward
+
+// =====================================
+// NodeOutputCache
+// =====================================
+
+// content-addressed storage of node outputs, the key is the node hash (see
+// BaseNode::compute_hash). Only nodes with heightmap outputs are stored, the copies use
+// the graph storage mode (disk-backed LRU tiles by default) and whole entries are
+// evicted in least-recently-used order when the memory budget is exceeded.
+//
+// Entries can also be persisted to a cache directory (one file per entry in the
+// NodeDataStore format, shared between GUI sessions and batch runs), evicted by last
+// access time when the disk budget is exceeded. The directory is scanned once, when it
+// is set, the entries are then tracked in memory. Disk hits are promoted to memory
+class NodeOutputCache
+{
+public:
+  NodeOutputCache() = default;
+
+  NodeOutputCache(const NodeOutputCache &) = delete;
+  NodeOutputCache &operator=(const NodeOutputCache &) = delete;
+
+  bool restore(uint64_t key, BaseNode &node); // true on cache hit
+  void store(uint64_t key, BaseNode &node);
+  void clear();
+
+  // --- Budget ---
+  size_t get_budget() const;
+  void   set_budget(size_t new_budget_bytes);
+
+  // --- Persistent storage (empty directory to disable) ---
+  std::filesystem::path get_disk_path() const;
+  void set_disk_storage(const std::filesystem::path &new_dir, size_t new_budget_bytes);
+
+  // --- Stats ---
+  size_t get_memory_usage() const;
+  size_t get_nentries() const;
+  size_t get_nhits() const;
+  size_t get_nmisses() const;
+  size_t get_ndisk_hits() const;
+
+  static bool is_cacheable(const BaseNode &node);
+
+private:
+  struct Entry
+  {
+    std::vector<std::shared_ptr<hmap::VirtualArray>> outputs; // OUT ports order
+    size_t                                           bytes = 0;
+    std::list<uint64_t>::iterator                    lru_it;
+  };
+
+  struct DiskEntry
+  {
+    size_t                          bytes = 0;
+    std::filesystem::file_time_type last_access;
+  };
+
+  void evict(); // lock must be held
+
+  std::filesystem::path get_entry_path(uint64_t key) const; // empty if disabled
+  void                  evict_disk(); // disk lock must be held
+  bool                  load_from_disk(uint64_t key, BaseNode &node);
+  void                  save_to_disk(uint64_t key, BaseNode &node);
+  void                  store_in_memory(uint64_t key, BaseNode &node);
+
+  std::map<uint64_t, Entry>     entries;
+  std::list<uint64_t>           lru; // most recently used first
+  mutable std::mutex            mutex;
+  size_t                        budget = 1024ULL * 1024ULL * 1024ULL; // bytes
+  size_t                        memory_usage = 0;
+  size_t                        nhits = 0;
+  size_t                        nmisses = 0;
+  size_t                        ndisk_hits = 0;
+  std::filesystem::path         disk_dir;        // versioned sub-directory
+  std::mutex                    disk_mutex;      // serializes the disk accesses below
+  std::filesystem::path         requested_dir;   // as provided by the settings
+  size_t                        disk_budget = 0; // bytes
+  std::map<uint64_t, DiskEntry> disk_entries;
+  size_t                        disk_usage = 0; // bytes
+};
+
+} // namespace hesiod
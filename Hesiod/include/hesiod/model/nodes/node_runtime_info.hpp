@@ -2,6 +2,7 @@
    License. The full license is in the file LICENSE, distributed with this software. */
 #pragma once
 #include <chrono>
+#include <cstdint>
 #include <string>
 
 #include "nlohmann/json.hpp"
@@ -23,10 +24,21 @@ struct NodeRuntimeInfo
   float                                 update_time;
   size_t                                eval_count = 0;
 
+  // last update profile (not serialized). Memory figures are process-wide and include
+  // the nodes computed concurrently
+  float  post_process_time = 0.f; // ms, pre/post-processing part of update_time
+  size_t ntiles = 0;              // heightmap tiles computed
+  float  rss_delta = 0.f;         // MB, process resident memory
+  float  peak_rss_delta = 0.f;    // MB, growth of the process high-water mark
+  float  cpu_utilization = 0.f;   // node and tile threads CPU time / wall time
+
   virtual void           json_from(nlohmann::json const &json);
   virtual nlohmann::json json_to() const;
 
   std::chrono::steady_clock::time_point timer_t0;
+  size_t                                rss0 = 0;
+  size_t                                peak_rss0 = 0;
+  int64_t                               cpu0 = 0; // ns
 };
 
 } // namespace hesiod
\ No newline at end of file
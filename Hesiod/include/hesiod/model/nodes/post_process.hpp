@@ -1,8 +1,11 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General Public
    License. The full license is in the file LICENSE, distributed with this software. */
 #pragma once
+#include <filesystem>
+#include <functional>
 
 #include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/streaming_export.hpp"
 
 namespace hesiod
 {
@@ -87,4 +90,26 @@ void generate_map(BaseNode            &node,
                   hmap::VirtualArray  &map,
                   DefaultMapOptions   &options);
 
+// --- asynchronous export
+
+// deep copies of the node inputs for the export tasks (the graph may update the inputs
+// while the file is being written), or plain references when exports are synchronous
+std::shared_ptr<hmap::VirtualArray> snapshot_heightmap(BaseNode                 &node,
+                                                       const hmap::VirtualArray &array);
+std::shared_ptr<hmap::VirtualTexture> snapshot_texture(
+    BaseNode                   &node,
+    const hmap::VirtualTexture &texture);
+
+// hands the export to the export queue of the node, written in the background, or runs
+// it right away if asynchronous exports are disabled or if the queue is synchronous.
+// The task returns false on failure, failures are reported by the queue in both cases
+void submit_export(BaseNode                    &node,
+                   const std::filesystem::path &fname,
+                   std::function<bool()>        task);
+
+// --- tiled export (tiling, leading zeros, overlapping edges and y-indexing)
+
+TiledExportLayout get_tiled_export_layout(BaseNode &node);
+void              setup_tiled_export_attributes(BaseNode &node);
+
 } // namespace hesiod
@@ -0,0 +1,51 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "highmap/virtual_array/virtual_array.hpp"
+
+namespace hesiod
+{
+
+// =====================================
+// PreviewPyramid
+// =====================================
+
+// reduced copies of a heightmap (mip levels of 1024, 512, 256 and 128 cells along the
+// largest side, with the aspect ratio of the heightmap) and its value range, built in a
+// single parallel pass over the tiles. Previews, histograms and data info read from it
+// instead of the full resolution data
+class PreviewPyramid
+{
+public:
+  PreviewPyramid() = default;
+
+  // nullptr if the heightmap is empty
+  static std::shared_ptr<const PreviewPyramid> build(hmap::VirtualArray      &array,
+                                                     const glm::ivec2        &tile_shape,
+                                                     const hmap::ComputeMode &cm);
+
+  // resampled from the coarsest level at least as fine as 'shape'
+  hmap::Array        get_array(const glm::ivec2 &shape) const;
+  const hmap::Array &get_level(int resolution) const; // largest side >= resolution
+
+  // cell count of each of the 'nbins' bins over [min, max], from the 256 level
+  std::vector<float> get_histogram(int nbins) const;
+
+  float      get_max() const;
+  float      get_min() const;
+  glm::ivec2 get_source_shape() const;
+
+  static constexpr int max_resolution = 1024;
+  static constexpr int min_resolution = 128;
+
+private:
+  std::vector<hmap::Array> levels; // finest first
+  float                    vmin = 0.f;
+  float                    vmax = 0.f;
+  glm::ivec2               source_shape = {0, 0};
+};
+
+} // namespace hesiod
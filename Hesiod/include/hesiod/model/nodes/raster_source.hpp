@@ -0,0 +1,103 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "highmap/array.hpp"
+
+class QFile; // forward
+
+namespace hesiod
+{
+
+// =====================================
+// RasterSource
+// =====================================
+
+// read access to the pixels of an imported single channel image, index j increasing
+// from the image bottom when 'flip_y' is set (as hmap::Array images). Windows can be
+// read concurrently
+class RasterSource
+{
+public:
+  virtual ~RasterSource() = default;
+
+  glm::ivec2 get_shape() const;
+
+  // pixels of the window (first pixel 'ij0'), the window must lie within the image
+  virtual bool read_window(const glm::ivec2 &ij0,
+                           const glm::ivec2 &shape,
+                           hmap::Array      &out) const = 0;
+
+  // resamples the image to a grid of shape 'shape' and fills 'tile', the part of the
+  // grid starting at 'ij0' (indices outside the grid are clamped, e.g. tile halos).
+  // Only the source window covered by the tile is read
+  bool resample(const glm::ivec2 &ij0,
+                const glm::ivec2 &shape,
+                bool              bicubic,
+                hmap::Array      &tile) const;
+
+protected:
+  glm::ivec2 shape = {0, 0};
+};
+
+// decoded image, for the formats which cannot be read partially
+class ArrayRasterSource : public RasterSource
+{
+public:
+  explicit ArrayRasterSource(std::shared_ptr<const hmap::Array> array);
+
+  bool read_window(const glm::ivec2 &ij0,
+                   const glm::ivec2 &shape,
+                   hmap::Array      &out) const override;
+
+private:
+  std::shared_ptr<const hmap::Array> array;
+};
+
+// memory-mapped TIFF file (classic or BigTIFF, little endian, strips or tiles, 8/16 bit
+// unsigned or 32 bit float samples, uncompressed or deflate with the horizontal or
+// floating point predictors): a window only decodes the strips or tiles it overlaps.
+// Integer samples are normalized to [0, 1]
+class MappedTiffSource : public RasterSource
+{
+public:
+  ~MappedTiffSource() override;
+
+  // nullptr if the file is not a TIFF file supported by this reader
+  static std::shared_ptr<MappedTiffSource> open(const std::filesystem::path &fname,
+                                                bool                         flip_y);
+
+  bool read_window(const glm::ivec2 &ij0,
+                   const glm::ivec2 &shape,
+                   hmap::Array      &out) const override;
+
+  size_t get_mapped_size() const; // in bytes
+
+private:
+  MappedTiffSource() = default;
+
+  // raw samples of the block, in 'buffer' if decompressed, nullptr on error
+  const uint8_t *get_block(size_t                block_index,
+                           int                   nrows,
+                           std::vector<uint8_t> &buffer) const;
+  float          get_sample(const uint8_t *p) const;
+
+  std::unique_ptr<QFile> file;
+  const uint8_t         *p_data = nullptr;
+  size_t                 size = 0;
+  bool                   flip_y = true;
+  bool                   tiled = false;
+  int                    bits_per_sample = 8;
+  int                    sample_format = 1; // 1: unsigned integer, 3: float
+  int                    compression = 1;   // 1: none, 8: deflate
+  int                    predictor = 1;
+  glm::ivec2             block_shape;       // tile, or strip (image width x rows)
+  glm::ivec2             nblocks;
+  std::vector<uint64_t>  offsets;
+  std::vector<uint64_t>  byte_counts;
+};
+
+} // namespace hesiod
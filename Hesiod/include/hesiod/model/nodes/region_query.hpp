@@ -0,0 +1,108 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <map>
+#include <vector>
+
+#include "highmap/virtual_array/virtual_array.hpp"
+
+namespace hesiod
+{
+
+// =====================================
+// Region queries
+// =====================================
+
+// full resolution reads of a part of a heightmap, without a dense copy of it. The tiles
+// owning the queried cells are selected from the tile grid beforehand and the tile data
+// is never written. HighMap only exposes the tiles through hmap::for_each_tile, which
+// fetches every tile (from disk with the VA_DISK_LRU storage): the interiors of the
+// selected tiles are kept in a RegionTileCache, if provided, and a pass over the tiles
+// only happens when a selected tile is not cached. Unit coordinates map [0, 1] to the
+// first and last cells
+
+// interiors of the tiles read by the previous queries (e.g. probes following the
+// cursor), least recently used ones dropped first. To be cleared when the data changes
+class RegionTileCache
+{
+public:
+  explicit RegionTileCache(size_t max_bytes = 64 * 1024 * 1024);
+
+  void clear();
+
+  // nullptr if not cached, 'ij0' is the global index of the first interior element
+  const hmap::Array *get(const glm::ivec2 &tile_index, glm::ivec2 &ij0);
+  void               store(const glm::ivec2 &tile_index,
+                           const glm::ivec2 &ij0,
+                           hmap::Array     &&interior);
+
+private:
+  struct Entry
+  {
+    glm::ivec2  ij0;
+    hmap::Array interior;
+    size_t      last_use = 0;
+  };
+
+  std::map<std::pair<int, int>, Entry> entries;
+  size_t                               max_bytes;
+  size_t                               nbytes = 0;
+  size_t                               counter = 0;
+};
+
+// batched queries, read in a single pass over the tiles
+struct RegionProbe
+{
+  // value
+  glm::vec2 p = {0.f, 0.f};
+
+  // window {xmin, xmax, ymin, ymax}, both ends included, point-sampled to 'window_shape'
+  // (not queried if empty)
+  glm::vec4  bbox = {0.f, 1.f, 0.f, 1.f};
+  glm::ivec2 window_shape = {0, 0};
+
+  // profile, not queried if there are no samples
+  glm::vec2 p0 = {0.f, 0.f};
+  glm::vec2 p1 = {1.f, 0.f};
+  int       nsamples = 0;
+
+  // results
+  float              value = 0.f;
+  hmap::Array        window;
+  std::vector<float> profile;
+};
+
+// cells of the window [ij0, ij0 + window_shape) (clamped to the heightmap),
+// point-sampled to 'shape_out' (corners of the window are kept)
+hmap::Array query_region(hmap::VirtualArray      &array,
+                         const glm::ivec2        &ij0,
+                         const glm::ivec2        &window_shape,
+                         const glm::ivec2        &shape_out,
+                         const glm::ivec2        &tile_shape,
+                         const hmap::ComputeMode &cm,
+                         RegionTileCache         *p_cache = nullptr);
+
+// 'nsamples' values, bilinearly interpolated, evenly spaced on the segment [p0, p1]
+std::vector<float> query_profile(hmap::VirtualArray      &array,
+                                 const glm::vec2         &p0,
+                                 const glm::vec2         &p1,
+                                 int                      nsamples,
+                                 const glm::ivec2        &tile_shape,
+                                 const hmap::ComputeMode &cm,
+                                 RegionTileCache         *p_cache = nullptr);
+
+// bilinearly interpolated value at 'p'
+float query_value(hmap::VirtualArray      &array,
+                  const glm::vec2         &p,
+                  const glm::ivec2        &tile_shape,
+                  const hmap::ComputeMode &cm,
+                  RegionTileCache         *p_cache = nullptr);
+
+// value, window and profile of the probe
+void query_probe(hmap::VirtualArray      &array,
+                 RegionProbe             &probe,
+                 const glm::ivec2        &tile_shape,
+                 const hmap::ComputeMode &cm,
+                 RegionTileCache         *p_cache = nullptr);
+
+} // namespace hesiod
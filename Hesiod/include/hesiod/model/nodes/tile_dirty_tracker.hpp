@@ -0,0 +1,71 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <cstdint>
+#include <map>
+#include <set>
+
+#include "highmap/virtual_array/virtual_array.hpp"
+
+namespace hesiod
+{
+
+class BaseNode; // forward
+
+// how the tiles of the outputs depend on the tiles of the inputs
+enum TileDependency : int
+{
+  TDP_GLOBAL, // any input change requires a full recompute (default)
+  TDP_TILE,   // an output tile only depends on the same input tile
+  TDP_HALO,   // an output tile depends on the same input tile and its neighbors
+};
+
+// content hash of each tile of a heightmap, indexed by tile key
+using TileHashes = std::map<size_t, uint64_t>;
+
+// =====================================
+// TileDirtyTracker
+// =====================================
+
+// keeps track of the tiles of a node outputs that changed during the last compute.
+// Each output tile is identified by a hash of its content, a downstream node compares
+// these hashes with the ones it consumed during its previous compute to find the input
+// tiles that changed (the 'dirty' tiles). Nodes with a tile-local dependency can then
+// only recompute the dirty tiles, the other tiles of their outputs being still valid
+class TileDirtyTracker
+{
+public:
+  TileDirtyTracker() = default;
+
+  // to be called before the node compute, decide whether a partial update is possible
+  void begin_update(BaseNode &node, uint64_t parameters_hash);
+
+  // to be called after the node compute, 'completed' is false if the compute was
+  // interrupted (outputs partially updated)
+  void end_update(BaseNode &node, bool completed);
+
+  void reset();
+
+  // recompute all the tiles during the ongoing update, see BaseNode::check_partial_update
+  void disable_partial_update();
+
+  const TileHashes *get_output_tile_hashes(int port_index) const; // nullptr if unknown
+  size_t            get_ndirty_tiles() const;
+  bool              is_partial_update() const;
+  bool              is_tile_dirty(const hmap::TileRegion &region) const;
+
+  static TileHashes get_tile_hashes(hmap::VirtualArray      &array,
+                                    const hmap::ComputeMode &cm);
+
+private:
+  void dilate_dirty_tiles(); // add the neighbors of the dirty tiles
+
+  std::map<int, TileHashes>   input_hashes;  // consumed during the last update
+  std::map<int, TileHashes>   output_hashes; // produced during the last update
+  std::map<size_t, glm::vec4> tile_bboxes;   // tile extent in unit square coordinates
+  std::set<size_t>            dirty_tiles;
+  bool                        partial_update = false;
+  uint64_t                    parameters_hash = 0;
+};
+
+} // namespace hesiod
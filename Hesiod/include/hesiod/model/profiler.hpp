@@ -0,0 +1,171 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "highmap/virtual_array/virtual_array.hpp"
+
+namespace hesiod
+{
+
+class BaseNode; // forward
+
+// one node evaluation
+struct ProfileRecord
+{
+  std::string node_id;
+  std::string node_type;
+  int64_t     t_start = 0;               // us, since the profiler origin
+  int64_t     duration = 0;              // us, wall time
+  int64_t     post_process_duration = 0; // us, pre/post-processing part of duration
+  size_t      ntiles = 0;                // heightmap tiles computed
+  int64_t     rss_delta = 0;             // bytes, process-wide
+  int64_t     peak_rss_delta = 0;        // bytes, growth of the process high-water mark
+  float       cpu_utilization = 0.f;     // node and tile threads CPU time / wall time
+  size_t      thread_id = 0;                 // see Profiler::get_thread_index
+};
+
+// trace timeline where a span is displayed
+enum TraceTrack : int
+{
+  TTR_THREAD,    // calling thread
+  TTR_BROADCAST, // inter-graph broadcasting
+  TTR_EXPORT,    // flatten and export
+};
+
+// any timed span other than a node evaluation (tiles, broadcasts, exports...)
+struct TraceEvent
+{
+  std::string    name;
+  std::string    category;
+  int64_t        t_start = 0;  // us, since the profiler origin
+  int64_t        duration = 0; // us
+  size_t         tid = 0;      // thread index or track
+  nlohmann::json args;
+};
+
+// =====================================
+// Profiler
+// =====================================
+
+// collects the node evaluations of all the graphs (when enabled in the settings), to
+// find the nodes dominating the computation time. The records can be exported as a JSON
+// report (evaluations and per-node-type summary) or as a Chrome trace (chrome://tracing,
+// Perfetto)
+class Profiler
+{
+public:
+  Profiler();
+
+  Profiler(const Profiler &) = delete;
+  Profiler &operator=(const Profiler &) = delete;
+
+  void clear();
+
+  // --- Records ---
+  void                       add_event(const TraceEvent &event);
+  void                       add_record(const ProfileRecord &record);
+  std::vector<TraceEvent>    get_events() const;
+  std::vector<ProfileRecord> get_records() const;
+  int64_t                    get_time(std::chrono::steady_clock::time_point t) const;
+
+  static size_t get_thread_index(); // small stable index of the calling thread
+  static size_t get_track_tid(TraceTrack track);
+
+  // --- Export ---
+  nlohmann::json get_report() const;
+  nlohmann::json get_chrome_trace() const;
+  bool           export_report(const std::filesystem::path &fname) const;
+  bool           export_chrome_trace(const std::filesystem::path &fname) const;
+
+  // --- Pre/post-processing time of the node evaluated by the calling thread ---
+  static void    add_post_process_time(int64_t duration_us);
+  static int64_t take_post_process_time(); // returns and resets the accumulated time
+
+private:
+  std::deque<ProfileRecord>             records;
+  std::deque<TraceEvent>                events;
+  size_t                                max_records = 100000; // oldest dropped first
+  size_t                                max_events = 1000000;
+  std::chrono::steady_clock::time_point origin;
+  mutable std::mutex                    mutex;
+};
+
+// =====================================
+// ProfileSpan
+// =====================================
+
+// records its lifetime as a trace span (only if profiling is enabled)
+class ProfileSpan
+{
+public:
+  ProfileSpan(const std::string &name,
+              const std::string &category,
+              TraceTrack         track = TraceTrack::TTR_THREAD,
+              nlohmann::json     args = nlohmann::json::object());
+  ~ProfileSpan();
+
+  ProfileSpan(const ProfileSpan &) = delete;
+  ProfileSpan &operator=(const ProfileSpan &) = delete;
+
+private:
+  bool                                  active;
+  TraceEvent                            event;
+  std::chrono::steady_clock::time_point t0;
+};
+
+// =====================================
+// TileSpan
+// =====================================
+
+// one tile of a for_each_tile loop, to be created at the beginning of the tile
+// function (nested in the node span when the tiles are computed by the node thread).
+// The CPU time of the tiles computed by the other threads is added to the node one
+class TileSpan
+{
+public:
+  TileSpan(const BaseNode &node, const hmap::TileRegion &region);
+  ~TileSpan();
+
+  TileSpan(const TileSpan &) = delete;
+  TileSpan &operator=(const TileSpan &) = delete;
+
+private:
+  const BaseNode                       *p_node = nullptr;
+  bool                                  recording = false;
+  size_t                                key = 0;
+  std::chrono::steady_clock::time_point t0;
+  int64_t                               cpu0 = 0; // ns
+};
+
+// =====================================
+// PostProcessTimer
+// =====================================
+
+// adds its lifetime to the pre/post-processing time of the current node evaluation
+class PostProcessTimer
+{
+public:
+  PostProcessTimer();
+  ~PostProcessTimer();
+
+private:
+  std::chrono::steady_clock::time_point t0;
+};
+
+// --- helpers (0 if not available on the platform)
+
+size_t  get_available_memory(); // bytes, system-wide
+size_t  get_process_rss();      // bytes
+size_t  get_process_peak_rss(); // bytes
+int64_t get_thread_cpu_time();  // ns, CPU time of the calling thread
+
+} // namespace hesiod
@@ -0,0 +1,214 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "highmap/virtual_array/virtual_array.hpp"
+#include "highmap/virtual_array/virtual_texture.hpp"
+
+#include "hesiod/model/thread_pool.hpp"
+
+namespace hesiod
+{
+
+// rectangular block of the heightmap, in global indices (i along x, j along y)
+struct ExportBlock
+{
+  glm::ivec2 ij0;
+  glm::ivec2 shape;
+};
+
+// called once per complete block (one array per input channel), never concurrently.
+// The writer may move the arrays out, they are released afterwards anyway
+using ExportBlockWriter = std::function<bool(size_t                    block_index,
+                                             std::vector<hmap::Array> &channels)>;
+
+// gathers the tiles of the heightmaps (same shape and tiling, e.g. the channels of a
+// texture) into the blocks (a partition of the heightmap, or part of it) in a single
+// pass over the tiles, each block being handed to the writer as soon as it is complete
+// and then released. Blocks come in tile order, sequential file formats have to encode
+// them independently and reorder them (see export_png_streamed). The tiles are read in
+// distributed mode so that only a few of them are resident at once, whatever the
+// storage mode
+bool stream_export_blocks(const std::vector<hmap::VirtualArray *> &arrays,
+                          const glm::ivec2                        &tile_shape,
+                          const std::vector<ExportBlock>          &blocks,
+                          const ExportBlockWriter                 &write_block,
+                          const hmap::ComputeMode                 &cm);
+
+// 2x2 box downsampling, odd edges averaged over the available pixels
+hmap::Array downsample_2x(const hmap::Array &array);
+
+// tile of a heightmap of shape 'shape', in global indices: index in the tiling grid,
+// first element (halo included) and interior [a, b), so that the halos are not counted
+// twice. Computed from the tile region only, without accessing the tile data. Only
+// valid for the tiles of the hmap::ForEachMode::VA_DISTRIBUTED mode
+struct TileInterior
+{
+  glm::ivec2 tile_index;
+  glm::ivec2 ij0;
+  glm::ivec2 a;
+  glm::ivec2 b;
+};
+
+TileInterior get_tile_interior(const hmap::TileRegion &region,
+                               const glm::ivec2       &shape,
+                               const glm::ivec2       &tile_shape);
+
+// =====================================
+// ParallelTileWriter
+// =====================================
+
+// runs file encoding/writing tasks on a thread pool. 'submit' blocks while
+// 'max_in_flight' tasks are queued or running, which bounds the memory held by the
+// blocks waiting to be written when the producer is faster than the disk
+class ParallelTileWriter
+{
+public:
+  // 0: hardware concurrency, and twice the number of threads for the in-flight limit
+  explicit ParallelTileWriter(size_t nthreads = 0, size_t max_in_flight = 0);
+
+  ParallelTileWriter(const ParallelTileWriter &) = delete;
+  ParallelTileWriter &operator=(const ParallelTileWriter &) = delete;
+
+  void submit(std::function<bool()> task); // task returns false on failure
+  bool wait();                             // false if any task failed
+
+private:
+  std::mutex              mutex;
+  std::condition_variable cv;
+  size_t                  max_in_flight;
+  size_t                  in_flight = 0;
+  bool                    ok = true;
+  ThreadPool              pool; // last, joined before the members above are destroyed
+};
+
+// --- Writers (values normalized to [0, 1] using the heightmap min/max, image rows
+// --- from top, i.e. j = shape.y - 1, to bottom)
+
+bool export_png_streamed(hmap::VirtualArray      &array,
+                         const glm::ivec2        &tile_shape,
+                         const std::string       &fname,
+                         int                      bit_depth, // 8 or 16
+                         const hmap::ComputeMode &cm);
+
+// RGB or RGBA image of the channels (e.g. of a texture), values expected in [0, 1] and
+// not normalized
+bool export_png_streamed(const std::vector<hmap::VirtualArray *> &channels,
+                         const glm::ivec2                        &tile_shape,
+                         const std::string                       &fname,
+                         int                                      bit_depth, // 8 or 16
+                         const hmap::ComputeMode                 &cm);
+
+bool export_raw_16bit_streamed(hmap::VirtualArray      &array,
+                               const glm::ivec2        &tile_shape,
+                               const std::string       &fname,
+                               const hmap::ComputeMode &cm);
+
+// float32 tiled TIFF, raw values (no normalization). Internal tiles have the shape
+// 'tile_shape' (rounded up to a multiple of 16, as required by the format), followed by
+// 2x overviews down to a single tile. The directories come first so that readers can
+// fetch only the tiles and levels they need. Optional lossless deflate compression with
+// the floating point predictor, BigTIFF beyond 4 GB
+bool export_tiff_float32_streamed(hmap::VirtualArray      &array,
+                                  const glm::ivec2        &tile_shape,
+                                  const std::string       &fname,
+                                  bool                     compress,
+                                  const hmap::ComputeMode &cm);
+
+// --- Terrain mesh writer
+
+struct MeshExportOptions
+{
+  float       elevation_scaling = 0.2f;
+  bool        simplify = true;    // full resolution grid otherwise
+  float       max_error = 5e-4f;  // in mesh units, the heightmap spanning [0, 1]
+  std::string texture_fname = ""; // optional images referenced by the material
+  std::string normal_map_fname = "";
+};
+
+// triangle mesh of the heightmap, glb (binary glTF 2.0) or obj file depending on the
+// extension. The heightmap is split in chunks simplified independently, each using the
+// coarsest regular grid within 'max_error'. The chunk borders are refined to the finer
+// grid of the two neighbors so that the seams are crack-free. Chunks are triangulated
+// concurrently and written as soon as they are ready, the whole mesh is never held in
+// memory
+bool export_mesh_streamed(hmap::VirtualArray      &array,
+                          const glm::ivec2        &tile_shape,
+                          const std::string       &fname,
+                          const MeshExportOptions &options,
+                          const hmap::ComputeMode &cm);
+
+// --- Level of detail pyramid
+
+enum class LodChunkFormat
+{
+  PNG_8BIT,
+  PNG_16BIT,
+  RAW_FLOAT32, // little endian
+};
+
+struct LodLevel
+{
+  glm::ivec2 shape;   // in pixels
+  glm::ivec2 nchunks; // chunks along x and y
+};
+
+// quadtree levels, from full resolution (level 0) down to a single chunk
+std::vector<LodLevel> get_lod_pyramid_levels(const glm::ivec2 &shape, int chunk_size);
+
+// quadtree of chunks of (at most) 'chunk_size' pixels, written to
+// <dir>/lod<l>/<i>_<j>.png|raw (i along x, j along y from the bottom, image rows from
+// the top). A chunk of level l + 1 is the 2x downsampling of the four chunks of level
+// l it covers and is built as soon as they are complete, so that the heightmap tiles
+// are read once and no level is ever held as a whole. Values are normalized to
+// [vmin, vmax] for the PNG formats, 1 (heightmap) or 4 (RGBA) channels
+bool export_lod_pyramid_streamed(const std::vector<hmap::VirtualArray *> &channels,
+                                 const glm::ivec2                        &tile_shape,
+                                 const std::filesystem::path             &dir,
+                                 int                                      chunk_size,
+                                 LodChunkFormat                           format,
+                                 float                                    vmin,
+                                 float                                    vmax,
+                                 const hmap::ComputeMode                 &cm);
+
+// --- Tiled writers, one PNG file per output tile named <fname>_<i>_<j>.png, the files
+// --- being encoded and written concurrently
+
+struct TiledExportLayout
+{
+  glm::ivec2 tiling = {4, 4};
+  int        leading_zeros = 3;
+  bool       overlapping_edges = false; // share the last row/column with the next tile
+  bool       reverse_tile_y_indexing = false;
+};
+
+bool export_tiled_streamed(hmap::VirtualArray      &array,
+                           const glm::ivec2        &tile_shape,
+                           const std::string       &fname,
+                           const TiledExportLayout &layout,
+                           int                      bit_depth, // 8 or 16
+                           const hmap::ComputeMode &cm);
+
+// RGB, normals computed per output tile with a one-pixel margin
+bool export_normal_map_tiled_streamed(hmap::VirtualArray      &array,
+                                      const glm::ivec2        &tile_shape,
+                                      const std::string       &fname,
+                                      const TiledExportLayout &layout,
+                                      int                      bit_depth,
+                                      const hmap::ComputeMode &cm);
+
+// RGBA, texture values are expected in [0, 1]
+bool export_texture_tiled_streamed(hmap::VirtualTexture    &texture,
+                                   const glm::ivec2        &tile_shape,
+                                   const std::string       &fname,
+                                   const TiledExportLayout &layout,
+                                   int                      bit_depth,
+                                   const hmap::ComputeMode &cm);
+
+} // namespace hesiod
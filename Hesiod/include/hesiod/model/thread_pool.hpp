@@ -0,0 +1,49 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General Public
+   License. The full license is in the file LICENSE, distributed with this software. */
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hesiod
+{
+
+// =====================================
+// ThreadPool
+// =====================================
+
+// fixed-size pool of worker threads pulling tasks from a shared FIFO queue, workers are
+// joined when the pool is destroyed (pending tasks are executed first)
+class ThreadPool
+{
+public:
+  explicit ThreadPool(size_t nthreads = 0); // 0: use hardware concurrency
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  size_t            get_nthreads() const;
+  std::future<void> submit(std::function<void()> task);
+  void              wait_idle();
+
+private:
+  void worker_loop();
+
+  std::vector<std::thread>          workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex                        mutex;
+  std::condition_variable           cv_task;
+  std::condition_variable           cv_idle;
+  size_t                            active_count = 0;
+  bool                              stop = false;
+};
+
+// helper
+size_t get_default_thread_count(int requested = 0);
+
+} // namespace hesiod
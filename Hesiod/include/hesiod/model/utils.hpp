@@ -3,6 +3,7 @@
 #pragma once
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <filesystem>
 #include <sstream>
 #include <string>
@@ -72,6 +73,14 @@ std::filesystem::path insert_before_extension(const std::filesystem::path &origi
 std::filesystem::path prepend_project_name_to_path(
     const std::filesystem::path &original_path);
 
+// --- Hashing (FNV-1a, stable across runs and platforms)
+
+uint64_t hash_combine(uint64_t seed, uint64_t value);
+uint64_t hash_string(const std::string &str, uint64_t seed = 0xcbf29ce484222325ULL);
+uint64_t hash_data(const void *data,
+                   size_t      size,
+                   uint64_t    seed = 0xcbf29ce484222325ULL); // word-wise, for bulk data
+
 // --- json
 
 nlohmann::json json_from_file(const std::string &fname);
@@ -19,6 +19,9 @@ void AppContext::initialize()
 
   this->load_settings();
   this->load_node_documentation();
+
+  if (this->app_settings.model.node_cache_dir.empty())
+    this->app_settings.model.node_cache_dir = get_node_cache_dir_default();
 }
 
 void AppContext::load_node_documentation()
@@ -61,6 +64,10 @@ void AppContext::load_project_model(const std::string &fname)
 
   this->new_project();
 
+  // node outputs are restored from the project data during the first update
+  if (this->app_settings.model.enable_node_data_store)
+    this->node_data_store.attach(fname);
+
   nlohmann::json json = json_from_file(fname);
   this->project_model->json_from(json);
 }
@@ -79,6 +86,7 @@ void AppContext::new_project()
 {
   Logger::log()->trace("AppContext::new_project");
   this->project_model = std::make_unique<ProjectModel>();
+  this->node_data_store.attach("");
 }
 
 void AppContext::reset_settings()
@@ -88,12 +96,20 @@ void AppContext::reset_settings()
   this->style_settings = StyleSettings();
 }
 
-void AppContext::save_project_model(const std::string &fname) const
+void AppContext::save_project_model(const std::string &fname, bool save_node_data)
 {
   Logger::log()->trace("AppContext::save_project_model: {}", fname);
 
   nlohmann::json json = this->project_model->json_to();
   json_to_file(json, fname, /* merge_with_existing_content */ true);
+
+  // node outputs sidecar, not for temporary copies of the project
+  if (this->app_settings.model.enable_node_data_store && save_node_data)
+  {
+    this->node_data_store.attach(fname);
+    this->node_data_store.save_project(*this->project_model,
+                                       this->app_settings.model.node_data_compression);
+  }
 }
 
 void AppContext::save_settings() const
@@ -165,6 +181,12 @@ std::string get_config_file_path(const QString &app_name, bool portable_mode)
   return path.toStdString();
 }
 
+std::string get_node_cache_dir_default()
+{
+  QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  return (dir + QDir::separator() + "node_cache").toStdString();
+}
+
 std::string get_config_file_path_auto(const QString &app_name)
 {
   QDir    app_dir(QCoreApplication::applicationDirPath());
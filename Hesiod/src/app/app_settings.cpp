@@ -60,6 +60,28 @@ void AppSettings::json_from(nlohmann::json const &json)
   json_safe_get(json,
                 "model.allow_broadcast_receive_within_same_graph",
                 model.allow_broadcast_receive_within_same_graph);
+  json_safe_get(json, "model.enable_parallel_update", model.enable_parallel_update);
+  json_safe_get(json,
+                "model.deterministic_update_order",
+                model.deterministic_update_order);
+  json_safe_get(json, "model.update_thread_count", model.update_thread_count);
+  json_safe_get(json, "model.enable_async_update", model.enable_async_update);
+  json_safe_get(json, "model.enable_tile_update", model.enable_tile_update);
+  json_safe_get(json,
+                "model.enable_progressive_update",
+                model.enable_progressive_update);
+  json_safe_get(json, "model.preview_resolution", model.preview_resolution);
+  json_safe_get(json, "model.enable_profiling", model.enable_profiling);
+  json_safe_get(json, "model.enable_async_export", model.enable_async_export);
+  json_safe_get(json, "model.enable_node_cache", model.enable_node_cache);
+  json_safe_get(json, "model.node_cache_budget_mb", model.node_cache_budget_mb);
+  json_safe_get(json, "model.enable_disk_cache", model.enable_disk_cache);
+  json_safe_get(json,
+                "model.node_cache_disk_budget_mb",
+                model.node_cache_disk_budget_mb);
+  json_safe_get(json, "model.node_cache_dir", model.node_cache_dir);
+  json_safe_get(json, "model.enable_node_data_store", model.enable_node_data_store);
+  json_safe_get(json, "model.node_data_compression", model.node_data_compression);
 
   json_safe_get(json, "colors.bg_deep", colors.bg_deep);
   json_safe_get(json, "colors.bg_primary", colors.bg_primary);
@@ -140,6 +162,8 @@ void AppSettings::json_from(nlohmann::json const &json)
   json_safe_get(json, "viewer.width", viewer.width);
   json_safe_get(json, "viewer.height", viewer.height);
   json_safe_get(json, "viewer.add_heighmap_skirt", viewer.add_heighmap_skirt);
+  json_safe_get(json, "viewer.enable_mesh_lod", viewer.enable_mesh_lod);
+  json_safe_get(json, "viewer.max_mesh_resolution", viewer.max_mesh_resolution);
 
   // window
   {
@@ -163,6 +187,22 @@ nlohmann::json AppSettings::json_to() const
 
   json["model.allow_broadcast_receive_within_same_graph"] =
       model.allow_broadcast_receive_within_same_graph;
+  json["model.enable_parallel_update"] = model.enable_parallel_update;
+  json["model.deterministic_update_order"] = model.deterministic_update_order;
+  json["model.update_thread_count"] = model.update_thread_count;
+  json["model.enable_async_update"] = model.enable_async_update;
+  json["model.enable_tile_update"] = model.enable_tile_update;
+  json["model.enable_progressive_update"] = model.enable_progressive_update;
+  json["model.preview_resolution"] = model.preview_resolution;
+  json["model.enable_profiling"] = model.enable_profiling;
+  json["model.enable_async_export"] = model.enable_async_export;
+  json["model.enable_node_cache"] = model.enable_node_cache;
+  json["model.node_cache_budget_mb"] = model.node_cache_budget_mb;
+  json["model.enable_disk_cache"] = model.enable_disk_cache;
+  json["model.node_cache_disk_budget_mb"] = model.node_cache_disk_budget_mb;
+  json["model.node_cache_dir"] = model.node_cache_dir;
+  json["model.enable_node_data_store"] = model.enable_node_data_store;
+  json["model.node_data_compression"] = model.node_data_compression;
 
   json["colors.bg_deep"] = colors.bg_deep.name().toStdString();
   json["colors.bg_primary"] = colors.bg_primary.name().toStdString();
@@ -208,6 +248,8 @@ nlohmann::json AppSettings::json_to() const
   json["viewer.width"] = viewer.width;
   json["viewer.height"] = viewer.height;
   json["viewer.add_heighmap_skirt"] = viewer.add_heighmap_skirt;
+  json["viewer.enable_mesh_lod"] = viewer.enable_mesh_lod;
+  json["viewer.max_mesh_resolution"] = viewer.max_mesh_resolution;
 
   json["window.x"] = window.x;
   json["window.y"] = window.y;
@@ -1,6 +1,7 @@
 /* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <deque>
 #include <format>
 #include <fstream>
 #include <iostream>
@@ -9,7 +10,9 @@
 #include <QDesktopServices>
 #include <QFileDialog>
 #include <QMenuBar>
+#include <QEventLoop>
 #include <QMessageBox>
+#include <QProcess>
 #include <QProgressDialog>
 #include <QStatusBar>
 #include <QUrl>
@@ -17,7 +20,6 @@
 #include "highmap/opencl/gpu_opencl.hpp"
 
 #include "hesiod/app/hesiod_application.hpp"
-#include "hesiod/cli/batch_mode.hpp"
 #include "hesiod/gui/project_ui.hpp"
 #include "hesiod/gui/widgets/about_dialog.hpp"
 #include "hesiod/gui/widgets/bake_config_dialog.hpp"
@@ -31,6 +33,7 @@
 #include "hesiod/gui/widgets/tool_tip_blocker.hpp"
 #include "hesiod/logger.hpp"
 #include "hesiod/model/constants/color_gradient.hpp"
+#include "hesiod/model/graph/bake_config.hpp"
 #include "hesiod/model/graph/graph_manager.hpp"
 #include "hesiod/model/graph/graph_node.hpp"
 #include "hesiod/model/utils.hpp"
@@ -245,42 +248,37 @@ void HesiodApplication::on_export_batch()
                        bake_settings.resolution,
                        bake_settings.nvariants);
 
-  // --- setup export repertory
+  // --- prepare the variants
 
   this->notify("Baking and exporting...");
 
-  // block UI
-  QProgressDialog progress(tr("Baking and exporting..."),
-                           QString(),
-                           0,
-                           0,
-                           this->main_window);
-  progress.setWindowModality(Qt::ApplicationModal);
-  progress.setCancelButton(nullptr);
-  progress.setMinimumDuration(0); // show immediately
-  progress.show();
-  QCoreApplication::processEvents();
+  const fs::path project_path = this->context.project_model->get_path();
 
-  for (int k = 0; k < bake_settings.nvariants + 1; ++k)
-  {
-    const std::string msg = std::format("Baking variants {}/{}...",
-                                        k,
-                                        bake_settings.nvariants + 1);
-    this->notify(msg);
+  // build export path based on project name, if available
+  fs::path export_root = project_path.filename();
+  if (export_root.empty())
+    export_root = "export";
+  else
+    export_root += "_export";
+
+  export_root = project_path.empty() ? export_root
+                                     : project_path.parent_path() / export_root;
 
-    QCoreApplication::processEvents(); // render progress dialog
+  // retrieve config of the first graph
+  auto graph_nodes = this->context.project_model->get_graph_manager_ref()
+                         ->get_graph_nodes();
+  auto         it = graph_nodes.begin();
+  GraphConfig *p_config = it != graph_nodes.end() ? it->second->get_config_ref()
+                                                  : nullptr;
 
-    const fs::path project_path = this->context.project_model->get_path();
+  if (!p_config)
+    return;
 
-    // build export path based on project name, if available
-    fs::path export_path = project_path.filename();
-    if (export_path.empty())
-      export_path = "export";
-    else
-      export_path += "_export";
+  std::vector<fs::path> variant_fnames;
 
-    export_path = project_path.empty() ? export_path
-                                       : project_path.parent_path() / export_path;
+  for (int k = 0; k < bake_settings.nvariants + 1; ++k)
+  {
+    fs::path export_path = export_root;
 
     if (k > 0)
       export_path /= "variants_" + std::to_string(k);
@@ -296,11 +294,10 @@ void HesiodApplication::on_export_batch()
       fs::create_directories(export_path);
     }
 
-    // --- save an hesiod file and tweak it
-
-    // save graph node to a temporary file
+    // save graph node to a temporary file (without the node data, it would land in the
+    // export directory and detach the project data)
     fs::path fname = export_path / "hesiod_bake.hsd";
-    this->save_project_model_and_ui(fname.string());
+    this->save_project_model_and_ui(fname.string(), false);
 
     // force auto_export for export nodes and overwrite export paths
     override_export_nodes_settings(fname.string(),
@@ -308,34 +305,149 @@ void HesiodApplication::on_export_batch()
                                    static_cast<uint>(k),
                                    bake_settings);
 
-    // --- run
+    variant_fnames.push_back(fname);
+  }
+
+  // --- run, each variant in its own batch mode process
+
+  const int nvariants = static_cast<int>(variant_fnames.size());
+  const int nworkers = get_bake_worker_count(bake_settings);
+
+  Logger::log()->info("MainWindow::on_export_batch: {} variant(s), {} worker(s)",
+                      nvariants,
+                      nworkers);
 
-    // retrieve config of the first graph
-    auto graph_nodes = this->context.project_model->get_graph_manager_ref()
-                           ->get_graph_nodes();
-    auto         it = graph_nodes.begin();
-    GraphConfig *p_config = it != graph_nodes.end() ? it->second->get_config_ref()
-                                                    : nullptr;
+  QStringList base_args = {
+      QString::fromStdString(std::format("--shape={},{}",
+                                         bake_settings.resolution,
+                                         bake_settings.resolution)),
+      QString::fromStdString(
+          std::format("--tiling={},{}", p_config->tiling.x, p_config->tiling.y)),
+      QString::fromStdString(std::format("--overlap={}", p_config->overlap))};
+
+  // the workers always get a compute configuration (node memory released after each
+  // compute), as the in-process bake did
+  if (bake_settings.force_distributed)
+    base_args << "--distributed";
+  else
+    base_args << "--trim-storage";
 
-    if (p_config)
+  // block UI
+  QProgressDialog progress(tr("Baking and exporting..."),
+                           tr("Cancel"),
+                           0,
+                           nvariants,
+                           this->main_window);
+  progress.setWindowModality(Qt::ApplicationModal);
+  progress.setMinimumDuration(0); // show immediately
+  progress.setValue(0);
+
+  std::deque<int>           pending;
+  std::map<QProcess *, int> running;
+  std::vector<int>          failed;
+  int                       ndone = 0;
+  QEventLoop                loop;
+
+  for (int k = 0; k < nvariants; ++k)
+    pending.push_back(k);
+
+  auto update_progress = [&]()
+  {
+    progress.setLabelText(QString::fromStdString(
+        std::format("Baking variants: {}/{} done, {} running, {} failed",
+                    ndone,
+                    nvariants,
+                    running.size(),
+                    failed.size())));
+    progress.setValue(ndone);
+  };
+
+  std::function<void()> start_next = [&]()
+  {
+    while (!pending.empty() && static_cast<int>(running.size()) < nworkers)
     {
-      GraphConfig bake_config = *p_config;
+      const int k = pending.front();
+      pending.pop_front();
+
+      QProcess *process = new QProcess();
+      process->setProcessChannelMode(QProcess::MergedChannels);
 
-      if (bake_settings.force_distributed)
+      // headless worker
+      QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+      env.insert("QT_QPA_PLATFORM", "offscreen");
+      process->setProcessEnvironment(env);
+
+      running[process] = k;
+
+      // a failing variant does not stop the others
+      auto on_worker_end = [&, process, k](bool success)
       {
-        bake_config.cm_cpu.mode = hmap::ForEachMode::VA_DISTRIBUTED;
-        bake_config.cm_gpu.mode = hmap::ForEachMode::VA_DISTRIBUTED;
-      }
-
-      // run batch node
-      hesiod::cli::run_batch_mode(
-          fname.string(),
-          glm::ivec2(bake_settings.resolution, bake_settings.resolution),
-          bake_config.tiling,
-          bake_config.overlap,
-          &bake_config);
+        if (!success)
+          failed.push_back(k);
+
+        running.erase(process);
+        process->deleteLater();
+        ndone++;
+
+        start_next();
+        update_progress();
+
+        if (running.empty())
+          loop.quit();
+      };
+
+      this->connect(
+          process,
+          &QProcess::finished,
+          [process, k, on_worker_end](int exit_code, QProcess::ExitStatus exit_status)
+          {
+            const bool success = exit_status == QProcess::NormalExit && exit_code == 0;
+
+            if (!success)
+              Logger::log()->error("MainWindow::on_export_batch: variant {} failed, "
+                                   "exit code {}, output:\n{}",
+                                   k,
+                                   exit_code,
+                                   process->readAll().toStdString());
+
+            on_worker_end(success);
+          });
+
+      // 'finished' is not emitted when the process could not be started
+      this->connect(process,
+                    &QProcess::errorOccurred,
+                    [process, k, on_worker_end](QProcess::ProcessError error)
+                    {
+                      if (error != QProcess::FailedToStart)
+                        return;
+
+                      Logger::log()->error("MainWindow::on_export_batch: variant {} "
+                                           "failed to start: {}",
+                                           k,
+                                           process->errorString().toStdString());
+
+                      on_worker_end(false);
+                    });
+
+      QStringList args = {"--batch", QString::fromStdString(variant_fnames[k].string())};
+      process->start(QCoreApplication::applicationFilePath(), args + base_args);
     }
-  }
+  };
+
+  this->connect(&progress,
+                &QProgressDialog::canceled,
+                [&]()
+                {
+                  pending.clear();
+                  for (auto &[process, _] : running)
+                    process->kill();
+                });
+
+  start_next();
+  update_progress();
+
+  if (!running.empty())
+    loop.exec();
 
   // save config
   this->context.project_model->set_bake_config(bake_settings);
@@ -343,7 +455,48 @@ void HesiodApplication::on_export_batch()
   // unblock UI
   progress.close();
 
-  this->notify("Baking and exporting terminated.");
+  if (progress.wasCanceled())
+    this->notify("Baking and exporting cancelled.");
+  else if (!failed.empty())
+    this->notify(std::format("Baking and exporting terminated, {} variant(s) failed.",
+                             failed.size()));
+  else
+    this->notify("Baking and exporting terminated.");
+}
+
+void HesiodApplication::on_export_profiling()
+{
+  Logger::log()->trace("HesiodApplication::on_export_profiling");
+
+  if (!this->context.app_settings.model.enable_profiling)
+  {
+    this->notify("Profiling is disabled, enable it in the application settings");
+    return;
+  }
+
+  const QString filter_report = "Profiling report (*.json)";
+  const QString filter_trace = "Chrome trace (*.json)";
+  QString       selected_filter = filter_report;
+
+  QString fname = QFileDialog::getSaveFileName(this->main_window,
+                                               "Export profiling data...",
+                                               "hesiod_profile.json",
+                                               filter_report + ";;" + filter_trace,
+                                               &selected_filter);
+
+  if (fname.isNull() || fname.isEmpty())
+    return;
+
+  fs::path path = ensure_extension(fs::path(fname.toStdString()), ".json");
+  bool     ret;
+
+  if (selected_filter == filter_trace)
+    ret = this->context.profiler.export_chrome_trace(path);
+  else
+    ret = this->context.profiler.export_report(path);
+
+  if (ret)
+    this->notify("Profiling data exported to " + path.string());
 }
 
 void HesiodApplication::on_load()
@@ -519,7 +672,8 @@ void HesiodApplication::save_backup(const std::string &fname)
   }
 }
 
-void HesiodApplication::save_project_model_and_ui(const std::string &fname)
+void HesiodApplication::save_project_model_and_ui(const std::string &fname,
+                                                  bool               save_node_data)
 {
   Logger::log()->trace("HesiodApplication::save_project_model_and_ui: {}", fname);
 
@@ -560,7 +714,7 @@ void HesiodApplication::save_project_model_and_ui(const std::string &fname)
   }
 
   // proceed with saving
-  this->context.save_project_model(fname);
+  this->context.save_project_model(fname, save_node_data);
   this->context.project_model->set_is_dirty(false);
   this->project_ui->save_ui_state(fname);
 
@@ -674,6 +828,14 @@ void HesiodApplication::setup_menu_bar()
   reseed_back->setShortcut(tr("Alt+Shift+R"));
   graph_menu->addAction(reseed_back);
 
+  graph_menu->addSeparator();
+
+  auto *export_profiling = new QAction("Export Profiling Data", this);
+  graph_menu->addAction(export_profiling);
+
+  auto *clear_profiling = new QAction("Clear Profiling Data", this);
+  graph_menu->addAction(clear_profiling);
+
   // --- view
 
   QMenu *view_menu = this->main_window->menuBar()->addMenu("&View");
@@ -737,6 +899,15 @@ void HesiodApplication::setup_menu_bar()
                 this,
                 &HesiodApplication::on_project_settings);
 
+  this->connect(export_profiling,
+                &QAction::triggered,
+                this,
+                &HesiodApplication::on_export_profiling);
+  this->connect(clear_profiling,
+                &QAction::triggered,
+                this,
+                [this]() { this->context.profiler.clear(); });
+
   this->connect(quick_help,
                 &QAction::triggered,
                 this,
@@ -30,11 +30,30 @@ int parse_args(args::ArgumentParser &parser, int argc, char *argv[])
 
   args::Flag node_inventory(group, "", "Node inventory output", {"inventory"});
 
+  args::ValueFlag<std::string> benchmark(
+      group,
+      "csv or json file",
+      "Time every node type and write the results, ex. --benchmark=bench.json",
+      {"benchmark"});
+
+  args::ValueFlag<std::string> project_benchmark(
+      group,
+      "csv or json file",
+      "Time the update and export of the example and bootstrap projects, ex. "
+      "--benchmark-projects=bench.json",
+      {"benchmark-projects"});
+
   args::ValueFlag<std::string> batch(group,
                                      "hsd file",
                                      "Execute Hesiod in batch mode",
                                      {'b', "batch"});
 
+  args::ValueFlag<std::string> jobs(
+      group,
+      "json or csv file",
+      "Execute the jobs of a manifest (project, shape, tiling, seed_offset, output_dir)",
+      {"jobs"});
+
   args::Group batch_args(group,
                          "batch mode arguments",
                          args::Group::Validators::DontCare);
@@ -56,17 +75,133 @@ int parse_args(args::ArgumentParser &parser, int argc, char *argv[])
       "Tile overlapping ratio (in [0, 1[), ex. --overlap=0.25",
       {"overlap"});
 
+  args::Flag distributed_arg(
+      batch_args,
+      "",
+      "Force the distributed compute mode and release node memory after each compute",
+      {"distributed"});
+
+  args::Flag trim_arg(batch_args,
+                      "",
+                      "Release node memory after each compute (default compute modes)",
+                      {"trim-storage"});
+
+  args::Flag cache_arg(batch_args,
+                       "",
+                       "Reuse (and store) node outputs from the node cache directory",
+                       {"cache"});
+
+  args::ValueFlag<std::string> profile_arg(
+      batch_args,
+      "json file",
+      "Export a profiling report of the node evaluations, ex. --profile=report.json",
+      {"profile"});
+
+  args::ValueFlag<std::string> trace_arg(
+      batch_args,
+      "json file",
+      "Export a Chrome trace (nodes, tiles, broadcasts, export), ex. --trace=trace.json",
+      {"trace"});
+
+  args::Group jobs_args(group, "job queue arguments", args::Group::Validators::DontCare);
+
+  args::ValueFlag<std::string> jobs_state_arg(
+      jobs_args,
+      "json file",
+      "State file of the completed jobs (default: <manifest>.state.json)",
+      {"jobs-state"});
+
+  args::Group benchmark_args(group,
+                             "benchmark mode arguments",
+                             args::Group::Validators::DontCare);
+
+  args::ValueFlagList<int> bench_shapes_arg(
+      benchmark_args,
+      "size",
+      "Heightmap sizes (default: 512 to 8192, 1024 for projects), ex. --bench-shape=512 "
+      "--bench-shape=2048",
+      {"bench-shape"});
+
+  args::ValueFlag<glm::ivec2> bench_tiling_arg(
+      benchmark_args,
+      "tiling",
+      "Project benchmark heightmap tiling (default: 4,4), ex. --bench-tiling=4,4",
+      {"bench-tiling"});
+
+  args::ValueFlagList<std::string> bench_dirs_arg(
+      benchmark_args,
+      "directory",
+      "Project benchmark directories (default: data/examples and data/bootstraps)",
+      {"bench-dir"});
+
+  args::ValueFlag<int> bench_repeat_arg(benchmark_args,
+                                        "count",
+                                        "Timed evaluations per case (default: 5)",
+                                        {"bench-repeat"});
+
+  args::ValueFlag<std::string> bench_filter_arg(
+      benchmark_args,
+      "text",
+      "Only benchmark the node types (or projects) containing this text, ex. "
+      "--bench-filter=Hydraulic",
+      {"bench-filter"});
+
+  args::ValueFlag<std::string> bench_baseline_arg(
+      benchmark_args,
+      "json file",
+      "Compare the median times with a previous JSON output and report regressions",
+      {"bench-baseline"});
+
+  args::ValueFlag<float> bench_tolerance_arg(
+      benchmark_args,
+      "ratio",
+      "Relative slowdown reported as a regression (default: 0.1)",
+      {"bench-tolerance"});
+
   try
   {
     parser.ParseCLI(argc, argv);
 
     if (batch)
     {
-      run_batch_mode(args::get(batch),
-                     shape_arg ? args::get(shape_arg) : glm::ivec2(0, 0),
-                     tiling_arg ? args::get(tiling_arg) : glm::ivec2(0, 0),
-                     overlap_arg ? args::get(overlap_arg) : -1.f);
-      return 0;
+      if (cache_arg)
+      {
+        HSD_CTX.app_settings.model.enable_node_cache = true;
+        HSD_CTX.app_settings.model.enable_disk_cache = true;
+      }
+
+      if (profile_arg || trace_arg)
+      {
+        HSD_CTX.app_settings.model.enable_profiling = true;
+        HSD_CTX.profiler.clear();
+      }
+
+      GraphConfig input_config;
+
+      if (distributed_arg)
+      {
+        input_config.cm_cpu.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+        input_config.cm_gpu.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+      }
+
+      bool success = run_batch_mode(args::get(batch),
+                                    shape_arg ? args::get(shape_arg) : glm::ivec2(0, 0),
+                                    tiling_arg ? args::get(tiling_arg) : glm::ivec2(0, 0),
+                                    overlap_arg ? args::get(overlap_arg) : -1.f,
+                                    (distributed_arg || trim_arg) ? &input_config
+                                                                  : nullptr);
+
+      if (profile_arg)
+        HSD_CTX.profiler.export_report(args::get(profile_arg));
+
+      if (trace_arg)
+        HSD_CTX.profiler.export_chrome_trace(args::get(trace_arg));
+
+      return success ? 0 : 1;
+    }
+    else if (jobs)
+    {
+      return run_job_queue(args::get(jobs), args::get(jobs_state_arg));
     }
     else if (snapshot_generation)
     {
@@ -78,6 +213,38 @@ int parse_args(args::ArgumentParser &parser, int argc, char *argv[])
       run_node_inventory();
       return 0;
     }
+    else if (benchmark)
+    {
+      std::vector<int> shapes = args::get(bench_shapes_arg);
+      if (shapes.empty())
+        shapes = {512, 1024, 2048, 4096, 8192};
+
+      int nregressions = run_benchmark(args::get(benchmark),
+                                       shapes,
+                                       bench_repeat_arg ? args::get(bench_repeat_arg) : 5,
+                                       args::get(bench_filter_arg),
+                                       args::get(bench_baseline_arg),
+                                       bench_tolerance_arg ? args::get(bench_tolerance_arg)
+                                                           : 0.1f);
+      return nregressions > 0 ? 1 : 0;
+    }
+    else if (project_benchmark)
+    {
+      std::vector<int> shapes = args::get(bench_shapes_arg);
+      if (shapes.empty())
+        shapes = {1024};
+
+      std::vector<std::string> dirs = args::get(bench_dirs_arg);
+      if (dirs.empty())
+        dirs = {"data/examples", "data/bootstraps"};
+
+      return run_project_benchmark(args::get(project_benchmark),
+                                   dirs,
+                                   shapes,
+                                   bench_tiling_arg ? args::get(bench_tiling_arg)
+                                                    : glm::ivec2(4, 4),
+                                   args::get(bench_filter_arg));
+    }
   }
   catch (const args::Help &help)
   {
@@ -94,11 +261,13 @@ int parse_args(args::ArgumentParser &parser, int argc, char *argv[])
   return -1;
 }
 
-void run_batch_mode(const std::string &filename,
+bool run_batch_mode(const std::string &filename,
                     const glm::ivec2  &shape,
                     const glm::ivec2  &tiling,
                     float              overlap,
-                    const GraphConfig *p_input_model_config)
+                    const GraphConfig *p_input_model_config,
+                    ExportQueue       *p_export_queue,
+                    bool               async_export)
 {
   Logger::log()->info("executing Hesiod in batch mode");
   Logger::log()->trace("file: {}", filename);
@@ -143,12 +312,39 @@ void run_batch_mode(const std::string &filename,
     Logger::log()->info("compute overlap: {}", config.overlap);
   }
 
+  ExportQueue &export_queue = p_export_queue ? *p_export_queue : HSD_CTX.export_queue;
+  export_queue.set_synchronous(!async_export);
+
   GraphManager graph_manager;
+  graph_manager.set_p_export_queue(&export_queue);
   graph_manager.load_from_file(filename, &config);
 
+  if (HSD_CTX.app_settings.model.enable_node_cache)
+  {
+    const NodeOutputCache &cache = HSD_CTX.node_output_cache;
+
+    Logger::log()->info("node cache: {} hit(s) in memory, {} on disk, {} miss(es)",
+                        cache.get_nhits(),
+                        cache.get_ndisk_hits(),
+                        cache.get_nmisses());
+  }
+
   // flatten & export if there is a configuration defined
   if (!graph_manager.get_export_param().export_path.empty())
     graph_manager.export_flatten();
+
+  // flush barrier, the Export* nodes write their files in the background
+  ExportReport report = export_queue.flush();
+
+  Logger::log()->info("exports: {} file(s) written, {} failed, {} superseded",
+                      report.ncompleted - report.nfailed,
+                      report.nfailed,
+                      report.nsuperseded);
+
+  for (auto &label : report.failures)
+    Logger::log()->error("export failed: {}", label);
+
+  return report.nfailed == 0;
 }
 
 void run_node_inventory()
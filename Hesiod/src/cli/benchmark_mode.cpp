@@ -0,0 +1,633 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+
+#include "hesiod/app/hesiod_application.hpp"
+#include "hesiod/cli/batch_mode.hpp"
+#include "hesiod/logger.hpp"
+#include "hesiod/model/graph/graph_manager.hpp"
+#include "hesiod/model/graph/graph_node.hpp"
+#include "hesiod/model/nodes/node_factory.hpp"
+#include "hesiod/model/utils.hpp"
+
+namespace hesiod::cli
+{
+
+// --- helpers
+
+struct BenchmarkResult
+{
+  std::string node_type;
+  glm::ivec2  shape;
+  glm::ivec2  tiling;
+  std::string mode;
+  int         nrepeat = 0;
+  float       median = 0.f;     // ms
+  float       p95 = 0.f;        // ms
+  float       throughput = 0.f; // MB/s of heightmap outputs
+
+  std::string get_key() const
+  {
+    return std::format("{}/{}x{}/{}x{}/{}",
+                       this->node_type,
+                       this->shape.x,
+                       this->shape.y,
+                       this->tiling.x,
+                       this->tiling.y,
+                       this->mode);
+  }
+};
+
+static float get_percentile(std::vector<float> values, float p)
+{
+  if (values.empty())
+    return 0.f;
+
+  std::sort(values.begin(), values.end());
+  size_t k = static_cast<size_t>(std::ceil(p * float(values.size()))) - 1;
+  return values[std::clamp(k, size_t(0), values.size() - 1)];
+}
+
+// source nodes feeding the inputs of the benchmarked node, by data type
+static const std::map<std::string, std::string> &get_source_node_types()
+{
+  static const std::map<std::string, std::string> source_types = {
+      {"VirtualArray", "Noise"},
+      {"VirtualTexture", "TextureUvChecker"},
+      {"Cloud", "CloudRandom"},
+      {"Path", "Path"}};
+  return source_types;
+}
+
+static bool is_benchmarkable(const std::string &node_type, const std::string &category)
+{
+  // file I/O, debugging and graph routing nodes are left aside
+  if (node_type == "Broadcast" || node_type == "Receive")
+    return false;
+
+  for (const std::string &excluded : {"Export", "Debug", "WIP/DEPRECATED"})
+    if (category.starts_with(excluded))
+      return false;
+
+  return true;
+}
+
+static std::string find_port_label(BaseNode          &node,
+                                   gngui::PortType    port_type,
+                                   const std::string &data_type)
+{
+  for (int k = 0; k < node.get_nports(); ++k)
+    if (node.get_port_type(k) == port_type &&
+        map_type_name(node.get_data_type(k)) == data_type)
+      return node.get_port_caption(k);
+
+  return "";
+}
+
+static std::optional<BenchmarkResult> benchmark_node(
+    GraphNode                                &graph,
+    const std::shared_ptr<GraphConfig>       &config,
+    const std::string                        &node_type,
+    const std::map<std::string, std::string> &source_ids,
+    int                                       nrepeat)
+{
+  std::shared_ptr<gnode::Node> node = node_factory(node_type, config);
+
+  if (!node)
+    return std::nullopt;
+
+  std::string node_id = graph.add_node(node);
+  BaseNode   *p_node = graph.get_node_ref_by_id<BaseNode>(node_id);
+
+  // connect every input to the source providing its data type
+  int noutputs = 0;
+
+  for (int k = 0; k < p_node->get_nports(); ++k)
+  {
+    const std::string data_type = map_type_name(p_node->get_data_type(k));
+
+    if (p_node->get_port_type(k) == gngui::PortType::OUT)
+    {
+      noutputs += data_type == "VirtualArray" ? 1 : 0;
+      continue;
+    }
+
+    auto it = source_ids.find(data_type);
+    if (it == source_ids.end())
+      continue;
+
+    BaseNode   *p_source = graph.get_node_ref_by_id<BaseNode>(it->second);
+    std::string port_from = find_port_label(*p_source, gngui::PortType::OUT, data_type);
+
+    graph.new_link(it->second, port_from, node_id, p_node->get_port_caption(k));
+  }
+
+  std::vector<float> timings;
+  timings.reserve(nrepeat);
+
+  // first evaluation is a warm-up (allocations, tile storage)
+  for (int r = -1; r < nrepeat; ++r)
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    p_node->compute();
+    auto t1 = std::chrono::steady_clock::now();
+
+    if (r >= 0)
+      timings.push_back(std::chrono::duration<float, std::milli>(t1 - t0).count());
+  }
+
+  graph.remove_node(node_id);
+
+  BenchmarkResult result;
+  result.node_type = node_type;
+  result.shape = config->shape;
+  result.tiling = config->tiling;
+  result.mode = config->cm_cpu.mode == hmap::ForEachMode::VA_DISTRIBUTED ? "distributed"
+                                                                         : "single_array";
+  result.nrepeat = nrepeat;
+  result.median = get_percentile(timings, 0.5f);
+  result.p95 = get_percentile(timings, 0.95f);
+
+  if (result.median > 0.f)
+  {
+    float mbytes = float(std::max(noutputs, 1)) * float(config->shape.x) *
+                   float(config->shape.y) * sizeof(float) / (1024.f * 1024.f);
+    result.throughput = mbytes / (1e-3f * result.median);
+  }
+
+  return result;
+}
+
+static nlohmann::json results_to_json(const std::vector<BenchmarkResult> &results)
+{
+  nlohmann::json json = nlohmann::json::array();
+
+  for (auto &r : results)
+  {
+    nlohmann::json json_result;
+    json_result["node_type"] = r.node_type;
+    json_result["shape"] = {r.shape.x, r.shape.y};
+    json_result["tiling"] = {r.tiling.x, r.tiling.y};
+    json_result["mode"] = r.mode;
+    json_result["nrepeat"] = r.nrepeat;
+    json_result["median_ms"] = r.median;
+    json_result["p95_ms"] = r.p95;
+    json_result["throughput_mbps"] = r.throughput;
+    json.push_back(json_result);
+  }
+
+  return json;
+}
+
+static void write_results(const std::vector<BenchmarkResult> &results,
+                          const std::string                  &fname)
+{
+  if (std::filesystem::path(fname).extension() != ".csv")
+  {
+    nlohmann::json json;
+    json["benchmark"] = results_to_json(results);
+    json_to_file(json, fname);
+    return;
+  }
+
+  std::ofstream file(fname);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("run_benchmark: could not open file {}", fname);
+    return;
+  }
+
+  file << "node_type,shape_x,shape_y,tiling_x,tiling_y,mode,nrepeat,median_ms,p95_ms,"
+          "throughput_mbps\n";
+
+  for (auto &r : results)
+    file << std::format("{},{},{},{},{},{},{},{},{},{}\n",
+                        r.node_type,
+                        r.shape.x,
+                        r.shape.y,
+                        r.tiling.x,
+                        r.tiling.y,
+                        r.mode,
+                        r.nrepeat,
+                        r.median,
+                        r.p95,
+                        r.throughput);
+}
+
+static int compare_with_baseline(const std::vector<BenchmarkResult> &results,
+                                 const std::string                  &baseline_fname,
+                                 float                               tolerance)
+{
+  nlohmann::json json = json_from_file(baseline_fname);
+
+  if (!json.contains("benchmark"))
+  {
+    Logger::log()->error("run_benchmark: no benchmark data in baseline file {}",
+                         baseline_fname);
+    return 0;
+  }
+
+  // baseline medians by key
+  std::map<std::string, float> baseline;
+
+  for (auto &json_result : json["benchmark"])
+  {
+    BenchmarkResult r;
+    r.node_type = json_result["node_type"].get<std::string>();
+    r.shape = {json_result["shape"][0].get<int>(), json_result["shape"][1].get<int>()};
+    r.tiling = {json_result["tiling"][0].get<int>(), json_result["tiling"][1].get<int>()};
+    r.mode = json_result["mode"].get<std::string>();
+    baseline[r.get_key()] = json_result["median_ms"].get<float>();
+  }
+
+  int nregressions = 0;
+
+  for (auto &r : results)
+  {
+    auto it = baseline.find(r.get_key());
+    if (it == baseline.end() || it->second <= 0.f)
+      continue;
+
+    float ratio = r.median / it->second;
+
+    if (ratio > 1.f + tolerance)
+    {
+      Logger::log()->warn("regression: {}: {:.2f} ms vs {:.2f} ms (x{:.2f})",
+                          r.get_key(),
+                          r.median,
+                          it->second,
+                          ratio);
+      nregressions++;
+    }
+  }
+
+  Logger::log()->info("benchmark: {} regression(s) against baseline {} (tolerance {}%)",
+                      nregressions,
+                      baseline_fname,
+                      100.f * tolerance);
+
+  return nregressions;
+}
+
+// --- helpers (projects)
+
+struct ProjectNodeTiming
+{
+  int   count = 0;   // evaluations, broadcasts included
+  float total = 0.f; // ms
+};
+
+struct ProjectBenchmarkResult
+{
+  std::string                              project;
+  glm::ivec2                               shape;
+  glm::ivec2                               tiling;
+  size_t                                   nnodes = 0;
+  float                                    load = 0.f;    // ms, deserialization
+  float                                    update = 0.f;  // ms, whole graph update
+  float                                    flatten = 0.f; // ms, flatten and export
+  std::map<std::string, ProjectNodeTiming> node_timings; // by node type
+};
+
+static std::vector<std::filesystem::path> find_projects(
+    const std::vector<std::string> &dirs,
+    const std::string              &filter)
+{
+  std::vector<std::filesystem::path> projects;
+
+  for (auto &dir : dirs)
+  {
+    if (!std::filesystem::is_directory(dir))
+    {
+      Logger::log()->warn("run_project_benchmark: directory not found: {}", dir);
+      continue;
+    }
+
+    for (auto &entry : std::filesystem::directory_iterator(dir))
+    {
+      const std::filesystem::path &path = entry.path();
+
+      if (path.extension() != ".hsd")
+        continue;
+
+      if (!filter.empty() && path.stem().string().find(filter) == std::string::npos)
+        continue;
+
+      projects.push_back(path);
+    }
+  }
+
+  std::sort(projects.begin(), projects.end());
+  return projects;
+}
+
+static ProjectBenchmarkResult benchmark_project(const std::filesystem::path &fname,
+                                                GraphConfig                 &config)
+{
+  ProjectBenchmarkResult result;
+  result.project = fname.stem().string();
+  result.shape = config.shape;
+  result.tiling = config.tiling;
+
+  HSD_CTX.profiler.clear();
+
+  auto elapsed = [](std::chrono::steady_clock::time_point t0)
+  {
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<float, std::milli>(t1 - t0).count();
+  };
+
+  GraphManager graph_manager;
+
+  // load (without update)...
+  auto           t0 = std::chrono::steady_clock::now();
+  nlohmann::json json = json_from_file(fname.string());
+  graph_manager.json_from(json["graph_manager"], &config);
+  result.load = elapsed(t0);
+
+  // ...update, broadcasts and background exports included...
+  t0 = std::chrono::steady_clock::now();
+  graph_manager.update();
+  HSD_CTX.export_queue.flush();
+  result.update = elapsed(t0);
+
+  // ...and flatten export, redirected to a temporary directory
+  FlattenConfig export_param = graph_manager.get_export_param();
+
+  if (!export_param.export_path.empty())
+  {
+    std::filesystem::path export_dir = std::filesystem::temp_directory_path() /
+                                       "hesiod_benchmark";
+    std::filesystem::create_directories(export_dir);
+
+    export_param.export_path = export_dir / export_param.export_path.filename();
+    graph_manager.set_export_param(export_param);
+
+    t0 = std::chrono::steady_clock::now();
+    graph_manager.export_flatten();
+    result.flatten = elapsed(t0);
+  }
+
+  for (auto &[_, graph] : graph_manager.get_graph_nodes())
+    result.nnodes += graph->get_nodes().size();
+
+  for (auto &record : HSD_CTX.profiler.get_records())
+  {
+    ProjectNodeTiming &timing = result.node_timings[record.node_type];
+    timing.count++;
+    timing.total += 1e-3f * float(record.duration);
+  }
+
+  return result;
+}
+
+static void write_project_results(const std::vector<ProjectBenchmarkResult> &results,
+                                  const std::string                         &fname)
+{
+  if (std::filesystem::path(fname).extension() != ".csv")
+  {
+    nlohmann::json json_results = nlohmann::json::array();
+
+    for (auto &r : results)
+    {
+      nlohmann::json json_result;
+      json_result["project"] = r.project;
+      json_result["shape"] = {r.shape.x, r.shape.y};
+      json_result["tiling"] = {r.tiling.x, r.tiling.y};
+      json_result["nnodes"] = r.nnodes;
+      json_result["load_ms"] = r.load;
+      json_result["update_ms"] = r.update;
+      json_result["flatten_ms"] = r.flatten;
+
+      for (auto &[node_type, timing] : r.node_timings)
+      {
+        json_result["nodes"][node_type]["count"] = timing.count;
+        json_result["nodes"][node_type]["total_ms"] = timing.total;
+      }
+
+      json_results.push_back(json_result);
+    }
+
+    nlohmann::json json;
+    json["project_benchmark"] = json_results;
+    json_to_file(json, fname);
+    return;
+  }
+
+  // CSV, projects table and per-node breakdown in a second file
+  const std::string fname_nodes = insert_before_extension(fname, "_nodes").string();
+
+  std::ofstream file(fname);
+  std::ofstream file_nodes(fname_nodes);
+
+  if (!file.is_open() || !file_nodes.is_open())
+  {
+    Logger::log()->error("run_project_benchmark: could not open file {} or {}",
+                         fname,
+                         fname_nodes);
+    return;
+  }
+
+  file << "project,shape_x,shape_y,tiling_x,tiling_y,nnodes,load_ms,update_ms,"
+          "flatten_ms\n";
+  file_nodes << "project,shape_x,shape_y,tiling_x,tiling_y,node_type,count,total_ms\n";
+
+  for (auto &r : results)
+  {
+    file << std::format("{},{},{},{},{},{},{},{},{}\n",
+                        r.project,
+                        r.shape.x,
+                        r.shape.y,
+                        r.tiling.x,
+                        r.tiling.y,
+                        r.nnodes,
+                        r.load,
+                        r.update,
+                        r.flatten);
+
+    for (auto &[node_type, timing] : r.node_timings)
+      file_nodes << std::format("{},{},{},{},{},{},{},{}\n",
+                                r.project,
+                                r.shape.x,
+                                r.shape.y,
+                                r.tiling.x,
+                                r.tiling.y,
+                                node_type,
+                                timing.count,
+                                timing.total);
+  }
+}
+
+// --- functions
+
+int run_benchmark(const std::string      &fname,
+                  const std::vector<int> &shapes,
+                  int                     nrepeat,
+                  const std::string      &filter,
+                  const std::string      &baseline_fname,
+                  float                   tolerance)
+{
+  Logger::log()->info("executing Hesiod in benchmark mode");
+
+  // measure the node computations only
+  auto      &model_settings = HSD_CTX.app_settings.model;
+  const auto model_settings_bckp = model_settings;
+
+  model_settings.enable_node_cache = false;
+  model_settings.enable_tile_update = false;
+  model_settings.enable_profiling = false;
+
+  const std::vector<glm::ivec2> tilings = {{1, 1}, {4, 4}, {8, 8}};
+  const std::vector<hmap::ForEachMode> modes = {hmap::ForEachMode::VA_DISTRIBUTED,
+                                                hmap::ForEachMode::VA_SINGLE_ARRAY};
+
+  std::map<std::string, std::string> inventory = get_node_inventory();
+  std::vector<BenchmarkResult>       results;
+
+  for (int s : shapes)
+    for (auto &tiling : tilings)
+      for (auto mode : modes)
+      {
+        auto config = std::make_shared<GraphConfig>();
+        config->set_shape(glm::ivec2(s, s));
+        config->set_tiling(tiling);
+        config->set_overlap((tiling.x == 1 && tiling.y == 1) ? 0.f : 0.5f);
+        config->cm_cpu.mode = mode;
+
+        Logger::log()->info("benchmark: {}", config->info_string());
+
+        GraphNode graph("benchmark", config);
+
+        std::map<std::string, std::string> source_ids;
+        for (auto &[data_type, source_type] : get_source_node_types())
+          source_ids[data_type] = graph.add_node(source_type);
+
+        for (auto &[node_type, category] : inventory)
+        {
+          if (!is_benchmarkable(node_type, category))
+            continue;
+
+          if (!filter.empty() && node_type.find(filter) == std::string::npos)
+            continue;
+
+          auto result = benchmark_node(graph,
+                                       config,
+                                       node_type,
+                                       source_ids,
+                                       nrepeat);
+
+          if (!result)
+            continue;
+
+          Logger::log()->info("- {}: median {:.2f} ms, p95 {:.2f} ms, {:.1f} MB/s",
+                              result->get_key(),
+                              result->median,
+                              result->p95,
+                              result->throughput);
+
+          results.push_back(*result);
+        }
+      }
+
+  model_settings = model_settings_bckp;
+
+  write_results(results, fname);
+  Logger::log()->info("benchmark results written to {}", fname);
+
+  if (baseline_fname.empty())
+    return 0;
+
+  return compare_with_baseline(results, baseline_fname, tolerance);
+}
+
+int run_project_benchmark(const std::string              &fname,
+                          const std::vector<std::string> &dirs,
+                          const std::vector<int>         &shapes,
+                          const glm::ivec2               &tiling,
+                          const std::string              &filter)
+{
+  Logger::log()->info("executing Hesiod in project benchmark mode");
+
+  // time the actual computations, per-node timings are taken from the profiler
+  auto      &model_settings = HSD_CTX.app_settings.model;
+  const auto model_settings_bckp = model_settings;
+
+  model_settings.enable_node_cache = false;
+  model_settings.enable_tile_update = false;
+  model_settings.enable_profiling = true;
+
+  std::vector<std::filesystem::path>  projects = find_projects(dirs, filter);
+  std::vector<ProjectBenchmarkResult> results;
+
+  Logger::log()->info("benchmark: {} project(s)", projects.size());
+
+  for (int s : shapes)
+  {
+    GraphConfig config;
+    config.set_shape(glm::ivec2(s, s));
+    config.set_tiling(tiling);
+    config.set_overlap((tiling.x == 1 && tiling.y == 1) ? 0.f : 0.5f);
+
+    // release the memory between nodes, as in batch mode
+    config.cm_cpu.trim_storage = true;
+    config.cm_gpu.trim_storage = true;
+    config.cm_single_array.trim_storage = true;
+
+    for (auto &project : projects)
+    {
+      Logger::log()->info("benchmark: {}, shape {}x{}, tiling {}x{}",
+                          project.string(),
+                          s,
+                          s,
+                          tiling.x,
+                          tiling.y);
+
+      ProjectBenchmarkResult result = benchmark_project(project, config);
+
+      Logger::log()->info("- {} node(s), load {:.1f} ms, update {:.1f} ms, flatten {:.1f} "
+                          "ms",
+                          result.nnodes,
+                          result.load,
+                          result.update,
+                          result.flatten);
+
+      results.push_back(result);
+    }
+  }
+
+  model_settings = model_settings_bckp;
+  HSD_CTX.profiler.clear();
+
+  // summary table
+  Logger::log()->info("{:<40} {:>11} {:>8} {:>12} {:>12} {:>12}",
+                      "project",
+                      "shape",
+                      "nodes",
+                      "load (ms)",
+                      "update (ms)",
+                      "flatten (ms)");
+
+  for (auto &r : results)
+    Logger::log()->info("{:<40} {:>11} {:>8} {:>12.1f} {:>12.1f} {:>12.1f}",
+                        r.project,
+                        std::format("{}x{}", r.shape.x, r.shape.y),
+                        r.nnodes,
+                        r.load,
+                        r.update,
+                        r.flatten);
+
+  write_project_results(results, fname);
+  Logger::log()->info("project benchmark results written to {}", fname);
+
+  return 0;
+}
+
+} // namespace hesiod::cli
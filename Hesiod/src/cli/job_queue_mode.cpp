@@ -0,0 +1,361 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "hesiod/app/hesiod_application.hpp"
+#include "hesiod/cli/batch_mode.hpp"
+#include "hesiod/logger.hpp"
+#include "hesiod/model/graph/bake_config.hpp"
+#include "hesiod/model/profiler.hpp"
+#include "hesiod/model/utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace hesiod::cli
+{
+
+// --- helpers
+
+struct BatchJob
+{
+  fs::path    project;
+  glm::ivec2  shape = {1024, 1024};
+  glm::ivec2  tiling = {4, 4};
+  float       overlap = 0.5f;
+  uint        seed_offset = 0;
+  fs::path    output_dir;
+  std::string key; // identifies the job in the state file
+
+  std::string get_label() const
+  {
+    return std::format("{} {}x{} (seed offset {})",
+                       this->project.stem().string(),
+                       this->shape.x,
+                       this->shape.y,
+                       this->seed_offset);
+  }
+};
+
+static fs::path resolve_path(const fs::path &path, const fs::path &base_dir)
+{
+  return path.is_relative() ? base_dir / path : path;
+}
+
+static void finalize_job(BatchJob &job, const fs::path &base_dir, size_t index)
+{
+  job.project = resolve_path(job.project, base_dir);
+
+  if (job.output_dir.empty())
+    job.output_dir = std::format("{}_job_{}", job.project.stem().string(), index);
+
+  job.output_dir = resolve_path(job.output_dir, base_dir);
+
+  job.key = std::format("{:016x}",
+                        hash_string(std::format("{}/{}/{}/{}/{}/{}/{}/{}",
+                                                job.project.string(),
+                                                job.shape.x,
+                                                job.shape.y,
+                                                job.tiling.x,
+                                                job.tiling.y,
+                                                job.overlap,
+                                                job.seed_offset,
+                                                job.output_dir.string())));
+}
+
+// CSV header: project,shape_x,shape_y,tiling_x,tiling_y,overlap,seed_offset,output_dir
+// (any column but the project can be omitted)
+static std::vector<BatchJob> read_manifest_csv(const fs::path &fname)
+{
+  std::vector<BatchJob> jobs;
+  std::ifstream         file(fname);
+  std::string           line;
+
+  auto split = [](const std::string &str)
+  {
+    std::vector<std::string> tokens;
+    std::stringstream        ss(str);
+    std::string              token;
+
+    while (std::getline(ss, token, ','))
+      tokens.push_back(token);
+
+    return tokens;
+  };
+
+  if (!std::getline(file, line))
+    return jobs;
+
+  std::vector<std::string> header = split(line);
+  size_t                   row = 1; // header
+
+  while (std::getline(file, line))
+  {
+    row++;
+
+    if (line.empty())
+      continue;
+
+    std::vector<std::string> tokens = split(line);
+    BatchJob                 job;
+
+    try
+    {
+      for (size_t k = 0; k < std::min(header.size(), tokens.size()); ++k)
+      {
+        const std::string &col = header[k];
+        const std::string &value = tokens[k];
+
+        if (value.empty())
+          continue;
+
+        if (col == "project")
+          job.project = value;
+        else if (col == "shape_x")
+          job.shape.x = std::stoi(value);
+        else if (col == "shape_y")
+          job.shape.y = std::stoi(value);
+        else if (col == "tiling_x")
+          job.tiling.x = std::stoi(value);
+        else if (col == "tiling_y")
+          job.tiling.y = std::stoi(value);
+        else if (col == "overlap")
+          job.overlap = std::stof(value);
+        else if (col == "seed_offset")
+          job.seed_offset = static_cast<uint>(std::stoul(value));
+        else if (col == "output_dir")
+          job.output_dir = value;
+      }
+    }
+    catch (const std::exception &e)
+    {
+      Logger::log()->error("run_job_queue: {}: row {} skipped, invalid value: {}",
+                           fname.string(),
+                           row,
+                           e.what());
+      continue;
+    }
+
+    jobs.push_back(job);
+  }
+
+  return jobs;
+}
+
+// JSON: {"jobs": [{"project": "a.hsd", "shape": [2048, 2048], "tiling": [4, 4],
+// "overlap": 0.5, "seed_offset": 1, "output_dir": "out"}, ...]}
+static std::vector<BatchJob> read_manifest_json(const fs::path &fname)
+{
+  std::vector<BatchJob> jobs;
+  nlohmann::json        json = json_from_file(fname.string());
+
+  if (!json.contains("jobs"))
+  {
+    Logger::log()->error("run_job_queue: missing key \"jobs\" in {}", fname.string());
+    return jobs;
+  }
+
+  size_t row = 0;
+
+  for (auto &json_job : json["jobs"])
+  {
+    row++;
+
+    BatchJob job;
+
+    try
+    {
+      job.project = json_job.value("project", "");
+      job.overlap = json_job.value("overlap", job.overlap);
+      job.seed_offset = json_job.value("seed_offset", job.seed_offset);
+      job.output_dir = json_job.value("output_dir", "");
+
+      if (json_job.contains("shape"))
+        job.shape = {json_job["shape"].at(0).get<int>(),
+                     json_job["shape"].at(1).get<int>()};
+
+      if (json_job.contains("tiling"))
+        job.tiling = {json_job["tiling"].at(0).get<int>(),
+                      json_job["tiling"].at(1).get<int>()};
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+      Logger::log()->error("run_job_queue: {}: job {} skipped, invalid value: {}",
+                           fname.string(),
+                           row,
+                           e.what());
+      continue;
+    }
+
+    jobs.push_back(job);
+  }
+
+  return jobs;
+}
+
+static std::set<std::string> read_state(const fs::path &fname)
+{
+  std::set<std::string> done;
+
+  if (!fs::exists(fname))
+    return done;
+
+  nlohmann::json json = json_from_file(fname.string());
+
+  if (json.contains("done"))
+    for (auto &key : json["done"])
+      done.insert(key.get<std::string>());
+
+  return done;
+}
+
+static void write_state(const fs::path &fname, const std::set<std::string> &done)
+{
+  nlohmann::json json;
+  json["done"] = done;
+
+  // write then rename, a crash never leaves a truncated state file
+  const fs::path fname_tmp = fname.string() + ".tmp";
+  json_to_file(json, fname_tmp.string());
+
+  std::error_code ec;
+  fs::rename(fname_tmp, fname, ec);
+
+  if (ec)
+    Logger::log()->error("run_job_queue: could not write state file {}: {}",
+                         fname.string(),
+                         ec.message());
+}
+
+static bool run_job(const BatchJob &job)
+{
+  Logger::log()->info("job started: {}", job.get_label());
+
+  try
+  {
+    fs::create_directories(job.output_dir);
+
+    // work on a copy, with the export paths redirected to the output directory...
+    const fs::path fname = job.output_dir / "hesiod_job.hsd";
+    fs::copy_file(job.project, fname, fs::copy_options::overwrite_existing);
+
+    BakeConfig bake_settings;
+    bake_settings.resolution = job.shape.x;
+    bake_settings.rename_export_files = false;
+
+    override_export_nodes_settings(fname.string(),
+                                   job.output_dir,
+                                   job.seed_offset,
+                                   bake_settings);
+
+    // ...including the flatten export
+    nlohmann::json json = json_from_file(fname.string());
+    nlohmann::json &json_export = json["graph_manager"]["export_param"];
+
+    if (json_export.contains("export_path") &&
+        !json_export["export_path"].get<std::string>().empty())
+    {
+      fs::path export_path = json_export["export_path"].get<std::string>();
+      json_export["export_path"] = (job.output_dir / export_path.filename()).string();
+      json_to_file(json, fname.string());
+    }
+
+    // distributed modes, the memory estimate of the scheduler relies on it
+    GraphConfig input_config;
+    input_config.cm_cpu.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+    input_config.cm_gpu.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+
+    // exports are written by the job itself, the memory estimate does not account for
+    // export snapshots. Its own queue so that the flush only reports its own exports
+    ExportQueue export_queue(1);
+
+    if (!run_batch_mode(fname.string(),
+                        job.shape,
+                        job.tiling,
+                        job.overlap,
+                        &input_config,
+                        &export_queue,
+                        false))
+    {
+      Logger::log()->error("job failed: {}: export failure(s)", job.get_label());
+      return false;
+    }
+  }
+  catch (const std::exception &e)
+  {
+    Logger::log()->error("job failed: {}: {}", job.get_label(), e.what());
+    return false;
+  }
+
+  Logger::log()->info("job done: {}", job.get_label());
+  return true;
+}
+
+// --- function
+
+int run_job_queue(const std::string &manifest_fname, const std::string &state_fname)
+{
+  Logger::log()->info("executing Hesiod in job queue mode");
+
+  const fs::path manifest_path = manifest_fname;
+  const fs::path state_path = state_fname.empty() ? manifest_fname + ".state.json"
+                                                  : fs::path(state_fname);
+
+  std::vector<BatchJob> jobs = manifest_path.extension() == ".csv"
+                                   ? read_manifest_csv(manifest_path)
+                                   : read_manifest_json(manifest_path);
+
+  for (size_t k = 0; k < jobs.size(); ++k)
+    finalize_job(jobs[k], manifest_path.parent_path(), k);
+
+  // jobs already completed by a previous (interrupted) run
+  std::set<std::string> done = read_state(state_path);
+
+  Logger::log()->info("{} job(s), {} already done",
+                      jobs.size(),
+                      std::count_if(jobs.begin(),
+                                    jobs.end(),
+                                    [&](const BatchJob &job)
+                                    { return done.contains(job.key); }));
+
+  // one job at a time: each job already uses all the cores through the tiles, and the
+  // graph evaluations (GPU nodes in particular) are not safe to run concurrently. The
+  // jobs share the process, and so the import cache
+  int nfailed = 0;
+
+  for (const BatchJob &job : jobs)
+  {
+    if (done.contains(job.key))
+      continue;
+
+    if (size_t available = get_available_memory();
+        available > 0 && estimate_batch_memory(job.shape) > available)
+      Logger::log()->warn("job {}: estimated memory above the available memory",
+                          job.get_label());
+
+    if (run_job(job))
+    {
+      done.insert(job.key);
+      write_state(state_path, done);
+    }
+    else
+    {
+      nfailed++;
+    }
+  }
+
+  Logger::log()->info("job queue terminated, {} failed job(s), imported files: {} "
+                      "decoded, {} reused",
+                      nfailed,
+                      HSD_CTX.import_cache.get_nmisses(),
+                      HSD_CTX.import_cache.get_nhits());
+
+  return nfailed > 0 ? 1 : 0;
+}
+
+} // namespace hesiod::cli
@@ -128,6 +128,46 @@ void AppSettingsWindow::setup_layout()
                   ctx.app_settings.global.save_backup_file);
   this->add_description("\n");
 
+  // --- Computation
+
+  this->add_title("Computation");
+
+  this->bind_bool("Compute independent nodes in parallel",
+                  ctx.app_settings.model.enable_parallel_update);
+  this->bind_bool("Report node updates in a deterministic order",
+                  ctx.app_settings.model.deterministic_update_order);
+  this->bind_bool("Update the graph in the background",
+                  ctx.app_settings.model.enable_async_update);
+  this->bind_bool("Only recompute the tiles affected by an edit",
+                  ctx.app_settings.model.enable_tile_update);
+  this->bind_bool("Show a low resolution preview before the full update",
+                  ctx.app_settings.model.enable_progressive_update);
+  this->bind_bool("Reuse node outputs when parameters and inputs are unchanged",
+                  ctx.app_settings.model.enable_node_cache);
+  this->bind_bool("Keep node outputs on disk between sessions",
+                  ctx.app_settings.model.enable_disk_cache);
+  this->bind_bool("Save computed node outputs with the project",
+                  ctx.app_settings.model.enable_node_data_store);
+  this->bind_bool("Compress the saved node outputs",
+                  ctx.app_settings.model.node_data_compression);
+  this->bind_bool("Record node evaluations for profiling",
+                  ctx.app_settings.model.enable_profiling);
+  this->bind_bool("Write exported files in the background",
+                  ctx.app_settings.model.enable_async_export);
+  this->add_description("Parallel updates are experimental: nodes relying on the GPU "
+                        "may not support concurrent execution.");
+  this->add_description("Background updates keep the interface responsive while "
+                        "editing, a new edit cancels the ongoing update.");
+  this->add_description("The low resolution preview requires background updates.");
+  this->add_description("Tile updates only apply to nodes working tile by tile, the "
+                        "other nodes are fully recomputed. The check recomputes "
+                        "them fully after each partial update and logs the tiles "
+                        "that differ.");
+  this->add_description("Saved node outputs are stored next to the project file and "
+                        "reused when the project is reopened, as long as the node "
+                        "parameters and inputs are unchanged.");
+  this->add_description("\n");
+
   // --- Interface
 
   this->add_title("Interface");
@@ -146,6 +186,8 @@ void AppSettingsWindow::setup_layout()
 
   this->bind_bool("Add border skirt to the heightmap",
                   ctx.app_settings.viewer.add_heighmap_skirt);
+  this->bind_bool("Adapt the heightmap mesh resolution to the viewport",
+                  ctx.app_settings.viewer.enable_mesh_lod);
 
   // --- Reset
 
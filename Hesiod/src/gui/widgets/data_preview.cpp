@@ -1,10 +1,17 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
 #include <typeinfo>
 
 #include <QCoreApplication>
+#include <QEvent>
+#include <QGraphicsProxyWidget>
+#include <QGraphicsScene>
+#include <QGraphicsView>
 #include <QMenu>
 #include <QPainter>
 
@@ -16,10 +23,47 @@
 #include "hesiod/app/hesiod_application.hpp"
 #include "hesiod/gui/widgets/data_preview.hpp"
 #include "hesiod/logger.hpp"
+#include "hesiod/model/thread_pool.hpp"
 
 namespace hesiod
 {
 
+// shared by the previews and their rendering tasks
+struct PreviewRenderState
+{
+  std::mutex            mutex;
+  DataPreview          *p_preview = nullptr; // nullptr once the preview is destroyed
+  std::atomic<uint64_t> generation = 0;      // latest request
+};
+
+// data to render. Small data is copied on the GUI thread, heightmaps and textures are
+// read by the rendering tasks (see read_node_data)
+struct PreviewData
+{
+  std::string                           data_type;
+  std::weak_ptr<BaseNode>               model;           // heightmap and texture
+  int                                   port_index = -1; // idem
+  std::shared_ptr<const PreviewPyramid> sp_pyramid;      // heightmap
+  hmap::Array                           array;           // array, at the preview shape
+  std::vector<uint8_t>                  texture_img;
+  std::shared_ptr<const hmap::Cloud>    sp_cloud;
+  std::shared_ptr<const hmap::Path>     sp_path;
+};
+
+// --- helper(s)
+
+static QImage build_preview_image(const PreviewData &data,
+                                  PreviewType        preview_type,
+                                  const glm::ivec2  &shape);
+static bool   read_node_data(PreviewData &data, const glm::ivec2 &shape);
+
+static ThreadPool &get_preview_pool()
+{
+  // leave some room to the graph evaluation
+  static ThreadPool pool(std::max(size_t(1), get_default_thread_count() / 2));
+  return pool;
+}
+
 DataPreview::DataPreview(std::weak_ptr<BaseNode> model, QWidget *parent)
     : QLabel(parent), model(model)
 {
@@ -40,6 +84,25 @@ DataPreview::DataPreview(std::weak_ptr<BaseNode> model, QWidget *parent)
   this->setFrameStyle(QFrame::NoFrame);
   this->setStyleSheet("QLabel { background-color : gray; }");
 
+  // rendering
+  this->render_state = std::make_shared<PreviewRenderState>();
+  this->render_state->p_preview = this;
+
+  // updates are coalesced, at most one per frame
+  this->update_timer = new QTimer(this);
+  this->update_timer->setSingleShot(true);
+  this->update_timer->setInterval(16);
+
+  this->connect(this->update_timer,
+                &QTimer::timeout,
+                [this]()
+                {
+                  // hidden previews are rendered when shown, and previews out of the
+                  // node editor view when scrolled into it
+                  if (this->is_in_viewport())
+                    this->render_preview();
+                });
+
   // Select first output, or fallback to first port
   this->preview_port_index = 0;
   for (int k = 0; k < p_model->get_nports(); ++k)
@@ -52,8 +115,26 @@ DataPreview::DataPreview(std::weak_ptr<BaseNode> model, QWidget *parent)
   this->update_preview();
 }
 
+DataPreview::~DataPreview()
+{
+  if (this->render_state)
+  {
+    std::lock_guard<std::mutex> lock(this->render_state->mutex);
+    this->render_state->p_preview = nullptr;
+  }
+}
+
 void DataPreview::clear_preview()
 {
+  // drop the pending and ongoing renderings
+  this->is_update_pending = false;
+
+  if (this->update_timer)
+    this->update_timer->stop();
+
+  if (this->render_state)
+    this->render_state->generation++;
+
   AppContext &ctx = HSD_CTX;
   const auto  shape = glm::ivec2(ctx.app_settings.node_editor.preview_w,
                                 ctx.app_settings.node_editor.preview_h);
@@ -119,14 +200,55 @@ void DataPreview::contextMenuEvent(QContextMenuEvent *event)
   }
 }
 
+bool DataPreview::eventFilter(QObject *watched, QEvent *event)
+{
+  // view repainted (scrolled, zoomed...), a deferred update may now be visible
+  if (event->type() == QEvent::Paint && this->is_update_pending && this->update_timer &&
+      !this->update_timer->isActive())
+    this->update_timer->start();
+
+  return QLabel::eventFilter(watched, event);
+}
+
 const QPixmap &DataPreview::get_preview_pixmap() const { return this->preview_pixmap; }
 
-void DataPreview::update_preview()
+bool DataPreview::is_in_viewport()
+{
+  if (!this->isVisible())
+    return false;
+
+  // embedded in a graphics scene (node body), isVisible() does not account for the
+  // views. The views are watched so that the update is resumed when they change
+  QGraphicsProxyWidget *p_proxy = this->window()->graphicsProxyWidget();
+
+  if (!p_proxy || !p_proxy->scene())
+    return !this->visibleRegion().isEmpty();
+
+  const QRectF rect = p_proxy->mapRectToScene(
+      QRectF(this->mapTo(this->window(), QPoint(0, 0)), QSizeF(this->size())));
+
+  for (QGraphicsView *p_view : p_proxy->scene()->views())
+  {
+    p_view->viewport()->installEventFilter(this);
+
+    const QRectF view_rect = p_view->mapToScene(p_view->viewport()->rect())
+                                 .boundingRect();
+
+    if (p_view->isVisible() && view_rect.intersects(rect))
+      return true;
+  }
+
+  return false;
+}
+
+void DataPreview::render_preview()
 {
+  this->is_update_pending = false;
+
   auto p_model = this->model.lock();
   if (!p_model)
   {
-    Logger::log()->error("DataPreview::update_preview: p_model_node is nullptr");
+    Logger::log()->error("DataPreview::render_preview: p_model_node is nullptr");
     return;
   }
 
@@ -137,8 +259,121 @@ void DataPreview::update_preview()
   const auto  shape = glm::ivec2(ctx.app_settings.node_editor.preview_w,
                                 ctx.app_settings.node_editor.preview_h);
 
-  Logger::log()->trace("DataPreview::update_preview, data_type: {}", data_type);
+  Logger::log()->trace("DataPreview::render_preview, data_type: {}", data_type);
+
+  // ---- Gather the data (cheap: small data only) ----
+
+  PreviewData data;
+  data.data_type = data_type;
+
+  // read by the rendering task, heightmaps through their preview pyramid
+  const bool is_large = data_type == typeid(hmap::VirtualArray).name() ||
+                        data_type == typeid(hmap::VirtualTexture).name();
+
+  // the data cannot be read while it is being computed (the preview is updated again
+  // once the compute is finished)
+  std::shared_lock<std::shared_mutex> data_lock;
 
+  if (!is_large)
+  {
+    data_lock = p_model->try_lock_data(preview_port_index);
+    if (!data_lock.owns_lock())
+      return;
+  }
+
+  if (blind_ptr)
+  {
+    if (is_large)
+    {
+      data.model = this->model;
+      data.port_index = preview_port_index;
+    }
+    else if (data_type == typeid(hmap::Array).name())
+    {
+      const hmap::Array *p_a = static_cast<const hmap::Array *>(blind_ptr);
+      data.array = p_a->resample_to_shape_nearest(shape);
+    }
+    else if (data_type == typeid(hmap::Cloud).name())
+    {
+      const hmap::Cloud *p_cloud = static_cast<const hmap::Cloud *>(blind_ptr);
+      data.sp_cloud = std::make_shared<const hmap::Cloud>(*p_cloud);
+    }
+    else if (data_type == typeid(hmap::Path).name())
+    {
+      const hmap::Path *p_path = static_cast<const hmap::Path *>(blind_ptr);
+      data.sp_path = std::make_shared<const hmap::Path>(*p_path);
+    }
+  }
+
+  if (data_lock.owns_lock())
+    data_lock.unlock();
+
+  // ---- Render in the background, the latest request wins ----
+
+  std::shared_ptr<PreviewRenderState> sp_state = this->render_state;
+  const uint64_t                      generation = ++sp_state->generation;
+  const PreviewType                   type = this->preview_type;
+
+  get_preview_pool().submit(
+      [sp_state, data = std::move(data), type, shape, generation]() mutable
+      {
+        if (sp_state->generation != generation || !read_node_data(data, shape))
+          return;
+
+        QImage image = build_preview_image(data, type, shape);
+
+        // the preview cannot be destroyed while the result is posted
+        std::lock_guard<std::mutex> lock(sp_state->mutex);
+
+        if (!sp_state->p_preview || sp_state->generation != generation)
+          return;
+
+        DataPreview *p_preview = sp_state->p_preview;
+
+        QMetaObject::invokeMethod(
+            p_preview,
+            [p_preview, image, generation]()
+            { p_preview->set_preview_image(image, generation); },
+            Qt::QueuedConnection);
+      });
+}
+
+void DataPreview::set_preview_image(const QImage &image, uint64_t generation)
+{
+  // superseded meanwhile
+  if (generation != this->render_state->generation)
+    return;
+
+  this->preview_pixmap = QPixmap::fromImage(image);
+  this->setPixmap(this->preview_pixmap);
+  this->update();
+}
+
+void DataPreview::showEvent(QShowEvent *event)
+{
+  QLabel::showEvent(event);
+
+  if (this->is_update_pending && this->update_timer)
+    this->update_timer->start();
+}
+
+void DataPreview::update_preview()
+{
+  if (!this->update_timer)
+    return;
+
+  this->is_update_pending = true;
+
+  if (!this->update_timer->isActive())
+    this->update_timer->start();
+}
+
+// --- helper(s)
+
+QImage build_preview_image(const PreviewData &data,
+                           PreviewType        preview_type,
+                           const glm::ivec2  &shape)
+{
   QImage::Format       img_format = QImage::Format_Grayscale8;
   std::vector<uint8_t> img;
 
@@ -150,34 +385,13 @@ void DataPreview::update_preview()
     return hmap::colorize(array, minv, maxv, cmap, normalize).to_img_8bit();
   };
 
-  if (blind_ptr)
+  // ---- Heightmap or Array ----
+  if (data.data_type == typeid(hmap::VirtualArray).name() ||
+      data.data_type == typeid(hmap::Array).name())
   {
-    // ---- Heightmap or Array ----
-    if (data_type == typeid(hmap::VirtualArray).name() ||
-        data_type == typeid(hmap::Array).name())
-    {
-      hmap::Array array;
-
-      if (data_type == typeid(hmap::VirtualArray).name())
-      {
-        const hmap::VirtualArray *p_va = static_cast<const hmap::VirtualArray *>(
-            blind_ptr);
-        if (p_va)
-        {
-          array = p_va->to_array(shape, p_model->cfg().cm_cpu);
-        }
-        else
-          Logger::log()->error("DataPreview::update_preview: VirtualArray nullptr");
-      }
-      else
-      {
-        const hmap::Array *p_a = static_cast<const hmap::Array *>(blind_ptr);
-        if (p_a)
-          array = p_a->resample_to_shape_nearest(shape);
-        else
-          Logger::log()->error("DataPreview::update_preview: Array nullptr");
-      }
+    hmap::Array array = data.sp_pyramid ? data.sp_pyramid->get_array(shape) : data.array;
 
+    if (array.shape == shape)
       switch (preview_type)
       {
       case PreviewType::GRAYSCALE:
@@ -201,76 +415,52 @@ void DataPreview::update_preview()
         img_format = QImage::Format_RGB888;
         break;
       }
-    }
-    // ---- Texture ----
-    else if (data_type == typeid(hmap::VirtualTexture).name())
-    {
-      const hmap::VirtualTexture *p_h = static_cast<const hmap::VirtualTexture *>(
-          blind_ptr);
-      if (p_h)
-      {
-        img = p_h->to_img_8bit(shape, p_model->cfg().cm_cpu);
-        img_format = QImage::Format_RGBA8888;
-      }
-      else
-        Logger::log()->error("DataPreview::update_preview: VirtualTexture nullptr");
-    }
-    // ---- Cloud ----
-    else if (data_type == typeid(hmap::Cloud).name())
-    {
-      const hmap::Cloud *p_cloud = static_cast<const hmap::Cloud *>(blind_ptr);
-      if (p_cloud && p_cloud->size() > 0)
-      {
-        hmap::Array array(shape);
-        p_cloud->to_array(array);
-        img = build_colored_array(array, hmap::Cmap::MAGMA, /* normalize */ false);
-        img_format = QImage::Format_RGB888;
-      }
-      else
-        Logger::log()->error("DataPreview::update_preview: Cloud nullptr or empty");
-    }
-    // ---- Path ----
-    else if (data_type == typeid(hmap::Path).name())
-    {
-      const hmap::Path *p_path = static_cast<const hmap::Path *>(blind_ptr);
-      if (p_path && p_path->size() > 0)
-      {
-        hmap::Array array(shape);
-        glm::vec4   bbox(0.f, 1.f, 0.f, 1.f);
-        hmap::Path  path = *p_path;
-        path.remap_values(0.1f, 1.f);
-        path.to_array(array, bbox);
-        img = build_colored_array(array, hmap::Cmap::MAGMA, /* normalize */ false);
-        img_format = QImage::Format_RGB888;
-      }
-      else
-        Logger::log()->error("DataPreview::update_preview: Path nullptr or empty");
-    }
+  }
+  // ---- Texture ----
+  else if (data.data_type == typeid(hmap::VirtualTexture).name())
+  {
+    img = data.texture_img;
+    img_format = QImage::Format_RGBA8888;
+  }
+  // ---- Cloud ----
+  else if (data.sp_cloud && data.sp_cloud->size() > 0)
+  {
+    hmap::Array array(shape);
+    data.sp_cloud->to_array(array);
+    img = build_colored_array(array, hmap::Cmap::MAGMA, /* normalize */ false);
+    img_format = QImage::Format_RGB888;
+  }
+  // ---- Path ----
+  else if (data.sp_path && data.sp_path->size() > 0)
+  {
+    hmap::Array array(shape);
+    glm::vec4   bbox(0.f, 1.f, 0.f, 1.f);
+    hmap::Path  path = *data.sp_path;
+    path.remap_values(0.1f, 1.f);
+    path.to_array(array, bbox);
+    img = build_colored_array(array, hmap::Cmap::MAGMA, /* normalize */ false);
+    img_format = QImage::Format_RGB888;
   }
 
   // ---- Build final QImage safely (copying data) ----
 
   QImage image;
 
-  if (!img.empty())
-  {
-    size_t nchannels = (img_format == QImage::Format_Grayscale8) ? 1
-                       : (img_format == QImage::Format_RGB888)   ? 3
-                                                                 : 4;
-
-    if (img.size() != static_cast<size_t>(shape.x * shape.y * nchannels))
-    {
-      Logger::log()->critical(
-          "DataPreview::update_preview: inconsistent image buffer size");
-      throw std::runtime_error("DataPreview::update_preview: inconsistent buffer size");
-    }
+  size_t nchannels = (img_format == QImage::Format_Grayscale8) ? 1
+                     : (img_format == QImage::Format_RGB888)   ? 3
+                                                               : 4;
 
+  if (!img.empty() && img.size() == static_cast<size_t>(shape.x * shape.y * nchannels))
+  {
     // Copy buffer to QImage that owns its data
     image = QImage(shape.x, shape.y, img_format);
     std::memcpy(image.bits(), img.data(), img.size());
   }
   else
   {
+    if (!img.empty())
+      Logger::log()->critical("build_preview_image: inconsistent image buffer size");
+
     image = QImage(shape.x, shape.y, img_format);
     image.fill(Qt::transparent);
   }
@@ -278,17 +468,46 @@ void DataPreview::update_preview()
   image = image.mirrored(false, true); // (horizontal, vertical)
 
   // ---- Draw border ----
-  preview_pixmap = QPixmap::fromImage(image);
+  image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
   {
-    QPainter painter(&preview_pixmap);
+    QPainter painter(&image);
     QPen     pen(Qt::black);
     pen.setWidth(1);
     painter.setPen(pen);
-    painter.drawRect(0, 0, preview_pixmap.width() - 1, preview_pixmap.height() - 1);
+    painter.drawRect(0, 0, image.width() - 1, image.height() - 1);
   }
 
-  this->setPixmap(this->preview_pixmap);
-  this->update();
+  return image;
+}
+
+bool read_node_data(PreviewData &data, const glm::ivec2 &shape)
+{
+  if (data.port_index < 0)
+    return true;
+
+  auto p_model = data.model.lock();
+  if (!p_model)
+    return false;
+
+  if (data.data_type == typeid(hmap::VirtualArray).name())
+  {
+    // reduced copy, built on the first request after each node update
+    data.sp_pyramid = p_model->get_preview_pyramid(data.port_index);
+    return data.sp_pyramid != nullptr;
+  }
+  else if (data.data_type == typeid(hmap::VirtualTexture).name())
+  {
+    auto data_lock = p_model->try_lock_data(data.port_index);
+    auto p_texture = static_cast<const hmap::VirtualTexture *>(
+        p_model->get_data_ref(data.port_index));
+
+    if (!data_lock.owns_lock() || !p_texture)
+      return false;
+
+    data.texture_img = p_texture->to_img_8bit(shape, p_model->cfg().cm_cpu);
+  }
+
+  return true;
 }
 
 } // namespace hesiod
@@ -367,10 +367,11 @@ nlohmann::json GraphNodeWidget::json_import(nlohmann::json const &json, QPointF
         this->add_link(node_id_from, port_out_id, node_id_to, port_in_id);
 
         // add model link
+        auto lock = gno->suspend_async_update();
         gno->new_link(node_id_from, port_out_id, node_id_to, port_in_id);
       }
 
-    gno->update();
+    gno->request_update();
   }
 
   return json_copy;
@@ -413,13 +414,16 @@ void GraphNodeWidget::on_connection_deleted(const std::string &id_out,
   // see GraphNodeWidget::on_node_deleted
   QCoreApplication::processEvents();
 
-  gno->remove_link(id_out, port_id_out, id_in, port_id_in);
+  {
+    auto lock = gno->suspend_async_update();
+    gno->remove_link(id_out, port_id_out, id_in, port_id_in);
+  }
 
   // see GraphNodeWidget::on_node_deleted
   QCoreApplication::processEvents();
 
   if (!prevent_graph_update)
-    gno->update(id_in);
+    gno->request_update(id_in);
 
   this->set_enabled(true);
 }
@@ -492,12 +496,15 @@ void GraphNodeWidget::on_connection_finished(const std::string &id_out,
   if (!gno)
     return;
 
-  gno->new_link(id_out, port_id_out, id_in, port_id_in);
+  {
+    auto lock = gno->suspend_async_update();
+    gno->new_link(id_out, port_id_out, id_in, port_id_in);
+  }
 
   // no update for instance during deserialization to avoid a full
   // graph update at each link creation
   if (this->update_node_on_connection_finished)
-    gno->update(id_in);
+    gno->request_update(id_in);
 }
 
 void GraphNodeWidget::on_graph_clear_request()
@@ -628,7 +635,7 @@ void GraphNodeWidget::on_graph_reload_request()
   if (!gno)
     return;
 
-  gno->update();
+  gno->request_update();
 }
 
 void GraphNodeWidget::on_graph_settings_request()
@@ -766,7 +773,7 @@ void GraphNodeWidget::on_node_reload_request(const std::string &node_id)
   if (!gno)
     return;
 
-  gno->update(node_id);
+  gno->request_update(node_id);
 }
 
 void GraphNodeWidget::on_node_right_clicked(const std::string &node_id, QPointF scene_pos)
@@ -1122,29 +1129,51 @@ void GraphNodeWidget::setup_connections()
                   }
                 });
 
-  // GraphNode
+  // GraphNode, the graph can be updated from a background thread,
+  // the signals are always emitted from the GUI thread (queued if
+  // needed)
   gno->update_started = [safe_this = QPointer(this)]()
   {
     if (safe_this)
-      Q_EMIT safe_this->update_started();
+      QMetaObject::invokeMethod(safe_this,
+                                [safe_this]()
+                                {
+                                  if (safe_this)
+                                    Q_EMIT safe_this->update_started();
+                                });
   };
 
   gno->update_finished = [safe_this = QPointer(this)]()
   {
     if (safe_this)
-      Q_EMIT safe_this->update_finished();
+      QMetaObject::invokeMethod(safe_this,
+                                [safe_this]()
+                                {
+                                  if (safe_this)
+                                    Q_EMIT safe_this->update_finished();
+                                });
   };
 
   gno->compute_started = [safe_this = QPointer(this)](const std::string &node_id)
   {
     if (safe_this)
-      Q_EMIT safe_this->compute_started(node_id);
+      QMetaObject::invokeMethod(safe_this,
+                                [safe_this, node_id]()
+                                {
+                                  if (safe_this)
+                                    Q_EMIT safe_this->compute_started(node_id);
+                                });
   };
 
   gno->compute_finished = [safe_this = QPointer(this)](const std::string &node_id)
   {
     if (safe_this)
-      Q_EMIT safe_this->compute_finished(node_id);
+      QMetaObject::invokeMethod(safe_this,
+                                [safe_this, node_id]()
+                                {
+                                  if (safe_this)
+                                    Q_EMIT safe_this->compute_finished(node_id);
+                                });
   };
 }
 
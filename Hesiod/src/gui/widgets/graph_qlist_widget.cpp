@@ -102,13 +102,13 @@ void GraphQListWidget::on_combobox_changed()
   if (!p_node)
     return;
 
-  hmap::VirtualArray *p_h = p_node->get_value_ref<hmap::VirtualArray>(port_id);
+  auto sp_pyramid = p_node->get_preview_pyramid(p_node->get_port_index(port_id));
 
-  if (p_h)
+  if (sp_pyramid)
   {
     // TODO hardcoded
     glm::ivec2  shape_img(256, 256);
-    hmap::Array array = p_h->to_array(shape_img, p_node->cfg().cm_cpu);
+    hmap::Array array = sp_pyramid->get_array(shape_img);
     img = hmap::colorize(array, array.min(), array.max(), hmap::Cmap::TURBO, true)
               .to_img_8bit();
     image = QImage(img.data(), shape_img.x, shape_img.y, QImage::Format_RGB888);
@@ -64,22 +64,30 @@ void MainWindow::setup_connections_with_project()
   }
 
   // GraphNode model -> MainWindow
+  // (progress can be reported from a background update, always
+  // refresh the widgets from the GUI thread)
   ctx.project_model->get_graph_manager_ref()->update_progress = [this](float progress)
   {
-    if (progress == 0.f || progress == 100.f)
-    {
-      this->progress_bar->setValue(0);
-      this->progress_bar->setTextVisible(false);
-
-      const std::string message = (progress == 0.f) ? "Updating graph..."
-                                                    : "Graph updated successfully.";
-
-      this->notify(message);
-      return;
-    }
-
-    this->progress_bar->setTextVisible(true);
-    this->progress_bar->setValue(static_cast<int>(progress));
+    QMetaObject::invokeMethod(
+        this,
+        [this, progress]()
+        {
+          if (progress == 0.f || progress == 100.f)
+          {
+            this->progress_bar->setValue(0);
+            this->progress_bar->setTextVisible(false);
+
+            const std::string message = (progress == 0.f)
+                                            ? "Updating graph..."
+                                            : "Graph updated successfully.";
+
+            this->notify(message);
+            return;
+          }
+
+          this->progress_bar->setTextVisible(true);
+          this->progress_bar->setValue(static_cast<int>(progress));
+        });
   };
 }
 
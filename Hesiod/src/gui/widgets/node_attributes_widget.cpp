@@ -83,7 +83,7 @@ QWidget *NodeAttributesWidget::create_toolbar()
                   if (!gno)
                     return;
 
-                  gno->update(this->node_id);
+                  gno->request_update(this->node_id);
                 });
 
   this->connect(info_btn,
@@ -173,7 +173,7 @@ void NodeAttributesWidget::setup_connections()
                   if (!gno)
                     return;
 
-                  gno->update(this->node_id);
+                  gno->request_update(this->node_id);
                 });
 
   this->connect(this->attributes_widget,
@@ -184,7 +184,7 @@ void NodeAttributesWidget::setup_connections()
                   if (!gno)
                     return;
 
-                  gno->update(this->node_id);
+                  gno->request_update(this->node_id);
                 });
 }
 
@@ -1,6 +1,7 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <QComboBox>
 #include <QDialogButtonBox>
 #include <QGridLayout>
 #include <QLabel>
@@ -198,6 +199,38 @@ void NodeInfoDialog::setup_layout()
     layout->addWidget(container);
   }
 
+  // --- heightmap probe (full resolution data fetched on demand)
+
+  {
+    std::vector<int> port_indices;
+
+    for (int k = 0; k < ptrs.node->get_nports(); k++)
+      if (ptrs.node->get_data_type(k) == typeid(hmap::VirtualArray).name())
+        port_indices.push_back(k);
+
+    if (!port_indices.empty())
+    {
+      QLabel *label = new QLabel("Probe");
+      layout->addWidget(label);
+
+      QComboBox *combo = new QComboBox(this);
+      for (int k : port_indices)
+        combo->addItem(ptrs.node->get_port_caption(k).c_str(), k);
+      layout->addWidget(combo);
+
+      this->probe = new RegionProbeWidget([this]()
+                                          { return this->get_node_pointers().node; },
+                                          this);
+      this->probe->set_port_index(port_indices.front());
+      layout->addWidget(this->probe);
+
+      this->connect(combo,
+                    &QComboBox::currentIndexChanged,
+                    [this, combo](int index)
+                    { this->probe->set_port_index(combo->itemData(index).toInt()); });
+    }
+  }
+
   // --- comment
 
   {
@@ -230,6 +263,10 @@ void NodeInfoDialog::update_content()
   Logger::log()->trace("NodeInfoDialog::update_content");
   this->update_ports_content();
   this->update_info_content();
+
+  if (this->probe)
+    this->probe->update_overview();
+
   this->update();
 }
 
@@ -261,6 +298,12 @@ void NodeInfoDialog::update_info_content()
       {"Created", timestamp(info.time_creation)},
       {"Last Update", timestamp(info.time_last_update)},
       {"Update Time", std::format("{:.1f} ms", info.update_time)},
+      {"- compute", std::format("{:.1f} ms", info.update_time - info.post_process_time)},
+      {"- post-process", std::format("{:.1f} ms", info.post_process_time)},
+      {"Tiles Computed", std::to_string(info.ntiles)},
+      {"Process RSS Delta", std::format("{:+.1f} MB", info.rss_delta)},
+      {"Process Peak RSS Delta", std::format("{:+.1f} MB", info.peak_rss_delta)},
+      {"CPU Usage (node, tiles)", std::format("{:.0f}%", 100.f * info.cpu_utilization)},
       {"Execution Count", std::to_string(info.eval_count)},
       {"Memory Usage", std::format("~{:.2f} MB", ptrs.node->get_memory_usage())},
       {"Address", ptr_as_string(static_cast<void *>(ptrs.node))},
@@ -51,11 +51,12 @@ void DebugNodeWidget::on_compute_finished()
 
   if (auto m = this->model.lock())
   {
+    auto                data_lock = m->try_lock_data(m->get_port_index("input"));
     hmap::VirtualArray *p_in = m->get_value_ref<hmap::VirtualArray>("input");
 
     std::string msg = "input:\n";
 
-    if (p_in)
+    if (p_in && data_lock.owns_lock())
     {
       float min = p_in->min(m->cfg().cm_cpu);
       float max = p_in->max(m->cfg().cm_cpu);
@@ -64,6 +65,10 @@ void DebugNodeWidget::on_compute_finished()
       msg += "- min: " + std::to_string(min) + "\n";
       msg += "- max: " + std::to_string(max) + "\n";
     }
+    else if (p_in)
+    {
+      msg += "not available (being computed)\n";
+    }
     else
     {
       msg += "addr: nullptr\n";
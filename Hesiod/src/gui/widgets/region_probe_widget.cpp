@@ -0,0 +1,296 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <format>
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPainterPath>
+#include <QWheelEvent>
+
+#include "hesiod/app/hesiod_application.hpp"
+#include "hesiod/gui/widgets/region_probe_widget.hpp"
+#include "hesiod/logger.hpp"
+
+namespace hesiod
+{
+
+// layout, in pixels
+static constexpr int panel_size = 192;
+static constexpr int gap = 4;
+static constexpr int profile_height = 80;
+static constexpr int text_height = 18;
+
+static const QRect overview_rect(0, 0, panel_size, panel_size);
+static const QRect zoom_rect(panel_size + gap, 0, panel_size, panel_size);
+static const QRect profile_rect(0,
+                                panel_size + gap,
+                                2 * panel_size + gap,
+                                profile_height);
+static const QRect text_rect(0,
+                             panel_size + profile_height + 2 * gap,
+                             2 * panel_size + gap,
+                             text_height);
+
+static QImage array_to_image(const hmap::Array &array, float vmin, float vmax);
+
+RegionProbeWidget::RegionProbeWidget(std::function<BaseNode *()> get_node,
+                                     QWidget                    *parent)
+    : QWidget(parent), get_node(get_node)
+{
+  Logger::log()->trace("RegionProbeWidget::RegionProbeWidget");
+
+  this->setFixedSize(2 * panel_size + gap,
+                     panel_size + profile_height + text_height + 2 * gap);
+  this->setMouseTracking(true);
+
+  // probes are coalesced, at most one per frame
+  this->probe_timer = new QTimer(this);
+  this->probe_timer->setSingleShot(true);
+  this->probe_timer->setInterval(16);
+
+  this->connect(this->probe_timer,
+                &QTimer::timeout,
+                this,
+                &RegionProbeWidget::update_probe);
+}
+
+void RegionProbeWidget::leaveEvent(QEvent *event)
+{
+  QWidget::leaveEvent(event);
+
+  this->is_probing = false;
+  this->update();
+}
+
+void RegionProbeWidget::mouseMoveEvent(QMouseEvent *event)
+{
+  const QPointF pos = event->position();
+
+  if (!overview_rect.contains(pos.toPoint()) || this->overview.isNull())
+    return;
+
+  // y axis pointing upward
+  this->probe_pos = {
+      std::clamp(float(pos.x() - overview_rect.left()) / float(panel_size), 0.f, 1.f),
+      std::clamp(1.f - float(pos.y() - overview_rect.top()) / float(panel_size),
+                 0.f,
+                 1.f)};
+  this->is_probing = true;
+
+  if (!this->probe_timer->isActive())
+    this->probe_timer->start();
+}
+
+void RegionProbeWidget::paintEvent(QPaintEvent *)
+{
+  QPainter painter(this);
+
+  const QColor bg = HSD_CTX.app_settings.colors.bg_deep;
+  const QColor fg = HSD_CTX.app_settings.colors.text_primary;
+  const QColor accent = HSD_CTX.app_settings.colors.accent;
+
+  painter.fillRect(this->rect(), bg);
+
+  if (this->overview.isNull())
+  {
+    painter.setPen(fg);
+    painter.drawText(text_rect, Qt::AlignLeft | Qt::AlignVCenter, "No heightmap data");
+    return;
+  }
+
+  // unit coordinates to pixels within a panel
+  auto to_pixels = [](const QRect &r, float x, float y)
+  {
+    return QPointF(r.left() + x * float(r.width()),
+                   r.top() + (1.f - y) * float(r.height()));
+  };
+
+  painter.drawImage(overview_rect, this->overview);
+
+  if (!this->is_probing)
+  {
+    painter.setPen(fg);
+    painter.drawText(text_rect,
+                     Qt::AlignLeft | Qt::AlignVCenter,
+                     "Hover the heightmap to probe it, wheel to zoom");
+    return;
+  }
+
+  // zoomed window on the overview and probe position
+  painter.setPen(accent);
+  const glm::vec4 &b = this->zoom_bbox;
+  painter.drawRect(QRectF(to_pixels(overview_rect, b.x, b.w),
+                          to_pixels(overview_rect, b.y, b.z)));
+
+  const QPointF p = to_pixels(overview_rect, this->probe_pos.x, this->probe_pos.y);
+  painter.drawLine(QPointF(overview_rect.left(), p.y()),
+                   QPointF(overview_rect.right(), p.y()));
+
+  // zoomed view
+  if (!this->zoom.isNull())
+  {
+    painter.drawImage(zoom_rect, this->zoom);
+
+    const float zx = (this->probe_pos.x - this->zoom_bbox.x) /
+                     std::max(this->zoom_bbox.y - this->zoom_bbox.x, 1e-6f);
+    const float zy = (this->probe_pos.y - this->zoom_bbox.z) /
+                     std::max(this->zoom_bbox.w - this->zoom_bbox.z, 1e-6f);
+    const QPointF pz = to_pixels(zoom_rect, zx, zy);
+
+    painter.drawLine(pz - QPointF(6.f, 0.f), pz + QPointF(6.f, 0.f));
+    painter.drawLine(pz - QPointF(0.f, 6.f), pz + QPointF(0.f, 6.f));
+  }
+
+  // profile along the probed row, scaled to the heightmap range
+  if (this->profile.size() > 1)
+  {
+    const float  range = std::max(this->vmax - this->vmin, 1e-6f);
+    QPainterPath path;
+
+    for (size_t k = 0; k < this->profile.size(); ++k)
+    {
+      const QPointF pk = to_pixels(profile_rect,
+                                   float(k) / float(this->profile.size() - 1),
+                                   (this->profile[k] - this->vmin) / range);
+      if (k == 0)
+        path.moveTo(pk);
+      else
+        path.lineTo(pk);
+    }
+
+    painter.setPen(fg);
+    painter.drawPath(path);
+
+    painter.setPen(accent);
+    painter.drawLine(QPointF(p.x(), profile_rect.top()),
+                     QPointF(p.x(), profile_rect.bottom()));
+  }
+
+  painter.setPen(fg);
+  painter.drawText(text_rect,
+                   Qt::AlignLeft | Qt::AlignVCenter,
+                   std::format("x: {:.3f}, y: {:.3f}, value: {:.4e}, zoom: {} cells",
+                               this->probe_pos.x,
+                               this->probe_pos.y,
+                               this->probe_value,
+                               this->zoom_cells)
+                       .c_str());
+}
+
+void RegionProbeWidget::set_port_index(int new_port_index)
+{
+  this->port_index = new_port_index;
+  this->update_overview();
+}
+
+void RegionProbeWidget::update_overview()
+{
+  BaseNode *p_node = this->get_node ? this->get_node() : nullptr;
+
+  auto sp_pyramid = p_node ? p_node->get_preview_pyramid(this->port_index) : nullptr;
+
+  if (!sp_pyramid)
+  {
+    this->overview = QImage();
+    this->zoom = QImage();
+    this->profile.clear();
+    this->update();
+    return;
+  }
+
+  this->vmin = sp_pyramid->get_min();
+  this->vmax = sp_pyramid->get_max();
+  this->source_shape = sp_pyramid->get_source_shape();
+  this->overview = array_to_image(
+      sp_pyramid->get_array(glm::ivec2(panel_size, panel_size)),
+      this->vmin,
+      this->vmax);
+
+  if (this->is_probing)
+    this->update_probe();
+  else
+    this->update();
+}
+
+void RegionProbeWidget::update_probe()
+{
+  BaseNode *p_node = this->get_node ? this->get_node() : nullptr;
+
+  if (!p_node || !this->is_probing || this->overview.isNull())
+    return;
+
+  // zoomed window, centered on the probe and kept within the heightmap
+  const glm::ivec2 cells = glm::max(this->source_shape - 1, glm::ivec2(1));
+  const float      w = 0.5f * float(this->zoom_cells);
+  const glm::vec2  half = {std::min(0.5f, w / float(cells.x)),
+                           std::min(0.5f, w / float(cells.y))};
+  const glm::vec2  center = {std::clamp(this->probe_pos.x, half.x, 1.f - half.x),
+                             std::clamp(this->probe_pos.y, half.y, 1.f - half.y)};
+
+  // value under the cursor, zoomed window and profile along the probed row, read
+  // together
+  RegionProbe probe;
+  probe.p = this->probe_pos;
+  probe.bbox = {center.x - half.x,
+                center.x + half.x,
+                center.y - half.y,
+                center.y + half.y};
+  probe.window_shape = glm::ivec2(std::min(this->zoom_cells, panel_size));
+  probe.p0 = {0.f, this->probe_pos.y};
+  probe.p1 = {1.f, this->probe_pos.y};
+  probe.nsamples = profile_rect.width();
+
+  // data or graph busy, probed again shortly
+  if (!p_node->query_probe(this->port_index, probe))
+  {
+    this->probe_timer->start();
+    return;
+  }
+
+  this->probe_value = probe.value;
+  this->zoom_bbox = probe.bbox;
+  this->zoom = array_to_image(probe.window, this->vmin, this->vmax);
+  this->profile = std::move(probe.profile);
+
+  this->update();
+}
+
+void RegionProbeWidget::wheelEvent(QWheelEvent *event)
+{
+  const int max_cells = std::max({this->source_shape.x, this->source_shape.y, 8});
+
+  if (event->angleDelta().y() > 0)
+    this->zoom_cells = std::max(8, this->zoom_cells / 2);
+  else if (event->angleDelta().y() < 0)
+    this->zoom_cells = std::min(max_cells, this->zoom_cells * 2);
+
+  if (this->is_probing && !this->probe_timer->isActive())
+    this->probe_timer->start();
+
+  event->accept();
+}
+
+// --- helper(s)
+
+QImage array_to_image(const hmap::Array &array, float vmin, float vmax)
+{
+  if (array.shape.x < 1 || array.shape.y < 1)
+    return QImage();
+
+  const float a = 255.f / std::max(vmax - vmin, 1e-6f);
+  QImage      image(array.shape.x, array.shape.y, QImage::Format_Grayscale8);
+
+  // first image row is the top of the heightmap
+  for (int j = 0; j < array.shape.y; ++j)
+  {
+    uchar *line = image.scanLine(array.shape.y - 1 - j);
+    for (int i = 0; i < array.shape.x; ++i)
+      line[i] = uchar(std::clamp(a * (array(i, j) - vmin), 0.f, 255.f));
+  }
+
+  return image;
+}
+
+} // namespace hesiod
@@ -1,14 +1,32 @@
 /* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <algorithm>
+#include <limits>
+
 #include "highmap/array.hpp"
 #include "highmap/operator.hpp"
 
 #include "hesiod/logger.hpp"
+#include "hesiod/model/thread_pool.hpp"
 
 namespace hesiod
 {
 
+std::vector<uint8_t> generate_rgba_image(const std::vector<const hmap::Array *> &rgba)
+{
+  const glm::ivec2     shape = rgba.front()->shape;
+  std::vector<uint8_t> img(4 * shape.x * shape.y);
+
+  int k = 0;
+  for (int j = 0; j < shape.y; ++j)
+    for (int i = 0; i < shape.x; i++)
+      for (size_t ch = 0; ch < 4; ++ch)
+        img[k++] = (uint8_t)(255.f * std::clamp((*rgba[ch])(i, j), 0.f, 1.f));
+
+  return img;
+}
+
 std::vector<uint8_t> generate_selector_image(hmap::Array &array)
 {
   std::vector<uint8_t> img(4 * array.shape.x * array.shape.y);
@@ -26,4 +44,77 @@ std::vector<uint8_t> generate_selector_image(hmap::Array &array)
   return img;
 }
 
+void generate_water_surface(const hmap::Array &elevation,
+                            const hmap::Array &water_depth,
+                            float              cut_value,
+                            hmap::Array       &surface)
+{
+  // workers shared by all the viewers
+  static ThreadPool pool;
+
+  const int   nx = elevation.shape.x;
+  const int   ny = elevation.shape.y;
+  const float dry = std::numeric_limits<float>::max();
+
+  surface = hmap::Array(elevation.shape);
+
+  // columns are contiguous in memory and the inner loops are branchless, so that they
+  // can be vectorized. Each task processes a range of columns, with a rolling buffer
+  // holding the water surface of the columns i - 1, i and i + 1
+  auto process_columns = [&](int i0, int i1)
+  {
+    std::vector<float> wet(3 * ny);
+    std::vector<float> col_min(ny);
+
+    auto load_column = [&](int i, int slot)
+    {
+      i = std::clamp(i, 0, nx - 1); // boundary columns are their own neighbor
+
+      const float *p_h = &elevation.vector[size_t(i) * ny];
+      const float *p_w = &water_depth.vector[size_t(i) * ny];
+      float       *p_wet = &wet[size_t(slot) * ny];
+
+      for (int j = 0; j < ny; ++j)
+        p_wet[j] = p_w[j] > 0.f ? p_h[j] + p_w[j] : dry;
+    };
+
+    load_column(i0 - 1, 0);
+    load_column(i0, 1);
+
+    for (int i = i0; i < i1; ++i)
+    {
+      const int k = i - i0;
+      load_column(i + 1, (k + 2) % 3);
+
+      const float *p_prev = &wet[size_t(k % 3) * ny];
+      const float *p_curr = &wet[size_t((k + 1) % 3) * ny];
+      const float *p_next = &wet[size_t((k + 2) % 3) * ny];
+      float       *p_out = &surface.vector[size_t(i) * ny];
+
+      for (int j = 0; j < ny; ++j)
+        col_min[j] = std::min(std::min(p_prev[j], p_curr[j]), p_next[j]);
+
+      // wet cells keep their surface, dry cells take the lowest neighboring one
+      for (int j = 0; j < ny; ++j)
+      {
+        const float v = std::min(std::min(col_min[std::max(j - 1, 0)], col_min[j]),
+                                 col_min[std::min(j + 1, ny - 1)]);
+        const float z = p_curr[j] < dry ? p_curr[j] : v;
+
+        p_out[j] = z < dry ? z : cut_value;
+      }
+    }
+  };
+
+  const int chunk = std::max(16, nx / int(4 * pool.get_nthreads()));
+
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < nx; i += chunk)
+    futures.push_back(
+        pool.submit([&, i]() { process_columns(i, std::min(i + chunk, nx)); }));
+
+  for (auto &f : futures)
+    f.get();
+}
+
 } // namespace hesiod
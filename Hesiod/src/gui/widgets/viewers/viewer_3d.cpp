@@ -1,9 +1,12 @@
 /* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <algorithm>
+#include <set>
+#include <shared_mutex>
+
 #include "highmap/geometry/cloud.hpp"
 #include "highmap/geometry/path.hpp"
-#include "highmap/morphology.hpp"
 #include "highmap/range.hpp"
 
 #include "qtr/render_widget.hpp"
@@ -78,6 +81,70 @@ bool helper_try_set_from_port(const BaseNode       &node,
   return true;
 }
 
+// read access to the data of all the displayed ports, not granted if one of them is
+// being computed
+static bool try_lock_ports(BaseNode                                         &node,
+                           const std::map<std::string, std::string>         &port_ids,
+                           std::vector<std::shared_lock<std::shared_mutex>> &locks)
+{
+  std::set<int> pids;
+
+  for (auto &[_, port_name] : port_ids)
+  {
+    int pid = port_name.empty() ? -1 : node.get_port_index(port_name);
+
+    if (pid < 0 || !node.get_data_ref(pid) || !pids.insert(pid).second)
+      continue;
+
+    locks.push_back(node.try_lock_data(pid));
+
+    if (!locks.back().owns_lock())
+      return false;
+  }
+
+  return true;
+}
+
+// hashes of the port data computed along with the node outputs, for the LOD caches. Not
+// known for the input ports
+static const TileHashes *get_tile_hashes(const BaseNode    &node,
+                                         const std::string &port_name)
+{
+  int pid = node.get_port_index(port_name);
+  if (pid < 0 || node.get_port_type(pid) != gngui::PortType::OUT)
+    return nullptr;
+
+  return node.get_output_tile_hashes(pid);
+}
+
+static uint64_t get_data_hash(const BaseNode &node, const std::vector<std::string> &ports)
+{
+  for (auto &port_name : ports)
+  {
+    int pid = node.get_port_index(port_name);
+    if (pid < 0 || node.get_port_type(pid) != gngui::PortType::OUT)
+      return 0;
+  }
+
+  return node.get_output_hash();
+}
+
+static std::vector<const hmap::Array *> get_arrays(const ViewerLodCache &cache)
+{
+  std::vector<const hmap::Array *> arrays;
+  for (size_t ch = 0; ch < 4; ++ch)
+    arrays.push_back(&cache.get_array(ch));
+  return arrays;
+}
+
+static std::vector<hmap::VirtualArray *> get_channels(hmap::VirtualTexture &rgba)
+{
+  std::vector<hmap::VirtualArray *> channels;
+  for (int ch = 0; ch < 4; ++ch)
+    channels.push_back(&rgba.channel(ch));
+  return channels;
+}
+
 // =====================================
 // Viewer3D - class definition
 // =====================================
@@ -97,8 +164,18 @@ Viewer3D::Viewer3D(QPointer<GraphNodeWidget> p_graph_node_widget_, QWidget *pare
 void Viewer3D::clear()
 {
   Viewer::clear();
+  this->clear_renderer();
+}
+
+void Viewer3D::clear_renderer()
+{
   if (this->p_renderer)
     this->p_renderer->clear();
+
+  this->elevation_cache.clear();
+  this->water_cache.clear();
+  this->color_cache.clear();
+  this->normal_map_cache.clear();
 }
 
 ViewerNodeParam Viewer3D::get_default_view_param() const
@@ -128,6 +205,23 @@ ViewerNodeParam Viewer3D::get_default_view_param() const
   return wp;
 }
 
+int Viewer3D::get_mesh_lod(const glm::ivec2 &shape) const
+{
+  const auto &settings = HSD_CTX.app_settings.viewer;
+
+  if (!settings.enable_mesh_lod || !this->p_renderer)
+    return 0;
+
+  // about one vertex per viewport pixel
+  const qreal ratio = this->p_renderer->devicePixelRatioF();
+  const int   npixels = int(ratio * std::max(this->p_renderer->width(),
+                                           this->p_renderer->height()));
+
+  return ViewerLodCache::get_lod_for_resolution(
+      shape,
+      std::min(npixels, settings.max_mesh_resolution));
+}
+
 bool Viewer3D::get_param_visibility_state(const std::string &param_name) const
 {
   if (!this->p_renderer)
@@ -206,6 +300,13 @@ void Viewer3D::resizeEvent(QResizeEvent *)
   int   h = s.height();
 
   this->combo_container->setGeometry(x, y, w, h);
+
+  // the mesh resolution follows the viewport size
+  const glm::ivec2 shape = this->elevation_cache.get_source_shape();
+
+  if (this->elevation_cache.get_lod() >= 0 &&
+      this->get_mesh_lod(shape) != this->elevation_cache.get_lod())
+    this->update_renderer();
 }
 
 void Viewer3D::setup_connections()
@@ -255,7 +356,7 @@ void Viewer3D::update_renderer()
 
   if (this->current_node_id == "")
   {
-    this->p_renderer->clear();
+    this->clear_renderer();
     return;
   }
 
@@ -263,7 +364,7 @@ void Viewer3D::update_renderer()
 
   if (!p_node)
   {
-    this->p_renderer->clear();
+    this->clear_renderer();
     return;
   }
 
@@ -271,29 +372,47 @@ void Viewer3D::update_renderer()
 
   this->update_param_visibility_icons();
 
-  // --- route/send data to renderer
+  // --- data being computed, the renderer is updated again once the compute is finished
+
+  std::vector<std::shared_lock<std::shared_mutex>> data_locks;
+
+  if (!try_lock_ports(*p_node, this->view_param.port_ids, data_locks))
+    return;
 
-  bool flip_y = false;
+  // --- route/send data to renderer
 
   if (!helper_try_set_from_port<hmap::VirtualArray>(
           *p_node,
           this->view_param.port_ids.at("elevation"),
           typeid(hmap::VirtualArray),
-          [this, p_node](const hmap::VirtualArray &h)
+          [this, p_node](hmap::VirtualArray &h)
           {
-            auto arr = h.to_array(p_node->cfg().cm_cpu);
-            if (this->p_renderer)
+            bool add_skirt = HSD_CTX.app_settings.viewer.add_heighmap_skirt;
+
+            // decimated mesh, only the modified tiles are processed
+            const std::string &port = this->view_param.port_ids.at("elevation");
+
+            bool changed = this->elevation_cache.update({&h},
+                                                        this->get_mesh_lod(h.shape),
+                                                        p_node->cfg().tile_shape,
+                                                        p_node->cfg().cm_cpu,
+                                                        {get_tile_hashes(*p_node, port)},
+                                                        get_data_hash(*p_node, {port}));
+
+            if (this->p_renderer && (changed || add_skirt != this->uploaded_skirt))
             {
-              bool add_skirt = HSD_CTX.app_settings.viewer.add_heighmap_skirt;
+              const hmap::Array &arr = this->elevation_cache.get_array();
 
               this->p_renderer->set_heightmap_geometry(arr.vector,
-                                                       h.shape.x,
-                                                       h.shape.y,
+                                                       arr.shape.x,
+                                                       arr.shape.y,
                                                        add_skirt);
+              this->uploaded_skirt = add_skirt;
             }
           }))
   {
     this->p_renderer->reset_heightmap_geometry();
+    this->elevation_cache.clear();
   }
 
   // water
@@ -302,79 +421,94 @@ void Viewer3D::update_renderer()
           this->view_param.port_ids.at("elevation"),
           this->view_param.port_ids.at("water_depth"),
           typeid(hmap::VirtualArray),
-          [this, p_node](const hmap::VirtualArray &h, const hmap::VirtualArray &w)
+          [this, p_node](hmap::VirtualArray &h, hmap::VirtualArray &w)
           {
-            // TODO do this somewhere else?
-            auto ah = h.to_array(p_node->cfg().cm_cpu); // elevation
-            auto aw = w.to_array(p_node->cfg().cm_cpu); // water depth
-
-            // water elevation
-            ah += aw;
-
-            // extend the water depth by one-cell to avoid truncated
-            // cells at the interface water/ground
-            float dh = 1e3f;
-
-            for (int j = 0; j < h.shape.y; ++j)
-              for (int i = 0; i < h.shape.x; ++i)
-              {
-                if (aw(i, j) <= 0.f)
-                  ah(i, j) = 0.f;
-                else
-                  ah(i, j) += dh;
-              }
-
-            ah = hmap::dilation_expand_min_value_border_only(ah);
+            // water surface only prepared again when the elevation or the water depth
+            // changed
+            const std::string &port_h = this->view_param.port_ids.at("elevation");
+            const std::string &port_w = this->view_param.port_ids.at("water_depth");
+
+            if (!this->water_cache.update({&h, &w},
+                                          this->get_mesh_lod(h.shape),
+                                          p_node->cfg().tile_shape,
+                                          p_node->cfg().cm_cpu,
+                                          {get_tile_hashes(*p_node, port_h),
+                                           get_tile_hashes(*p_node, port_w)},
+                                          get_data_hash(*p_node, {port_h, port_w})))
+              return;
+
+            const float cut_value = -1e3f;
+            hmap::Array surface;
+
+            generate_water_surface(this->water_cache.get_array(0),
+                                   this->water_cache.get_array(1),
+                                   cut_value,
+                                   surface);
 
-            // remove non-water cells
-            float cut_value = -1e3f;
-
-            for (int j = 0; j < h.shape.y; ++j)
-              for (int i = 0; i < h.shape.x; ++i)
-              {
-                if (ah(i, j) <= 0.f)
-                  ah(i, j) = cut_value;
-                else
-                  ah(i, j) -= dh;
-              }
-
-            // send to renderer
             if (this->p_renderer)
-              this->p_renderer->set_water_geometry(ah.vector,
-                                                   h.shape.x,
-                                                   h.shape.y,
+              this->p_renderer->set_water_geometry(surface.vector,
+                                                   surface.shape.x,
+                                                   surface.shape.y,
                                                    cut_value);
           }))
   {
     this->p_renderer->reset_water_geometry();
+    this->water_cache.clear();
   }
 
-  // color
+  // color and normal map, twice the mesh resolution
+  auto texture_lod = [this](const glm::ivec2 &shape)
+  { return std::max(0, this->get_mesh_lod(shape) - 1); };
+
   if (!(helper_try_set_from_port<hmap::VirtualArray>(
             *p_node,
             this->view_param.port_ids.at("color"),
             typeid(hmap::VirtualArray),
-            [this, p_node](const hmap::VirtualArray &h)
+            [this, p_node, texture_lod](hmap::VirtualArray &h)
             {
-              auto arr = h.to_array(p_node->cfg().cm_cpu);
-              auto img = generate_selector_image(arr);
+              const std::string &port = this->view_param.port_ids.at("color");
+
+              if (this->color_cache.update({&h},
+                                           texture_lod(h.shape),
+                                           p_node->cfg().tile_shape,
+                                           p_node->cfg().cm_cpu,
+                                           {get_tile_hashes(*p_node, port)},
+                                           get_data_hash(*p_node, {port})))
+              {
+                hmap::Array arr = this->color_cache.get_array();
+                auto        img = generate_selector_image(arr);
 
-              if (this->p_renderer)
-                this->p_renderer->set_texture(QTR_TEX_ALBEDO, img, h.shape.x);
+                if (this->p_renderer)
+                  this->p_renderer->set_texture(QTR_TEX_ALBEDO, img, arr.shape.x);
+              }
             }) ||
         helper_try_set_from_port<hmap::VirtualTexture>(
             *p_node,
             this->view_param.port_ids.at("color"),
             typeid(hmap::VirtualTexture),
-            [this, p_node, flip_y](const hmap::VirtualTexture &rgba)
+            [this, p_node, texture_lod](hmap::VirtualTexture &rgba)
             {
-              auto img = rgba.to_img_8bit(rgba.shape, p_node->cfg().cm_cpu, flip_y);
+              // no tile hashes for the textures
+              const std::string &port = this->view_param.port_ids.at("color");
+
+              if (this->color_cache.update(get_channels(rgba),
+                                           texture_lod(rgba.shape),
+                                           p_node->cfg().tile_shape,
+                                           p_node->cfg().cm_cpu,
+                                           {},
+                                           get_data_hash(*p_node, {port})))
+              {
+                auto img = generate_rgba_image(get_arrays(this->color_cache));
 
-              if (this->p_renderer)
-                this->p_renderer->set_texture(QTR_TEX_ALBEDO, img, rgba.shape.x);
+                if (this->p_renderer)
+                  this->p_renderer->set_texture(QTR_TEX_ALBEDO,
+                                                img,
+                                                this->color_cache.get_shape().x);
+              }
             })))
   {
     this->p_renderer->reset_texture(QTR_TEX_ALBEDO);
+    this->color_cache.clear();
   }
 
   // normal map
@@ -382,15 +516,28 @@ void Viewer3D::update_renderer()
           *p_node,
           this->view_param.port_ids.at("normal_map"),
           typeid(hmap::VirtualTexture),
-          [this, p_node, flip_y](const hmap::VirtualTexture &rgba)
+          [this, p_node, texture_lod](hmap::VirtualTexture &rgba)
           {
-            auto img = rgba.to_img_8bit(rgba.shape, p_node->cfg().cm_cpu, flip_y);
+            const std::string &port = this->view_param.port_ids.at("normal_map");
+
+            if (this->normal_map_cache.update(get_channels(rgba),
+                                              texture_lod(rgba.shape),
+                                              p_node->cfg().tile_shape,
+                                              p_node->cfg().cm_cpu,
+                                              {},
+                                              get_data_hash(*p_node, {port})))
+            {
+              auto img = generate_rgba_image(get_arrays(this->normal_map_cache));
 
-            if (this->p_renderer)
-              this->p_renderer->set_texture(QTR_TEX_NORMAL, img, rgba.shape.x);
+              if (this->p_renderer)
+                this->p_renderer->set_texture(QTR_TEX_NORMAL,
+                                              img,
+                                              this->normal_map_cache.get_shape().x);
+            }
           }))
   {
     this->p_renderer->reset_texture(QTR_TEX_NORMAL);
+    this->normal_map_cache.clear();
   }
 
   // points
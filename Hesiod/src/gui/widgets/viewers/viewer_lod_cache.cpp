@@ -0,0 +1,167 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "hesiod/gui/widgets/viewers/viewer_lod_cache.hpp"
+#include "hesiod/logger.hpp"
+#include "hesiod/model/streaming_export.hpp"
+#include "hesiod/model/utils.hpp"
+
+namespace hesiod
+{
+
+void ViewerLodCache::clear()
+{
+  this->arrays.clear();
+  this->tile_hashes.clear();
+  this->data_hash = 0;
+  this->source_shape = {0, 0};
+  this->lod = -1;
+}
+
+const hmap::Array &ViewerLodCache::get_array(size_t channel) const
+{
+  return this->arrays.at(channel);
+}
+
+int ViewerLodCache::get_lod() const { return this->lod; }
+
+int ViewerLodCache::get_lod_for_resolution(const glm::ivec2 &shape, int resolution)
+{
+  int l = 0;
+  while ((std::max(shape.x, shape.y) >> (l + 1)) >= std::max(1, resolution))
+    l++;
+  return l;
+}
+
+glm::ivec2 ViewerLodCache::get_shape() const
+{
+  return this->arrays.empty() ? glm::ivec2(0, 0) : this->arrays.front().shape;
+}
+
+glm::ivec2 ViewerLodCache::get_source_shape() const { return this->source_shape; }
+
+bool ViewerLodCache::update(const std::vector<hmap::VirtualArray *> &channels,
+                            int                                      new_lod,
+                            const glm::ivec2                        &tile_shape,
+                            const hmap::ComputeMode                 &cm,
+                            const std::vector<const TileHashes *>   &channel_hashes,
+                            uint64_t                                 data_hash)
+{
+  if (channels.empty() || !channels.front())
+    return false;
+
+  const glm::ivec2 shape = channels.front()->shape;
+  const int        factor = 1 << new_lod;
+  const glm::ivec2 lod_shape = (shape + factor - 1) / factor;
+
+  // new layout, everything is decimated again
+  if (shape != this->source_shape || new_lod != this->lod ||
+      channels.size() != this->arrays.size())
+  {
+    this->arrays.assign(channels.size(), hmap::Array(lod_shape));
+    this->tile_hashes.clear();
+    this->data_hash = 0;
+    this->source_shape = shape;
+    this->lod = new_lod;
+  }
+  else if (data_hash && data_hash == this->data_hash)
+    return false;
+
+  // hashes of the channels combined for each tile, empty if one of them is unknown
+  TileHashes new_tile_hashes;
+
+  if (channel_hashes.size() == channels.size() &&
+      std::all_of(channel_hashes.begin(),
+                  channel_hashes.end(),
+                  [](const TileHashes *p) { return p && !p->empty(); }))
+  {
+    for (const TileHashes *p_hashes : channel_hashes)
+      for (const auto &[key, hash] : *p_hashes)
+        new_tile_hashes[key] = hash_combine(new_tile_hashes[key], hash);
+
+    if (new_tile_hashes == this->tile_hashes)
+    {
+      this->data_hash = data_hash;
+      return false;
+    }
+  }
+
+  // source index of each LOD cell, the domain corners are kept
+  std::vector<int> src_i(lod_shape.x), src_j(lod_shape.y);
+
+  for (int i = 0; i < lod_shape.x; ++i)
+    src_i[i] = lod_shape.x > 1 ? int(std::lround(float(i) * float(shape.x - 1) /
+                                                 float(lod_shape.x - 1)))
+                               : 0;
+  for (int j = 0; j < lod_shape.y; ++j)
+    src_j[j] = lod_shape.y > 1 ? int(std::lround(float(j) * float(shape.y - 1) /
+                                                 float(lod_shape.y - 1)))
+                               : 0;
+
+  std::mutex mutex;
+  size_t     nupdated = 0;
+
+  // tile layout expected by get_tile_interior
+  hmap::ComputeMode cm_tiles = cm;
+  cm_tiles.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+
+  hmap::for_each_tile(
+      channels,
+      [&](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
+      {
+        // skip the tiles that did not change since the previous update
+        if (!new_tile_hashes.empty())
+        {
+          auto it_new = new_tile_hashes.find(region.key.hash());
+          auto it = this->tile_hashes.find(region.key.hash());
+
+          if (it_new != new_tile_hashes.end() && it != this->tile_hashes.end() &&
+              it_new->second == it->second)
+            return;
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          nupdated++;
+        }
+
+        // each LOD cell is written by the tile owning its source cell
+        const TileInterior interior = get_tile_interior(region, shape, tile_shape);
+        const glm::ivec2  &tile_ij0 = interior.ij0;
+        const glm::ivec2  &a = interior.a;
+        const glm::ivec2  &b = interior.b;
+
+        const int i0 = int(std::lower_bound(src_i.begin(), src_i.end(), a.x) -
+                           src_i.begin());
+        const int i1 = int(std::lower_bound(src_i.begin(), src_i.end(), b.x) -
+                           src_i.begin());
+        const int j0 = int(std::lower_bound(src_j.begin(), src_j.end(), a.y) -
+                           src_j.begin());
+        const int j1 = int(std::lower_bound(src_j.begin(), src_j.end(), b.y) -
+                           src_j.begin());
+
+        for (size_t k = 0; k < p_arrays.size(); ++k)
+          for (int i = i0; i < i1; ++i)
+            for (int j = j0; j < j1; ++j)
+              this->arrays[k](i, j) = (*p_arrays[k])(src_i[i] - tile_ij0.x,
+                                                     src_j[j] - tile_ij0.y);
+      },
+      cm_tiles);
+
+  this->tile_hashes = std::move(new_tile_hashes);
+  this->data_hash = data_hash;
+
+  Logger::log()->trace("ViewerLodCache::update: lod {}, {}x{}, {} tile(s) updated",
+                       this->lod,
+                       lod_shape.x,
+                       lod_shape.y,
+                       nupdated);
+
+  return nupdated > 0;
+}
+
+} // namespace hesiod
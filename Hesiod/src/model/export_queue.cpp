@@ -0,0 +1,177 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/export_queue.hpp"
+
+namespace hesiod
+{
+
+// failure labels kept in the report, the queue of the application is never flushed
+static constexpr size_t max_failures = 64;
+
+ExportQueue::ExportQueue(size_t nthreads) : nthreads(std::max(size_t(1), nthreads)) {}
+
+ExportQueue::~ExportQueue()
+{
+  this->flush();
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->cv_job.notify_all();
+
+  for (auto &w : this->workers)
+    if (w.joinable())
+      w.join();
+}
+
+bool ExportQueue::execute(const std::string &label, const std::function<bool()> &task)
+{
+  bool success = false;
+
+  try
+  {
+    success = task();
+  }
+  catch (const std::exception &e)
+  {
+    Logger::log()->error("ExportQueue: {}: {}", label, e.what());
+  }
+
+  if (!success)
+    Logger::log()->error("ExportQueue: export failed: {}", label);
+
+  return success;
+}
+
+ExportReport ExportQueue::flush()
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->cv_done.wait(lock,
+                     [this]() { return this->order.empty() && this->running.empty(); });
+
+  ExportReport flushed = std::move(this->report);
+  this->report = ExportReport();
+
+  return flushed;
+}
+
+size_t ExportQueue::get_npending() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->order.size() + this->running.size();
+}
+
+void ExportQueue::record(const std::string &label, bool success)
+{
+  this->report.ncompleted++;
+
+  if (!success)
+  {
+    this->report.nfailed++;
+
+    if (this->report.failures.size() >= max_failures)
+      this->report.failures.erase(this->report.failures.begin());
+
+    this->report.failures.push_back(label);
+  }
+}
+
+bool ExportQueue::run(const std::string &label, const std::function<bool()> &task)
+{
+  Logger::log()->trace("ExportQueue::run: {}", label);
+
+  bool success = ExportQueue::execute(label, task);
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->record(label, success);
+
+  return success;
+}
+
+void ExportQueue::submit(const std::string    &key,
+                         const std::string    &label,
+                         std::function<bool()> task)
+{
+  Logger::log()->trace("ExportQueue::submit: {}", label);
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // threads are not started for applications never exporting anything
+    if (this->workers.empty())
+      for (size_t k = 0; k < this->nthreads; ++k)
+        this->workers.emplace_back([this]() { this->worker_loop(); });
+
+    auto it = this->queued.find(key);
+
+    if (it != this->queued.end())
+    {
+      // not started yet, the newer data wins
+      Logger::log()->trace("ExportQueue::submit: superseding {}", it->second.label);
+      it->second = {label, std::move(task)};
+      this->report.nsuperseded++;
+    }
+    else
+    {
+      this->queued[key] = {label, std::move(task)};
+      this->order.push_back(key);
+    }
+  }
+
+  this->cv_job.notify_one();
+}
+
+void ExportQueue::worker_loop()
+{
+  while (true)
+  {
+    std::string key;
+    Job         job;
+
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+
+      // first queued job whose file is not being written by another worker
+      auto it = this->order.end();
+
+      this->cv_job.wait(lock,
+                        [this, &it]()
+                        {
+                          it = std::find_if(this->order.begin(),
+                                            this->order.end(),
+                                            [this](const std::string &k)
+                                            { return !this->running.contains(k); });
+                          return this->stop || it != this->order.end();
+                        });
+
+      if (it == this->order.end()) // stopping, nothing left to write
+        return;
+
+      key = *it;
+      this->order.erase(it);
+      job = std::move(this->queued.at(key));
+      this->queued.erase(key);
+      this->running.insert(key);
+    }
+
+    bool success = ExportQueue::execute(job.label, job.task);
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+
+      this->running.erase(key);
+      this->record(job.label, success);
+    }
+
+    // a job of the same file may now be started
+    this->cv_job.notify_all();
+    this->cv_done.notify_all();
+  }
+}
+
+} // namespace hesiod
@@ -1,7 +1,11 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <algorithm>
+#include <thread>
+
 #include "hesiod/model/graph/bake_config.hpp"
+#include "hesiod/model/profiler.hpp"
 #include "hesiod/model/utils.hpp"
 
 namespace hesiod
@@ -27,4 +31,34 @@ nlohmann::json BakeConfig::json_to() const
   return json;
 }
 
+// --- helpers
+
+size_t estimate_batch_memory(const glm::ivec2 &shape)
+{
+  // resident heightmaps (the tiles of the other ones are swapped to disk) plus the
+  // application itself
+  const size_t nheightmaps = 16;
+  const size_t base_bytes = 512ULL * 1024ULL * 1024ULL;
+
+  return nheightmaps * size_t(shape.x) * size_t(shape.y) * sizeof(float) + base_bytes;
+}
+
+int get_bake_worker_count(const BakeConfig &bake_settings)
+{
+  const size_t cores_per_worker = 4;
+  const size_t bytes = estimate_batch_memory(
+      glm::ivec2(bake_settings.resolution, bake_settings.resolution));
+
+  size_t ncores = std::max(1u, std::thread::hardware_concurrency());
+  size_t nworkers = std::max(size_t(1), ncores / cores_per_worker);
+
+  // unknown on some platforms
+  if (size_t available = get_available_memory(); available > 0)
+    nworkers = std::min(nworkers, std::max(size_t(1), available / bytes));
+
+  nworkers = std::min(nworkers, static_cast<size_t>(bake_settings.nvariants + 1));
+
+  return static_cast<int>(nworkers);
+}
+
 } // namespace hesiod
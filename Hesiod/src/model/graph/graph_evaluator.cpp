@@ -0,0 +1,213 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include "hesiod/model/graph/graph_evaluator.hpp"
+#include "hesiod/app/hesiod_application.hpp"
+#include "hesiod/logger.hpp"
+#include "hesiod/model/graph/graph_node.hpp"
+
+namespace hesiod
+{
+
+static thread_local bool is_evaluation_thread = false;
+
+GraphEvaluator::GraphEvaluator(GraphNode *p_graph_node) : p_graph_node(p_graph_node)
+{
+  Logger::log()->trace("GraphEvaluator::GraphEvaluator");
+
+  this->worker = std::thread([this]() { this->worker_loop(); });
+}
+
+GraphEvaluator::~GraphEvaluator()
+{
+  Logger::log()->trace("GraphEvaluator::~GraphEvaluator");
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+    this->pending_ids.clear();
+    this->full_update_pending = false;
+    this->cancel_flag = true;
+  }
+  this->cv.notify_all();
+
+  if (this->worker.joinable())
+    this->worker.join();
+}
+
+void GraphEvaluator::cancel()
+{
+  Logger::log()->trace("GraphEvaluator::cancel");
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->pending_ids.clear();
+  this->full_update_pending = false;
+
+  if (this->busy)
+  {
+    // nothing to resume
+    this->running_roots.clear();
+    this->full_update_running = false;
+    this->cancel_flag = true;
+  }
+}
+
+bool GraphEvaluator::is_busy() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->busy || this->full_update_pending || !this->pending_ids.empty();
+}
+
+bool GraphEvaluator::is_worker_thread() { return is_evaluation_thread; }
+
+void GraphEvaluator::request_update(const std::string &node_id)
+{
+  Logger::log()->trace("GraphEvaluator::request_update: id = {}", node_id);
+
+  // nodes affected by the request, the graph structure is only modified by the
+  // calling thread
+  std::vector<std::string> affected_ids;
+  if (!node_id.empty())
+    affected_ids = this->p_graph_node->get_downstream_node_ids(node_id);
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (node_id.empty())
+      this->full_update_pending = true;
+    else
+      this->pending_ids.insert(node_id);
+
+    // supersede the in-flight evaluation if it shares nodes with the request
+    if (this->busy)
+    {
+      bool overlap = node_id.empty();
+
+      for (auto &id : affected_ids)
+        if (overlap || this->running_ids.contains(id))
+        {
+          overlap = true;
+          break;
+        }
+
+      if (overlap)
+      {
+        Logger::log()->trace("GraphEvaluator::request_update: superseding in-flight "
+                             "evaluation");
+        this->cancel_flag = true;
+      }
+    }
+  }
+  this->cv.notify_one();
+}
+
+std::unique_lock<std::recursive_mutex> GraphEvaluator::suspend()
+{
+  Logger::log()->trace("GraphEvaluator::suspend");
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->busy)
+      this->cancel_flag = true;
+  }
+
+  // wait for the in-flight evaluation to stop
+  return std::unique_lock<std::recursive_mutex>(this->run_mutex);
+}
+
+std::unique_lock<std::recursive_mutex> GraphEvaluator::try_suspend()
+{
+  return std::unique_lock<std::recursive_mutex>(this->run_mutex, std::try_to_lock);
+}
+
+void GraphEvaluator::worker_loop()
+{
+  is_evaluation_thread = true;
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cv.wait(lock,
+                    [this]()
+                    {
+                      return this->stop || this->full_update_pending ||
+                             !this->pending_ids.empty();
+                    });
+
+      if (this->stop)
+        return;
+    }
+
+    std::unique_lock<std::recursive_mutex> run_lock(this->run_mutex);
+    std::vector<std::string>               node_ids;
+
+    // take the pending requests
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+
+      if (this->stop)
+        return;
+
+      this->full_update_running = this->full_update_pending;
+      this->running_roots = std::move(this->pending_ids);
+      this->pending_ids.clear();
+      this->full_update_pending = false;
+
+      if (this->full_update_running)
+      {
+        for (auto &[id, _] : this->p_graph_node->get_nodes())
+          node_ids.push_back(id);
+      }
+      else
+      {
+        std::set<std::string> ids;
+        for (auto &root_id : this->running_roots)
+          for (auto &id : this->p_graph_node->get_downstream_node_ids(root_id))
+            if (ids.insert(id).second)
+              node_ids.push_back(id);
+      }
+
+      this->running_ids = std::set<std::string>(node_ids.begin(), node_ids.end());
+      this->cancel_flag = false;
+      this->busy = true;
+    }
+
+    Logger::log()->trace("GraphEvaluator::worker_loop: evaluating {} node(s)",
+                         node_ids.size());
+
+    if (this->p_graph_node->update_started)
+      this->p_graph_node->update_started();
+
+    bool done;
+
+    if (HSD_CTX.app_settings.model.enable_progressive_update)
+      done = this->p_graph_node->update_progressive(node_ids, &this->cancel_flag);
+    else
+      done = this->p_graph_node->update_parallel(node_ids, &this->cancel_flag);
+
+    if (this->p_graph_node->update_finished)
+      this->p_graph_node->update_finished();
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+
+      // cancelled evaluations are resumed with the next request
+      if (!done)
+      {
+        Logger::log()->trace("GraphEvaluator::worker_loop: evaluation cancelled");
+
+        this->full_update_pending |= this->full_update_running;
+        this->pending_ids.insert(this->running_roots.begin(), this->running_roots.end());
+      }
+
+      this->running_ids.clear();
+      this->running_roots.clear();
+      this->full_update_running = false;
+      this->busy = false;
+    }
+  }
+}
+
+} // namespace hesiod
@@ -11,6 +11,8 @@
 #include "hesiod/model/graph/graph_config.hpp"
 #include "hesiod/model/graph/graph_manager.hpp"
 #include "hesiod/model/graph/graph_node.hpp"
+#include "hesiod/model/profiler.hpp"
+#include "hesiod/model/streaming_export.hpp"
 #include "hesiod/model/utils.hpp"
 
 namespace hesiod
@@ -47,6 +49,8 @@ std::string GraphManager::add_graph_node(const std::shared_ptr<GraphNode> &p_gra
     // store a reference to the global storage of broadcasting data
     p_graph_node->set_p_broadcast_params(&broadcast_params);
 
+    p_graph_node->set_p_export_queue(this->p_export_queue);
+
     // connections for broadcasting data between graph_nodes
     p_graph_node->broadcast_node_updated =
         [this](const std::string &graph_id, const std::string &tag)
@@ -85,6 +89,8 @@ void GraphManager::export_flatten()
 {
   Logger::log()->trace("GraphManager::export_flatten");
 
+  ProfileSpan span("export_flatten", "export", TraceTrack::TTR_EXPORT);
+
   // create config
   auto export_cfg = GraphConfig();
   export_cfg.set_shape(export_param.shape);
@@ -114,8 +120,9 @@ void GraphManager::export_flatten()
   }
 
   // retrieve for each graph the selected tag and the corresponding data
-  std::vector<const hmap::VirtualArray *> h_sources;
-  std::vector<const hmap::CoordFrame *>   t_sources;
+  std::vector<const hmap::VirtualArray *>          h_sources;
+  std::vector<const hmap::CoordFrame *>            t_sources;
+  std::vector<std::shared_lock<std::shared_mutex>> data_locks;
 
   for (auto ids : this->export_param.ids)
   {
@@ -123,9 +130,21 @@ void GraphManager::export_flatten()
     std::string node_id = std::get<1>(ids);
     std::string port_id = std::get<2>(ids);
 
-    hmap::VirtualArray *p_h = this->graph_nodes.at(graph_id)
-                                  ->get_node_ref_by_id(node_id)
-                                  ->get_value_ref<hmap::VirtualArray>(port_id);
+    BaseNode *p_node = this->graph_nodes.at(graph_id)->get_node_ref_by_id<BaseNode>(
+        node_id);
+
+    // the data cannot be read while it is being computed
+    data_locks.push_back(p_node->try_lock_data(p_node->get_port_index(port_id)));
+
+    if (!data_locks.back().owns_lock())
+    {
+      Logger::log()->warn("GraphManager::export_flatten: data of node {} is being "
+                          "computed, export skipped",
+                          node_id);
+      return;
+    }
+
+    hmap::VirtualArray *p_h = p_node->get_value_ref<hmap::VirtualArray>(port_id);
 
     hmap::CoordFrame *p_t = dynamic_cast<hmap::CoordFrame *>(
         this->graph_nodes.at(graph_id).get());
@@ -139,21 +158,42 @@ void GraphManager::export_flatten()
   float            rotation_angle = 0.f;
   hmap::CoordFrame frame_export(origin, size, rotation_angle);
 
-  hmap::flatten_heightmap(h_sources,
-                          h_export,
-                          t_sources,
-                          frame_export,
-                          export_cfg.cm_cpu);
+  {
+    ProfileSpan span_flatten("flatten_heightmap", "export", TraceTrack::TTR_EXPORT);
+
+    hmap::flatten_heightmap(h_sources,
+                            h_export,
+                            t_sources,
+                            frame_export,
+                            export_cfg.cm_cpu);
+  }
 
   // raw heightmap
-  const std::string fname = export_param.export_path.string();
-  h_export.to_array(export_cfg.cm_cpu).to_png_grayscale(fname, CV_16U);
+  {
+    ProfileSpan span_write("write_heightmap", "export", TraceTrack::TTR_EXPORT);
+
+    const std::string fname = export_param.export_path.string();
+    export_png_streamed(h_export, export_cfg.tile_shape, fname, 16, export_cfg.cm_cpu);
+  }
 
   // will hillshading
-  const std::filesystem::path fname_hs = insert_before_extension(export_param.export_path,
-                                                                 "_preview");
-  h_export.to_array(export_cfg.cm_cpu)
-      .to_png(fname_hs.string(), hmap::Cmap::TERRAIN, true);
+  {
+    ProfileSpan span_write("write_preview", "export", TraceTrack::TTR_EXPORT);
+
+    const std::filesystem::path fname_hs = insert_before_extension(
+        export_param.export_path,
+        "_preview");
+    // downsampled, the preview is not meant for production
+    const float preview_max_size = 2048.f;
+    const float ratio = std::min(1.f,
+                                 preview_max_size /
+                                     float(std::max(export_cfg.shape.x,
+                                                    export_cfg.shape.y)));
+    const glm::ivec2 shape_preview = glm::ivec2(glm::vec2(export_cfg.shape) * ratio);
+
+    h_export.to_array(shape_preview, export_cfg.cm_cpu)
+        .to_png(fname_hs.string(), hmap::Cmap::TERRAIN, true);
+  }
 }
 
 const BroadcastMap &GraphManager::get_broadcast_params()
@@ -318,6 +358,11 @@ void GraphManager::on_broadcast_node_updated(const std::string &graph_id,
 {
   Logger::log()->trace("GraphManager::on_broadcast_node_updated: broadcasting {}", tag);
 
+  ProfileSpan span(tag,
+                   "broadcast",
+                   TraceTrack::TTR_BROADCAST,
+                   {{"graph_id", graph_id}});
+
   for (auto &[gid, graph] : this->graph_nodes)
   {
     // prevent any broadcast from a top layer to a sublayer, this
@@ -400,6 +445,14 @@ void GraphManager::set_graph_order(const std::vector<std::string> &new_graph_ord
 
 void GraphManager::set_id(const std::string &new_id) { this->id = new_id; }
 
+void GraphManager::set_p_export_queue(ExportQueue *new_p_export_queue)
+{
+  this->p_export_queue = new_p_export_queue;
+
+  for (auto &[graph_id, p_graph_node] : this->graph_nodes)
+    p_graph_node->set_p_export_queue(new_p_export_queue);
+}
+
 void GraphManager::update()
 {
   Logger::log()->trace("GraphManager::update()");
@@ -1,16 +1,26 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
-#include "hesiod/model/graph/graph_node.hpp"
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <set>
+
+#include "hesiod/app/hesiod_application.hpp"
 #include "hesiod/logger.hpp"
+#include "hesiod/model/graph/graph_evaluator.hpp"
+#include "hesiod/model/graph/graph_node.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/broadcast_node.hpp"
 #include "hesiod/model/nodes/node_factory.hpp"
 #include "hesiod/model/nodes/receive_node.hpp"
+#include "hesiod/model/thread_pool.hpp"
 #include "hesiod/model/utils.hpp"
 
-#include <iostream>
-
 namespace hesiod
 {
 
@@ -45,6 +55,12 @@ GraphNode::GraphNode(const std::string &id, const std::shared_ptr<GraphConfig> &
   this->set_update_callback(lambda);
 }
 
+GraphNode::~GraphNode()
+{
+  // stop the background evaluation before the graph is destroyed
+  this->evaluator.reset();
+}
+
 std::string GraphNode::add_node(const std::string &node_type)
 {
   Logger::log()->trace("GraphNode::add_node: node_type = {}", node_type);
@@ -62,6 +78,8 @@ std::string GraphNode::add_node(const std::shared_ptr<gnode::Node> &node,
 {
   Logger::log()->trace("GraphNode::add_node: id = {}", id);
 
+  auto lock = this->suspend_async_update();
+
   // basic GNode adding...
   std::string node_id = gnode::Graph::add_node(node, id);
 
@@ -70,16 +88,35 @@ std::string GraphNode::add_node(const std::shared_ptr<gnode::Node> &node,
 
   p_basenode->compute_started = [this](const std::string &node_id)
   {
-    if (this->compute_started)
+    if (this->compute_started && !this->is_scheduling)
       this->compute_started(node_id);
   };
 
   p_basenode->compute_finished = [this](const std::string &node_id)
   {
-    if (this->compute_finished)
+    if (this->compute_finished && !this->is_scheduling)
       this->compute_finished(node_id);
   };
 
+  p_basenode->get_upstream_hash = [this, p_basenode](int port_index)
+  { return this->get_upstream_hash(p_basenode->get_id(), port_index); };
+
+  p_basenode->get_upstream_tile_hashes = [this, p_basenode](int port_index)
+  { return this->get_upstream_tile_hashes(p_basenode->get_id(), port_index); };
+
+  p_basenode->get_upstream_preview_pyramid = [this, p_basenode](int port_index)
+  { return this->get_upstream_preview_pyramid(p_basenode->get_id(), port_index); };
+
+  p_basenode->try_lock_upstream_data = [this, p_basenode](int port_index)
+  { return this->try_lock_upstream_data(p_basenode->get_id(), port_index); };
+
+  p_basenode->get_export_queue = [this]() -> ExportQueue &
+  { return this->p_export_queue ? *this->p_export_queue : HSD_CTX.export_queue; };
+
+  p_basenode->try_suspend_async_update =
+      [this](std::unique_lock<std::recursive_mutex> &lock)
+  { return this->try_suspend_async_update(lock); };
+
   // "special" nodes treatmentxs
   std::string node_type = p_basenode->get_node_type();
 
@@ -92,10 +129,20 @@ std::string GraphNode::add_node(const std::shared_ptr<gnode::Node> &node,
   return node_id;
 }
 
+void GraphNode::cancel_async_update()
+{
+  Logger::log()->trace("GraphNode::cancel_async_update");
+
+  if (this->evaluator)
+    this->evaluator->cancel();
+}
+
 void GraphNode::change_config_values(const GraphConfig &new_config)
 {
   Logger::log()->trace("GraphNode::change_config_values");
 
+  auto lock = this->suspend_async_update();
+
   *this->config = new_config;
 
   for (auto &[id, p_node] : this->get_nodes())
@@ -107,6 +154,97 @@ void GraphNode::change_config_values(const GraphConfig &new_config)
 
 GraphConfig *GraphNode::get_config_ref() { return this->config.get(); }
 
+std::vector<std::string> GraphNode::get_downstream_node_ids(
+    const std::string &node_id) const
+{
+  // the node itself and every node reachable from it
+  std::vector<std::string> ids = {node_id};
+  std::set<std::string>    visited = {node_id};
+
+  for (size_t k = 0; k < ids.size(); ++k)
+    for (auto &link : this->links)
+      if (link.from == ids[k] && !visited.contains(link.to))
+      {
+        visited.insert(link.to);
+        ids.push_back(link.to);
+      }
+
+  return ids;
+}
+
+uint64_t GraphNode::get_upstream_hash(const std::string &node_id, int port_index) const
+{
+  for (auto &link : this->links)
+    if (link.to == node_id && link.port_to == port_index)
+    {
+      auto it = this->nodes.find(link.from);
+      if (it == this->nodes.end())
+        return 0;
+
+      BaseNode *p_from = dynamic_cast<BaseNode *>(it->second.get());
+      if (!p_from || !p_from->get_output_hash())
+        return 0;
+
+      // same node, different output ports
+      return hash_combine(p_from->get_output_hash(), static_cast<uint64_t>(link.port_from));
+    }
+
+  return 0;
+}
+
+std::shared_ptr<const PreviewPyramid> GraphNode::get_upstream_preview_pyramid(
+    const std::string &node_id,
+    int                port_index) const
+{
+  for (auto &link : this->links)
+    if (link.to == node_id && link.port_to == port_index)
+    {
+      auto it = this->nodes.find(link.from);
+      if (it == this->nodes.end())
+        return nullptr;
+
+      BaseNode *p_from = dynamic_cast<BaseNode *>(it->second.get());
+      return p_from ? p_from->get_preview_pyramid(link.port_from) : nullptr;
+    }
+
+  return nullptr;
+}
+
+const TileHashes *GraphNode::get_upstream_tile_hashes(const std::string &node_id,
+                                                     int                port_index) const
+{
+  for (auto &link : this->links)
+    if (link.to == node_id && link.port_to == port_index)
+    {
+      auto it = this->nodes.find(link.from);
+      if (it == this->nodes.end())
+        return nullptr;
+
+      BaseNode *p_from = dynamic_cast<BaseNode *>(it->second.get());
+      return p_from ? p_from->get_output_tile_hashes(link.port_from) : nullptr;
+    }
+
+  return nullptr;
+}
+
+std::vector<std::string> GraphNode::get_upstream_node_ids(
+    const std::vector<std::string> &node_ids) const
+{
+  // the nodes themselves and every node they can be reached from
+  std::vector<std::string> ids = node_ids;
+  std::set<std::string>    visited(node_ids.begin(), node_ids.end());
+
+  for (size_t k = 0; k < ids.size(); ++k)
+    for (auto &link : this->links)
+      if (link.to == ids[k] && !visited.contains(link.from))
+      {
+        visited.insert(link.from);
+        ids.push_back(link.from);
+      }
+
+  return ids;
+}
+
 std::shared_ptr<GraphNode> GraphNode::get_shared()
 {
   try
@@ -124,6 +262,8 @@ void GraphNode::json_from(nlohmann::json const &json, GraphConfig *p_input_confi
 {
   Logger::log()->trace("GraphNode::json_from, graph {}", this->get_id());
 
+  auto lock = this->suspend_async_update();
+
   // override the current config if one is provided
   if (p_input_config)
   {
@@ -292,8 +432,15 @@ void GraphNode::on_broadcast_node_updated(const std::string &tag)
         else
         {
           // only update Receive nodes with the proper tag
+          // stay in the background when the broadcast comes from an
+          // asynchronous evaluation
           if (p_receive_node->get_current_tag() == tag)
-            this->update(node_id);
+          {
+            if (GraphEvaluator::is_worker_thread())
+              this->request_update(node_id);
+            else
+              this->update(node_id);
+          }
         }
       }
   }
@@ -303,6 +450,8 @@ void GraphNode::remove_node(const std::string &id)
 {
   Logger::log()->trace("GraphNode::remove_node: id = {}", id);
 
+  auto lock = this->suspend_async_update();
+
   // "special" nodes treatment
   BaseNode *p_basenode = this->get_node_ref_by_id<BaseNode>(id);
 
@@ -328,6 +477,25 @@ void GraphNode::remove_node(const std::string &id)
   gnode::Graph::remove_node(id);
 }
 
+void GraphNode::request_update(const std::string &node_id)
+{
+  Logger::log()->trace("GraphNode::request_update: id = {}", node_id);
+
+  if (!HSD_CTX.app_settings.model.enable_async_update)
+  {
+    if (node_id.empty())
+      this->update();
+    else
+      this->update(node_id);
+    return;
+  }
+
+  if (!this->evaluator)
+    this->evaluator = std::make_unique<GraphEvaluator>(this);
+
+  this->evaluator->request_update(node_id);
+}
+
 void GraphNode::reseed(bool backward)
 {
   Logger::log()->trace("GraphNode::reseed: {}", this->get_id());
@@ -350,6 +518,14 @@ void GraphNode::set_p_broadcast_params(BroadcastMap *new_p_broadcast_params)
   this->p_broadcast_params = new_p_broadcast_params;
 }
 
+void GraphNode::set_p_export_queue(ExportQueue *new_p_export_queue)
+{
+  Logger::log()->trace("GraphNode::set_p_export_queue: ptr = {}",
+                       new_p_export_queue ? "OK" : "nullptr");
+
+  this->p_export_queue = new_p_export_queue;
+}
+
 void GraphNode::setup_new_broadcast_node(BaseNode *p_node)
 {
   Logger::log()->trace("GraphNode::setup_new_broadcast_node");
@@ -403,14 +579,63 @@ void GraphNode::setup_new_receive_node(BaseNode *p_node)
   p_receive_node->set_p_coord_frame(dynamic_cast<hmap::CoordFrame *>(this));
 }
 
+std::unique_lock<std::recursive_mutex> GraphNode::suspend_async_update()
+{
+  if (!this->evaluator)
+    return {};
+
+  return this->evaluator->suspend();
+}
+
+bool GraphNode::try_suspend_async_update(std::unique_lock<std::recursive_mutex> &lock)
+{
+  if (!this->evaluator)
+    return true;
+
+  lock = this->evaluator->try_suspend();
+  return lock.owns_lock();
+}
+
+std::shared_lock<std::shared_mutex> GraphNode::try_lock_upstream_data(
+    const std::string &node_id,
+    int                port_index) const
+{
+  for (auto &link : this->links)
+    if (link.to == node_id && link.port_to == port_index)
+    {
+      auto it = this->nodes.find(link.from);
+      if (it == this->nodes.end())
+        return {};
+
+      BaseNode *p_from = dynamic_cast<BaseNode *>(it->second.get());
+      return p_from ? p_from->try_lock_data(link.port_from)
+                    : std::shared_lock<std::shared_mutex>();
+    }
+
+  return {};
+}
+
 void GraphNode::update()
 {
   Logger::log()->trace("GraphNode::update");
 
+  auto lock = this->suspend_async_update();
+
   if (this->update_started)
     this->update_started();
 
-  gnode::Graph::update();
+  if (HSD_CTX.app_settings.model.enable_parallel_update)
+  {
+    std::vector<std::string> node_ids;
+    for (auto &[id, _] : this->nodes)
+      node_ids.push_back(id);
+
+    this->update_parallel(node_ids);
+  }
+  else
+  {
+    gnode::Graph::update();
+  }
 
   if (this->update_finished)
     this->update_finished();
@@ -420,13 +645,330 @@ void GraphNode::update(const std::string &node_id)
 {
   Logger::log()->trace("GraphNode::update: id = {}", node_id);
 
+  auto lock = this->suspend_async_update();
+
   if (this->update_started)
     this->update_started();
 
-  gnode::Graph::update(node_id);
+  if (HSD_CTX.app_settings.model.enable_parallel_update)
+    this->update_parallel(this->get_downstream_node_ids(node_id));
+  else
+    gnode::Graph::update(node_id);
 
   if (this->update_finished)
     this->update_finished();
 }
 
+bool GraphNode::update_progressive(const std::vector<std::string> &node_ids,
+                                   const std::atomic<bool>        *p_cancel)
+{
+  Logger::log()->trace("GraphNode::update_progressive: {} node(s)", node_ids.size());
+
+  const GraphConfig full_config = *this->config;
+
+  // coarse shape, same aspect ratio and same tiling
+  const int   resolution = HSD_CTX.app_settings.model.preview_resolution;
+  const int   nmax = std::max(full_config.shape.x, full_config.shape.y);
+  const float ratio = float(resolution) / float(nmax);
+
+  if (node_ids.empty() || ratio >= 1.f)
+    return this->update_parallel(node_ids, p_cancel);
+
+  auto coarse_size = [ratio](int n, int ntiles)
+  {
+    int tile_size = int(std::round(float(n) * ratio / float(ntiles)));
+    return std::max(1, tile_size) * ntiles;
+  };
+
+  // the coarse pass uses its own configuration, the graph configuration is shared with
+  // the GUI and left untouched
+  auto sp_preview_config = std::make_shared<GraphConfig>(full_config);
+  sp_preview_config->set_shape({coarse_size(full_config.shape.x, full_config.tiling.x),
+                                coarse_size(full_config.shape.y, full_config.tiling.y)});
+
+  // the coarse pass also needs the nodes feeding the requested ones
+  std::vector<std::string> preview_ids = this->get_upstream_node_ids(node_ids);
+  std::set<std::string>    requested(node_ids.begin(), node_ids.end());
+
+  for (auto &id : preview_ids)
+  {
+    // coarse data must not leak to other graphs
+    const std::string node_type = this->get_node_ref_by_id<BaseNode>(id)->get_node_type();
+    if (node_type == "Broadcast" || node_type == "Receive")
+      return this->update_parallel(node_ids, p_cancel);
+  }
+
+  // --- coarse pass
+
+  for (auto &id : preview_ids)
+  {
+    BaseNode *p_node = this->get_node_ref_by_id<BaseNode>(id);
+
+    if (!requested.contains(id))
+      p_node->backup_outputs();
+
+    p_node->set_config_ref(sp_preview_config);
+  }
+
+  bool done = this->update_parallel(preview_ids, p_cancel);
+
+  // --- back to full resolution, upstream nodes get their outputs back while the
+  // requested nodes keep their coarse outputs until the full resolution pass replaces
+  // them
+
+  for (auto &id : preview_ids)
+  {
+    BaseNode *p_node = this->get_node_ref_by_id<BaseNode>(id);
+
+    if (requested.contains(id))
+    {
+      p_node->set_config_ref(this->config, true);
+      continue;
+    }
+
+    p_node->set_config_ref(this->config);
+    p_node->restore_outputs();
+
+    if (this->compute_finished)
+      this->compute_finished(id);
+  }
+
+  // --- full resolution pass
+
+  if (done)
+    done = this->update_parallel(node_ids, p_cancel);
+
+  // requested nodes not reached by a cancelled update, the coarse configuration is
+  // released along with this scope
+  for (auto &id : node_ids)
+    this->get_node_ref_by_id<BaseNode>(id)->apply_pending_config();
+
+  return done;
+}
+
+bool GraphNode::update_parallel(const std::vector<std::string> &node_ids,
+                                const std::atomic<bool>        *p_cancel)
+{
+  Logger::log()->trace("GraphNode::update_parallel: {} node(s)", node_ids.size());
+
+  if (node_ids.empty())
+    return true;
+
+  // --- dependencies restricted to the nodes to update
+
+  std::set<std::string>                           id_set(node_ids.begin(), node_ids.end());
+  std::map<std::string, int>                      indegree;
+  std::map<std::string, std::vector<std::string>> children;
+
+  for (auto &id : node_ids)
+    indegree[id] = 0;
+
+  for (auto &link : this->links)
+    if (id_set.contains(link.from) && id_set.contains(link.to))
+    {
+      children[link.from].push_back(link.to);
+      indegree[link.to]++;
+    }
+
+  // --- topological rank (Kahn), used for dispatching priority and
+  // --- for the deterministic publication of the results
+
+  std::vector<std::string> sorted_ids;
+  {
+    std::map<std::string, int> count = indegree;
+    std::set<std::string>      front;
+
+    for (auto &[id, n] : count)
+      if (n == 0)
+        front.insert(id);
+
+    while (!front.empty())
+    {
+      std::string id = *front.begin();
+      front.erase(front.begin());
+      sorted_ids.push_back(id);
+
+      for (auto &child : children[id])
+        if (--count[child] == 0)
+          front.insert(child);
+    }
+  }
+
+  if (sorted_ids.size() != node_ids.size())
+  {
+    Logger::log()->error("GraphNode::update_parallel: cycle detected, {} node(s) "
+                         "cannot be scheduled",
+                         node_ids.size() - sorted_ids.size());
+    return true;
+  }
+
+  std::map<std::string, size_t> rank;
+  for (size_t k = 0; k < sorted_ids.size(); ++k)
+    rank[sorted_ids[k]] = k;
+
+  // --- scheduler state
+
+  const auto  &model_settings = HSD_CTX.app_settings.model;
+  const bool   deterministic = model_settings.deterministic_update_order;
+  const size_t nids = sorted_ids.size();
+  const size_t nthreads = model_settings.enable_parallel_update
+                              ? std::min(get_default_thread_count(
+                                             model_settings.update_thread_count),
+                                         nids)
+                              : 1;
+
+  auto is_cancelled = [p_cancel]() { return p_cancel && p_cancel->load(); };
+
+  auto cmp = [&rank](const std::string &a, const std::string &b)
+  { return rank.at(a) > rank.at(b); };
+
+  std::priority_queue<std::string, std::vector<std::string>, decltype(cmp)> ready(cmp);
+
+  for (auto &id : sorted_ids)
+    if (indegree[id] == 0)
+      ready.push(id);
+
+  std::mutex              mutex;
+  std::condition_variable cv_done;
+  std::deque<std::string> done_queue;
+  std::set<std::string>   finished;
+  size_t                  next_publish = 0;
+  size_t                  npublished = 0;
+  size_t                  ncompleted = 0;
+  size_t                  nrunning = 0;
+
+  // results are published on the calling thread only, the workers
+  // never trigger the callbacks
+  auto publish = [this, &npublished, nids](const std::string &id)
+  {
+    npublished++;
+
+    if (this->compute_finished)
+      this->compute_finished(id);
+
+    // same convention as the sequential update, 100% after the last node
+    float r = static_cast<float>(npublished) - 0.5f;
+    float progress = 100.f * r / (static_cast<float>(nids) - 0.5f);
+
+    if (this->update_progress)
+      this->update_progress(id, progress);
+  };
+
+  auto complete = [&](const std::string &id)
+  {
+    ncompleted++;
+    finished.insert(id);
+
+    if (deterministic)
+    {
+      while (next_publish < nids && finished.contains(sorted_ids[next_publish]))
+        publish(sorted_ids[next_publish++]);
+    }
+    else
+    {
+      publish(id);
+    }
+
+    for (auto &child : children[id])
+      if (--indegree[child] == 0)
+        ready.push(child);
+  };
+
+  auto run_compute = [p_cancel](BaseNode *p_node)
+  {
+    if (!p_node)
+      return;
+
+    // nodes can also check the cancellation between tiles
+    p_node->set_cancel_flag(p_cancel);
+
+    try
+    {
+      p_node->compute();
+    }
+    catch (const std::exception &e)
+    {
+      Logger::log()->error("GraphNode::update_parallel: node {} failed: {}",
+                           p_node->get_id(),
+                           e.what());
+    }
+
+    p_node->set_cancel_flag(nullptr);
+  };
+
+  // --- run
+
+  this->is_scheduling = true;
+
+  if (this->update_progress)
+    this->update_progress(sorted_ids.front(), 0.f);
+
+  {
+    ThreadPool pool(nthreads);
+
+    while (ncompleted < nids)
+    {
+      // dispatch every node whose inputs are ready
+      while (!ready.empty() && !is_cancelled())
+      {
+        std::string id = ready.top();
+        ready.pop();
+
+        BaseNode *p_node = this->get_node_ref_by_id<BaseNode>(id);
+
+        if (this->compute_started)
+          this->compute_started(id);
+
+        // broadcasting triggers the update of other graphs, keep it
+        // on the calling thread
+        if (p_node && p_node->get_node_type() == "Broadcast")
+        {
+          run_compute(p_node);
+          complete(id);
+          continue;
+        }
+
+        nrunning++;
+        pool.submit(
+            [&, p_node, id]()
+            {
+              run_compute(p_node);
+              {
+                std::lock_guard<std::mutex> lock(mutex);
+                done_queue.push_back(id);
+              }
+              cv_done.notify_one();
+            });
+      }
+
+      if (ncompleted == nids || nrunning == 0)
+        break;
+
+      // wait for the next completion
+      std::string id;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_done.wait(lock, [&done_queue]() { return !done_queue.empty(); });
+        id = done_queue.front();
+        done_queue.pop_front();
+      }
+
+      nrunning--;
+
+      // the output of a node interrupted by a cancellation is not published
+      if (!is_cancelled())
+        complete(id);
+    }
+  } // workers joined here
+
+  this->is_scheduling = false;
+
+  if (ncompleted < nids)
+    Logger::log()->trace("GraphNode::update_parallel: cancelled after {}/{} node(s)",
+                         ncompleted,
+                         nids);
+
+  return ncompleted == nids;
+}
+
 } // namespace hesiod
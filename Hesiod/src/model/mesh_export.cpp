@@ -0,0 +1,651 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+#include "nlohmann/json.hpp"
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/streaming_export.hpp"
+
+namespace hesiod
+{
+
+// chunk size in cells (power of two), also the coarsest simplification stride
+static constexpr int MESH_CHUNK_CELLS = 128;
+
+// --- helpers
+
+enum MeshChunkEdge
+{
+  EDGE_LEFT,
+  EDGE_RIGHT,
+  EDGE_BOTTOM,
+  EDGE_TOP
+};
+
+struct MeshChunk
+{
+  ExportBlock block;                // vertices, shared with the neighbor chunks
+  int         stride = 1;           // interior grid step, in cells
+  int         edge_strides[4] = {}; // refined to match the neighbors
+  uint64_t    vertex_offset = 0;
+  uint64_t    index_offset = 0;
+  uint64_t    nvertices = 0;
+  uint64_t    nindices = 0;
+};
+
+struct MeshChunkTopology
+{
+  std::vector<glm::vec2> vertices; // local (fractional) indices
+  std::vector<uint32_t>  indices;  // counter-clockwise seen from above
+};
+
+static std::vector<int> get_grid_lines(int ncells, int stride)
+{
+  std::vector<int> lines;
+
+  for (int k = 0; k < ncells; k += stride)
+    lines.push_back(k);
+
+  lines.push_back(ncells);
+  return lines;
+}
+
+// largest error between the heightmap and its triangulation on the regular grid of
+// step 'stride', cells being split along the (i + 1, j), (i, j + 1) diagonal
+static bool is_within_tolerance(const hmap::Array &block, int stride, float tolerance)
+{
+  const std::vector<int> xs = get_grid_lines(block.shape.x - 1, stride);
+  const std::vector<int> ys = get_grid_lines(block.shape.y - 1, stride);
+
+  for (size_t p = 0; p + 1 < xs.size(); ++p)
+    for (size_t q = 0; q + 1 < ys.size(); ++q)
+    {
+      const int   xa = xs[p], xb = xs[p + 1];
+      const int   ya = ys[q], yb = ys[q + 1];
+      const float a = block(xa, ya);
+      const float b = block(xb, ya);
+      const float c = block(xa, yb);
+      const float d = block(xb, yb);
+
+      for (int i = xa; i <= xb; ++i)
+        for (int j = ya; j <= yb; ++j)
+        {
+          const float u = float(i - xa) / float(xb - xa);
+          const float v = float(j - ya) / float(yb - ya);
+          const float h = u + v <= 1.f ? a + u * (b - a) + v * (c - a)
+                                       : d + (1.f - u) * (c - d) + (1.f - v) * (b - d);
+
+          if (std::abs(block(i, j) - h) > tolerance)
+            return false;
+        }
+    }
+
+  return true;
+}
+
+static int select_stride(const hmap::Array &block, float tolerance)
+{
+  for (int stride = MESH_CHUNK_CELLS; stride > 1; stride /= 2)
+    if (is_within_tolerance(block, stride, tolerance))
+      return stride;
+
+  return 1;
+}
+
+// regular grid at the chunk stride. Cells lying on a chunk border with a finer edge
+// stride get the extra border vertices and are triangulated as a fan around their
+// center, so that the chunk borders match exactly the ones of the neighbors
+static MeshChunkTopology get_chunk_topology(const MeshChunk &chunk)
+{
+  MeshChunkTopology                      topo;
+  std::unordered_map<uint64_t, uint32_t> ids;
+  std::vector<uint32_t>                  perimeter;
+
+  auto vertex = [&](int i, int j)
+  {
+    const uint64_t key = (uint64_t(i) << 32) | uint64_t(j);
+    auto [it, inserted] = ids.try_emplace(key, uint32_t(topo.vertices.size()));
+
+    if (inserted)
+      topo.vertices.push_back({float(i), float(j)});
+
+    return it->second;
+  };
+
+  const glm::ivec2       ncells = chunk.block.shape - 1;
+  const std::vector<int> xs = get_grid_lines(ncells.x, chunk.stride);
+  const std::vector<int> ys = get_grid_lines(ncells.y, chunk.stride);
+
+  for (size_t p = 0; p + 1 < xs.size(); ++p)
+    for (size_t q = 0; q + 1 < ys.size(); ++q)
+    {
+      const int xa = xs[p], xb = xs[p + 1];
+      const int ya = ys[q], yb = ys[q + 1];
+
+      // edge strides of the cell sides lying on the chunk borders, 0 otherwise
+      const int e_left = xa == 0 ? chunk.edge_strides[EDGE_LEFT] : 0;
+      const int e_right = xb == ncells.x ? chunk.edge_strides[EDGE_RIGHT] : 0;
+      const int e_bottom = ya == 0 ? chunk.edge_strides[EDGE_BOTTOM] : 0;
+      const int e_top = yb == ncells.y ? chunk.edge_strides[EDGE_TOP] : 0;
+
+      // counter-clockwise
+      perimeter.clear();
+      perimeter.push_back(vertex(xa, ya));
+
+      if (e_bottom)
+        for (int i = (xa / e_bottom + 1) * e_bottom; i < xb; i += e_bottom)
+          perimeter.push_back(vertex(i, ya));
+
+      perimeter.push_back(vertex(xb, ya));
+
+      if (e_right)
+        for (int j = (ya / e_right + 1) * e_right; j < yb; j += e_right)
+          perimeter.push_back(vertex(xb, j));
+
+      perimeter.push_back(vertex(xb, yb));
+
+      if (e_top)
+        for (int i = ((xb - 1) / e_top) * e_top; i > xa; i -= e_top)
+          perimeter.push_back(vertex(i, yb));
+
+      perimeter.push_back(vertex(xa, yb));
+
+      if (e_left)
+        for (int j = ((yb - 1) / e_left) * e_left; j > ya; j -= e_left)
+          perimeter.push_back(vertex(xa, j));
+
+      if (perimeter.size() == 4)
+      {
+        topo.indices.insert(topo.indices.end(),
+                            {perimeter[0],
+                             perimeter[1],
+                             perimeter[3],
+                             perimeter[1],
+                             perimeter[2],
+                             perimeter[3]});
+      }
+      else
+      {
+        const uint32_t center = uint32_t(topo.vertices.size());
+        topo.vertices.push_back({0.5f * float(xa + xb), 0.5f * float(ya + yb)});
+
+        for (size_t k = 0; k < perimeter.size(); ++k)
+          topo.indices.insert(
+              topo.indices.end(),
+              {center, perimeter[k], perimeter[(k + 1) % perimeter.size()]});
+      }
+    }
+
+  return topo;
+}
+
+static float sample_bilinear(const hmap::Array &block, const glm::vec2 &ij)
+{
+  const int   i = std::min(int(ij.x), block.shape.x - 2);
+  const int   j = std::min(int(ij.y), block.shape.y - 2);
+  const float u = ij.x - float(i);
+  const float v = ij.y - float(j);
+
+  return (1.f - u) * (1.f - v) * block(i, j) + u * (1.f - v) * block(i + 1, j) +
+         (1.f - u) * v * block(i, j + 1) + u * v * block(i + 1, j + 1);
+}
+
+// interleaved position (x, elevation, -y) and texture coordinates (image rows from top)
+static std::vector<float> get_chunk_vertices(const MeshChunk         &chunk,
+                                             const MeshChunkTopology &topo,
+                                             const hmap::Array       &block,
+                                             const glm::ivec2        &shape,
+                                             float                    elevation_scaling)
+{
+  std::vector<float> data;
+  data.reserve(topo.vertices.size() * 5);
+
+  for (const glm::vec2 &ij : topo.vertices)
+  {
+    const float x = (float(chunk.block.ij0.x) + ij.x) / float(shape.x - 1);
+    const float y = (float(chunk.block.ij0.y) + ij.y) / float(shape.y - 1);
+    const float z = elevation_scaling * sample_bilinear(block, ij);
+
+    data.insert(data.end(), {x, z, -y, x, 1.f - y});
+  }
+
+  return data;
+}
+
+static nlohmann::json get_gltf_json(uint64_t                 nvertices,
+                                    uint64_t                 nindices,
+                                    const glm::vec2         &zrange,
+                                    const MeshExportOptions &options)
+{
+  const uint64_t vertex_bytes = nvertices * 5 * sizeof(float);
+  const uint64_t index_bytes = nindices * sizeof(uint32_t);
+
+  nlohmann::json json;
+
+  json["asset"] = {{"version", "2.0"}, {"generator", "Hesiod"}};
+  json["scene"] = 0;
+  json["scenes"] = {{{"nodes", {0}}}};
+  json["nodes"] = {{{"mesh", 0}}};
+  json["buffers"] = {{{"byteLength", vertex_bytes + index_bytes}}};
+
+  // ARRAY_BUFFER (34962) and ELEMENT_ARRAY_BUFFER (34963)
+  json["bufferViews"] = {{{"buffer", 0},
+                          {"byteOffset", 0},
+                          {"byteLength", vertex_bytes},
+                          {"byteStride", 5 * sizeof(float)},
+                          {"target", 34962}},
+                         {{"buffer", 0},
+                          {"byteOffset", vertex_bytes},
+                          {"byteLength", index_bytes},
+                          {"target", 34963}}};
+
+  // FLOAT (5126) and UNSIGNED_INT (5125)
+  json["accessors"] = {{{"bufferView", 0},
+                        {"byteOffset", 0},
+                        {"componentType", 5126},
+                        {"count", nvertices},
+                        {"type", "VEC3"},
+                        {"min", {0.f, zrange.x, -1.f}},
+                        {"max", {1.f, zrange.y, 0.f}}},
+                       {{"bufferView", 0},
+                        {"byteOffset", 3 * sizeof(float)},
+                        {"componentType", 5126},
+                        {"count", nvertices},
+                        {"type", "VEC2"}},
+                       {{"bufferView", 1},
+                        {"componentType", 5125},
+                        {"count", nindices},
+                        {"type", "SCALAR"}}};
+
+  // material, the images are referenced relative to the mesh file
+  nlohmann::json material = {{"pbrMetallicRoughness", {{"metallicFactor", 0.f}}}};
+  nlohmann::json images = nlohmann::json::array();
+
+  auto add_image = [&](const std::string &fname)
+  {
+    images.push_back({{"uri", std::filesystem::path(fname).filename().string()}});
+    return images.size() - 1;
+  };
+
+  if (!options.texture_fname.empty())
+    material["pbrMetallicRoughness"]["baseColorTexture"] = {
+        {"index", add_image(options.texture_fname)}};
+
+  if (!options.normal_map_fname.empty())
+    material["normalTexture"] = {{"index", add_image(options.normal_map_fname)}};
+
+  nlohmann::json primitive = {{"attributes", {{"POSITION", 0}, {"TEXCOORD_0", 1}}},
+                              {"indices", 2},
+                              {"mode", 4}}; // triangles
+
+  if (!images.empty())
+  {
+    json["images"] = images;
+    json["textures"] = nlohmann::json::array();
+
+    for (size_t k = 0; k < images.size(); ++k)
+      json["textures"].push_back({{"source", k}});
+
+    json["materials"] = {material};
+    primitive["material"] = 0;
+  }
+
+  json["meshes"] = {{{"primitives", {primitive}}}};
+
+  return json;
+}
+
+template <typename T> static void write_le(std::ostream &file, T value)
+{
+  file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static bool write_glb(const std::string              &fname,
+                      std::vector<MeshChunk>         &chunks,
+                      hmap::VirtualArray             &array,
+                      const glm::ivec2               &tile_shape,
+                      const std::vector<ExportBlock> &blocks,
+                      const MeshExportOptions        &options,
+                      const hmap::ComputeMode        &cm)
+{
+  const glm::ivec2 shape = array.shape;
+  uint64_t         nvertices = 0;
+  uint64_t         nindices = 0;
+
+  for (auto &chunk : chunks)
+  {
+    chunk.vertex_offset = nvertices;
+    chunk.index_offset = nindices;
+    nvertices += chunk.nvertices;
+    nindices += chunk.nindices;
+  }
+
+  if (nvertices > std::numeric_limits<uint32_t>::max())
+  {
+    Logger::log()->error("export_mesh_streamed: too many vertices for 32 bit indices");
+    return false;
+  }
+
+  // the JSON chunk comes first, its size is reserved and the elevation range
+  // (accessor bounds) is filled once all the vertices are known
+  const glm::vec2 zrange_max = {-std::numeric_limits<float>::max(),
+                                std::numeric_limits<float>::max()};
+  const size_t    json_size = (get_gltf_json(nvertices, nindices, zrange_max, options)
+                                   .dump()
+                                   .size() +
+                               64 + 3) &
+                           ~size_t(3);
+
+  const uint64_t bin_size = nvertices * 5 * sizeof(float) + nindices * sizeof(uint32_t);
+  const uint64_t bin_start = 12 + 8 + json_size + 8;
+  const uint64_t total_size = bin_start + bin_size;
+
+  if (total_size > std::numeric_limits<uint32_t>::max())
+  {
+    Logger::log()->error("export_mesh_streamed: mesh too large for a glb file ({} bytes)",
+                         total_size);
+    return false;
+  }
+
+  std::ofstream file(fname, std::ios::binary);
+  if (!file.is_open())
+  {
+    Logger::log()->error("export_mesh_streamed: could not open {}", fname);
+    return false;
+  }
+
+  // allocate the whole file, the chunks are written at their own offset
+  file.seekp(total_size - 1);
+  file.put('\0');
+
+  ParallelTileWriter writer;
+  std::mutex         mutex;
+  glm::vec2          zrange = {std::numeric_limits<float>::max(),
+                               -std::numeric_limits<float>::max()};
+
+  auto write_chunk = [&](size_t k, std::vector<hmap::Array> &block)
+  {
+    auto sp_block = std::make_shared<hmap::Array>(std::move(block[0]));
+
+    writer.submit(
+        [&, k, sp_block]()
+        {
+          const MeshChunk        &chunk = chunks[k];
+          const MeshChunkTopology topo = get_chunk_topology(chunk);
+
+          std::vector<float> vertices = get_chunk_vertices(chunk,
+                                                           topo,
+                                                           *sp_block,
+                                                           shape,
+                                                           options.elevation_scaling);
+
+          std::vector<uint32_t> indices = topo.indices;
+          for (uint32_t &index : indices)
+            index += uint32_t(chunk.vertex_offset);
+
+          glm::vec2 chunk_zrange = {std::numeric_limits<float>::max(),
+                                    -std::numeric_limits<float>::max()};
+
+          for (size_t n = 1; n < vertices.size(); n += 5)
+            chunk_zrange = {std::min(chunk_zrange.x, vertices[n]),
+                            std::max(chunk_zrange.y, vertices[n])};
+
+          std::lock_guard<std::mutex> lock(mutex);
+
+          zrange = {std::min(zrange.x, chunk_zrange.x),
+                    std::max(zrange.y, chunk_zrange.y)};
+
+          file.seekp(bin_start + chunk.vertex_offset * 5 * sizeof(float));
+          file.write(reinterpret_cast<const char *>(vertices.data()),
+                     vertices.size() * sizeof(float));
+
+          file.seekp(bin_start + nvertices * 5 * sizeof(float) +
+                     chunk.index_offset * sizeof(uint32_t));
+          file.write(reinterpret_cast<const char *>(indices.data()),
+                     indices.size() * sizeof(uint32_t));
+
+          return file.good();
+        });
+
+    return true;
+  };
+
+  bool ok = stream_export_blocks({&array}, tile_shape, blocks, write_chunk, cm);
+  ok = writer.wait() && ok;
+
+  // header and JSON chunk (padded with spaces)
+  std::string json_str = get_gltf_json(nvertices, nindices, zrange, options).dump();
+  json_str.resize(json_size, ' ');
+
+  file.seekp(0);
+  file.write("glTF", 4);
+  write_le(file, uint32_t(2));
+  write_le(file, uint32_t(total_size));
+  write_le(file, uint32_t(json_size));
+  file.write("JSON", 4);
+  file.write(json_str.data(), json_str.size());
+  write_le(file, uint32_t(bin_size));
+  file.write("BIN\0", 4);
+
+  return ok && file.good();
+}
+
+static bool write_obj(const std::string              &fname,
+                      const std::vector<MeshChunk>   &chunks,
+                      hmap::VirtualArray             &array,
+                      const glm::ivec2               &tile_shape,
+                      const std::vector<ExportBlock> &blocks,
+                      const MeshExportOptions        &options,
+                      const hmap::ComputeMode        &cm)
+{
+  const glm::ivec2 shape = array.shape;
+
+  // material
+  if (!options.texture_fname.empty() || !options.normal_map_fname.empty())
+  {
+    std::filesystem::path fname_mtl = fname;
+    fname_mtl.replace_extension(".mtl");
+
+    std::ofstream mtl(fname_mtl);
+    mtl << "newmtl terrain\nKd 1 1 1\n";
+
+    if (!options.texture_fname.empty())
+      mtl << "map_Kd " << std::filesystem::path(options.texture_fname).filename().string()
+          << "\n";
+
+    if (!options.normal_map_fname.empty())
+      mtl << "norm "
+          << std::filesystem::path(options.normal_map_fname).filename().string() << "\n";
+  }
+
+  std::ofstream file(fname);
+  if (!file.is_open())
+  {
+    Logger::log()->error("export_mesh_streamed: could not open {}", fname);
+    return false;
+  }
+
+  file << "# Hesiod\n";
+
+  if (!options.texture_fname.empty() || !options.normal_map_fname.empty())
+    file << "mtllib "
+         << std::filesystem::path(fname).replace_extension(".mtl").filename().string()
+         << "\nusemtl terrain\n";
+
+  // chunks are appended in completion order, faces use indices relative to the
+  // vertices of their own chunk (negative indices), written right before them
+  ParallelTileWriter writer;
+  std::mutex         mutex;
+
+  auto write_chunk = [&](size_t k, std::vector<hmap::Array> &block)
+  {
+    auto sp_block = std::make_shared<hmap::Array>(std::move(block[0]));
+
+    writer.submit(
+        [&, k, sp_block]()
+        {
+          const MeshChunk        &chunk = chunks[k];
+          const MeshChunkTopology topo = get_chunk_topology(chunk);
+
+          std::vector<float> vertices = get_chunk_vertices(chunk,
+                                                           topo,
+                                                           *sp_block,
+                                                           shape,
+                                                           options.elevation_scaling);
+          std::string        str;
+          const int64_t      nv = int64_t(topo.vertices.size());
+
+          for (size_t n = 0; n < vertices.size(); n += 5)
+            str += std::format("v {} {} {}\n",
+                               vertices[n],
+                               vertices[n + 1],
+                               vertices[n + 2]);
+
+          for (size_t n = 0; n < vertices.size(); n += 5)
+            str += std::format("vt {} {}\n", vertices[n + 3], 1.f - vertices[n + 4]);
+
+          for (size_t n = 0; n < topo.indices.size(); n += 3)
+          {
+            const int64_t a = int64_t(topo.indices[n]) - nv;
+            const int64_t b = int64_t(topo.indices[n + 1]) - nv;
+            const int64_t c = int64_t(topo.indices[n + 2]) - nv;
+            str += std::format("f {}/{} {}/{} {}/{}\n", a, a, b, b, c, c);
+          }
+
+          std::lock_guard<std::mutex> lock(mutex);
+          file << str;
+          return file.good();
+        });
+
+    return true;
+  };
+
+  bool ok = stream_export_blocks({&array}, tile_shape, blocks, write_chunk, cm);
+  return writer.wait() && ok && file.good();
+}
+
+// --- function
+
+bool export_mesh_streamed(hmap::VirtualArray      &array,
+                          const glm::ivec2        &tile_shape,
+                          const std::string       &fname,
+                          const MeshExportOptions &options,
+                          const hmap::ComputeMode &cm)
+{
+  Logger::log()->trace("export_mesh_streamed: {}", fname);
+
+  std::string ext = std::filesystem::path(fname).extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+  if (ext != ".glb" && ext != ".obj")
+  {
+    Logger::log()->error("export_mesh_streamed: unsupported format {}", ext);
+    return false;
+  }
+
+  const glm::ivec2 shape = array.shape;
+
+  if (shape.x < 2 || shape.y < 2)
+    return false;
+
+  // chunks, sharing their border vertices
+  std::vector<MeshChunk>   chunks;
+  std::vector<ExportBlock> blocks;
+  const glm::ivec2         nchunks = (shape - 2) / MESH_CHUNK_CELLS + 1;
+
+  for (int ci = 0; ci < nchunks.x; ++ci)
+    for (int cj = 0; cj < nchunks.y; ++cj)
+    {
+      const glm::ivec2 ij0 = glm::ivec2(ci, cj) * MESH_CHUNK_CELLS;
+
+      MeshChunk chunk;
+      chunk.block = {ij0, glm::min(glm::ivec2(MESH_CHUNK_CELLS + 1), shape - ij0)};
+
+      chunks.push_back(chunk);
+      blocks.push_back(chunk.block);
+    }
+
+  // --- coarsest stride of each chunk within the error tolerance (in elevation units)
+
+  const float tolerance = options.elevation_scaling > 0.f
+                              ? options.max_error / options.elevation_scaling
+                              : std::numeric_limits<float>::max();
+
+  if (options.simplify)
+  {
+    ParallelTileWriter workers;
+
+    auto select = [&](size_t k, std::vector<hmap::Array> &block)
+    {
+      auto sp_block = std::make_shared<hmap::Array>(std::move(block[0]));
+
+      workers.submit(
+          [&, k, sp_block]()
+          {
+            chunks[k].stride = select_stride(*sp_block, tolerance);
+            return true;
+          });
+
+      return true;
+    };
+
+    bool ok = stream_export_blocks({&array}, tile_shape, blocks, select, cm);
+
+    if (!workers.wait() || !ok)
+      return false;
+  }
+
+  // --- crack-free borders: a shared border uses the finer stride of the two chunks
+
+  auto get_stride = [&](int ci, int cj, int stride)
+  {
+    if (ci < 0 || cj < 0 || ci >= nchunks.x || cj >= nchunks.y)
+      return stride;
+
+    return std::min(stride, chunks[ci * nchunks.y + cj].stride);
+  };
+
+  for (int ci = 0; ci < nchunks.x; ++ci)
+    for (int cj = 0; cj < nchunks.y; ++cj)
+    {
+      MeshChunk &chunk = chunks[ci * nchunks.y + cj];
+
+      chunk.edge_strides[EDGE_LEFT] = get_stride(ci - 1, cj, chunk.stride);
+      chunk.edge_strides[EDGE_RIGHT] = get_stride(ci + 1, cj, chunk.stride);
+      chunk.edge_strides[EDGE_BOTTOM] = get_stride(ci, cj - 1, chunk.stride);
+      chunk.edge_strides[EDGE_TOP] = get_stride(ci, cj + 1, chunk.stride);
+
+      const MeshChunkTopology topo = get_chunk_topology(chunk);
+      chunk.nvertices = topo.vertices.size();
+      chunk.nindices = topo.indices.size();
+    }
+
+  // --- triangulation and writing, chunk by chunk
+
+  bool ok = ext == ".glb"
+                ? write_glb(fname, chunks, array, tile_shape, blocks, options, cm)
+                : write_obj(fname, chunks, array, tile_shape, blocks, options, cm);
+
+  uint64_t ntriangles = 0;
+  for (auto &chunk : chunks)
+    ntriangles += chunk.nindices / 3;
+
+  Logger::log()->trace("export_mesh_streamed: {} chunks, {} triangles (full resolution: "
+                       "{})",
+                       chunks.size(),
+                       ntriangles,
+                       2 * uint64_t(shape.x - 1) * uint64_t(shape.y - 1));
+
+  return ok;
+}
+
+} // namespace hesiod
@@ -1,6 +1,7 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <filesystem>
 #include <format>
 #include <fstream>
 #include <unordered_map>
@@ -11,12 +12,17 @@
 #include "highmap/geometry/path.hpp"
 #include "highmap/virtual_array/virtual_array.hpp"
 
+#include "attributes/filename_attribute.hpp"
 #include "attributes/seed_attribute.hpp"
 
 #include "hesiod/app/hesiod_application.hpp"
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/nodes/node_data_store.hpp"
 #include "hesiod/model/nodes/node_factory.hpp"
+#include "hesiod/model/nodes/node_output_cache.hpp"
+#include "hesiod/model/nodes/region_query.hpp"
+#include "hesiod/model/profiler.hpp"
 #include "hesiod/model/utils.hpp"
 
 namespace hesiod
@@ -38,8 +44,27 @@ std::string map_type_name(const std::string &typeid_name)
   return (it != type_name_map.end()) ? it->second : typeid_name;
 }
 
+// heightmap carried by a port, nullptr if the port data is not a heightmap
+static hmap::VirtualArray *get_heightmap_ref(BaseNode &node, int port_index)
+{
+  if (port_index < 0 || port_index >= node.get_nports() ||
+      node.get_data_type(port_index) != typeid(hmap::VirtualArray).name())
+    return nullptr;
+
+  return node.get_value_ref<hmap::VirtualArray>(port_index);
+}
+
 // --- class definition
 
+struct NodeOutputsBackup
+{
+  std::map<int, std::unique_ptr<hmap::VirtualArray>>   heightmaps;
+  std::map<int, std::unique_ptr<hmap::VirtualTexture>> textures;
+  std::map<int, hmap::Array>                           arrays;
+  uint64_t                                             output_hash = 0;
+  TileDirtyTracker                                     tile_tracker;
+};
+
 BaseNode::BaseNode(const std::string &label, std::weak_ptr<GraphConfig> config)
     : gnode::Node(label), config(config)
 {
@@ -63,9 +88,100 @@ BaseNode::BaseNode(const std::string &label, std::weak_ptr<GraphConfig> config)
   }
 }
 
+BaseNode::~BaseNode() = default;
+
+void BaseNode::add_computed_tile() const { this->ntiles_computed++; }
+
+void BaseNode::add_tile_cpu_time(int64_t ns) const
+{
+  // the node thread CPU time already includes its own tiles
+  if (std::this_thread::get_id() != this->compute_thread)
+    this->tiles_cpu_time += ns;
+}
+
+void BaseNode::apply_pending_config()
+{
+  std::unique_lock<std::shared_mutex> data_lock(this->data_mutex);
+
+  if (this->swap_pending_config())
+    this->reallocate_outputs();
+}
+
+void BaseNode::backup_outputs()
+{
+  Logger::log()->trace("BaseNode::backup_outputs: node {}/{}",
+                       this->get_caption(),
+                       this->get_id());
+
+  const GraphConfig &cfg = *this->get_config_ref();
+
+  this->outputs_backup = std::make_unique<NodeOutputsBackup>();
+  this->outputs_backup->output_hash = this->output_hash;
+  this->outputs_backup->tile_tracker = this->tile_tracker;
+
+  // only the data depending on the heightmap resolution
+  for (int k = 0; k < this->get_nports(); k++)
+    if (this->get_port_type(k) == gngui::PortType::OUT)
+    {
+      const std::string type = this->get_data_type(k);
+
+      if (type == typeid(hmap::VirtualTexture).name())
+      {
+        auto *p_v = this->get_value_ref<hmap::VirtualTexture>(k);
+        if (p_v)
+        {
+          auto sp_copy = std::make_unique<hmap::VirtualTexture>(cfg.shape,
+                                                                cfg.tile_shape,
+                                                                cfg.halo,
+                                                                4, // RGBA
+                                                                cfg.storage_mode);
+          sp_copy->copy_from(*p_v, cfg.cm_cpu);
+          this->outputs_backup->textures[k] = std::move(sp_copy);
+        }
+      }
+      else if (type == typeid(hmap::Array).name())
+      {
+        auto *p_v = this->get_value_ref<hmap::Array>(k);
+        if (p_v)
+          this->outputs_backup->arrays[k] = *p_v;
+      }
+      else if (type == typeid(hmap::VirtualArray).name())
+      {
+        auto *p_v = this->get_value_ref<hmap::VirtualArray>(k);
+        if (p_v)
+        {
+          auto sp_copy = std::make_unique<hmap::VirtualArray>(cfg.shape,
+                                                              cfg.tile_shape,
+                                                              cfg.halo,
+                                                              cfg.storage_mode);
+          sp_copy->copy_from(*p_v, cfg.cm_cpu);
+          this->outputs_backup->heightmaps[k] = std::move(sp_copy);
+        }
+      }
+    }
+}
+
+size_t BaseNode::count_tiles_to_compute() const
+{
+  if (this->tile_tracker.is_partial_update())
+    return this->tile_tracker.get_ndirty_tiles();
+
+  const GraphConfig &config = this->cfg();
+  size_t             noutputs = 0;
+
+  for (int k = 0; k < this->get_nports(); k++)
+    if (this->get_port_type(k) == gngui::PortType::OUT &&
+        this->get_data_type(k) == typeid(hmap::VirtualArray).name())
+      noutputs++;
+
+  return noutputs * size_t(config.tiling.x * config.tiling.y);
+}
+
 const GraphConfig &BaseNode::cfg() const
 {
-  auto ptr = config.lock();
+  std::unique_lock<std::mutex> lock(this->config_mutex);
+  auto                         ptr = this->config.lock();
+  lock.unlock();
 
   if (!ptr)
   {
@@ -78,14 +194,238 @@ const GraphConfig &BaseNode::cfg() const
   return *ptr;
 }
 
+#ifdef HESIOD_DEBUG_CHECKS
+void BaseNode::check_partial_update()
+{
+  // outputs of the partial update, then of a full recompute
+  std::map<int, TileHashes> partial_hashes;
+
+  for (int k = 0; k < this->get_nports(); k++)
+    if (this->get_port_type(k) == gngui::PortType::OUT &&
+        this->get_data_type(k) == typeid(hmap::VirtualArray).name())
+      partial_hashes[k] = TileDirtyTracker::get_tile_hashes(
+          *this->get_value_ref<hmap::VirtualArray>(k),
+          this->cfg().cm_cpu);
+
+  this->tile_tracker.disable_partial_update();
+  this->compute_fct(*this);
+
+  if (this->is_cancelled())
+    return;
+
+  for (auto &[k, hashes] : partial_hashes)
+  {
+    const TileHashes full_hashes = TileDirtyTracker::get_tile_hashes(
+        *this->get_value_ref<hmap::VirtualArray>(k),
+        this->cfg().cm_cpu);
+
+    size_t nmismatches = 0;
+
+    for (const auto &[key, hash] : full_hashes)
+      if (!hashes.contains(key) || hashes.at(key) != hash)
+        nmismatches++;
+
+    if (nmismatches)
+      Logger::log()->error("BaseNode::check_partial_update: node [{}]/[{}], port {}: "
+                           "{} tile(s) differ from a full recompute",
+                           this->get_node_type(),
+                           this->get_id(),
+                           this->get_port_label(k),
+                           nmismatches);
+    else
+      Logger::log()->trace("BaseNode::check_partial_update: node [{}]/[{}], port {}: "
+                           "ok",
+                           this->get_node_type(),
+                           this->get_id(),
+                           this->get_port_label(k));
+  }
+}
+#endif
+
+uint64_t BaseNode::compute_hash()
+{
+  // nodes writing files or depending on other graphs cannot be identified by their
+  // parameters (files read by a node are, see compute_parameters_hash)
+  if (this->get_category().starts_with("Export") || this->get_node_type() == "Broadcast" ||
+      this->get_node_type() == "Receive")
+    return 0;
+
+  uint64_t hash = this->compute_parameters_hash();
+
+  // upstream data
+  for (int k = 0; k < this->get_nports(); k++)
+  {
+    if (this->get_port_type(k) == gngui::PortType::OUT)
+      continue;
+
+    uint64_t upstream_hash = 0;
+
+    if (this->get_data_ref(k))
+    {
+      upstream_hash = this->get_upstream_hash ? this->get_upstream_hash(k) : 0;
+
+      // unknown upstream data
+      if (!upstream_hash)
+        return 0;
+    }
+
+    hash = hash_combine(hash, upstream_hash);
+  }
+
+  // 0 is reserved
+  return hash ? hash : 1;
+}
+
+uint64_t BaseNode::compute_parameters_hash() const
+{
+  uint64_t hash = hash_string(this->get_node_type());
+
+  // attribute values
+  const bool is_export = this->get_category().starts_with("Export");
+
+  for (const auto &[key, attr] : this->attr)
+  {
+    hash = hash_string(key, hash);
+    hash = hash_string(attr->json_to().dump(), hash);
+
+    // files read by the node, their size and modification date are included so that
+    // editing a file invalidates the cached outputs
+    if (attr->get_type() == attr::AttributeType::FILENAME && !is_export)
+    {
+      const std::filesystem::path fname = attr->get_ref<attr::FilenameAttribute>()
+                                              ->get_value();
+      std::error_code             ec;
+
+      const auto size = std::filesystem::file_size(fname, ec);
+      hash = hash_combine(hash, ec ? uint64_t(0) : static_cast<uint64_t>(size));
+
+      const auto mtime = std::filesystem::last_write_time(fname, ec);
+      hash = hash_combine(hash,
+                          ec ? uint64_t(0)
+                             : static_cast<uint64_t>(mtime.time_since_epoch().count()));
+    }
+  }
+
+  // config
+  const GraphConfig &config = this->cfg();
+
+  hash = hash_combine(hash, static_cast<uint64_t>(config.shape.x));
+  hash = hash_combine(hash, static_cast<uint64_t>(config.shape.y));
+  hash = hash_combine(hash, static_cast<uint64_t>(config.tiling.x));
+  hash = hash_combine(hash, static_cast<uint64_t>(config.tiling.y));
+  hash = hash_string(std::to_string(config.overlap), hash);
+
+  return hash;
+}
+
 void BaseNode::compute()
 {
   if (this->compute_started)
-    this->compute_finished(this->get_id());
+    this->compute_started(this->get_id());
 
   this->update_runtime_info(NodeRuntimeStep::NRS_UPDATE_START);
 
-  this->compute_fct(*this);
+  // readers from other threads are kept out while the outputs are modified
+  std::unique_lock<std::shared_mutex> data_lock(this->data_mutex);
+
+  if (this->swap_pending_config())
+    this->reallocate_outputs();
+
+  // identify the outputs before computing them, downstream nodes rely
+  // on this hash
+  this->output_hash = this->compute_hash();
+
+  const auto &model_settings = HSD_CTX.app_settings.model;
+  const bool  use_cache = model_settings.enable_node_cache && this->output_hash &&
+                         NodeOutputCache::is_cacheable(*this);
+
+  NodeOutputCache &cache = HSD_CTX.node_output_cache;
+
+  if (use_cache)
+  {
+    const size_t mb = 1024 * 1024;
+    cache.set_budget(size_t(model_settings.node_cache_budget_mb) * mb);
+    cache.set_disk_storage(model_settings.enable_disk_cache ? model_settings.node_cache_dir
+                                                            : "",
+                           size_t(model_settings.node_cache_disk_budget_mb) * mb);
+  }
+
+  // restrict the compute to the tiles affected by upstream changes, if possible
+  if (model_settings.enable_tile_update)
+    this->tile_tracker.begin_update(*this, this->compute_parameters_hash());
+
+  this->runtime_info.ntiles = 0;
+
+  // data saved along with the project
+  NodeDataStore &store = HSD_CTX.node_data_store;
+  const bool     use_store = this->output_hash && !store.get_dir().empty() &&
+                         NodeDataStore::is_storable(*this);
+
+  if (use_store && store.restore(this->output_hash, *this))
+  {
+    Logger::log()->trace("BaseNode::compute: node [{}]/[{}] restored from the project "
+                         "data",
+                         this->get_node_type(),
+                         this->get_id());
+  }
+  else if (use_cache && cache.restore(this->output_hash, *this))
+  {
+    Logger::log()->trace("BaseNode::compute: cache hit for node [{}]/[{}]",
+                         this->get_node_type(),
+                         this->get_id());
+  }
+  else
+  {
+    this->ntiles_computed = 0;
+    this->compute_failed = false;
+    this->compute_fct(*this);
+
+    // tiles counted by the TileSpan of the node, all the tiles to compute otherwise
+    this->runtime_info.ntiles = this->ntiles_computed
+                                    ? this->ntiles_computed.load()
+                                    : this->count_tiles_to_compute();
+
+#ifdef HESIOD_DEBUG_CHECKS
+    // the outputs of the full recompute are kept
+    if (this->tile_tracker.is_partial_update() && !this->is_cancelled() &&
+        !this->compute_failed)
+      this->check_partial_update();
+#endif
+
+    if (use_cache && !this->is_cancelled() && !this->compute_failed)
+      cache.store(this->output_hash, *this);
+  }
+
+  if (this->is_cancelled() || this->compute_failed)
+  {
+    // partially written outputs, neither readable nor identifiable until the node is
+    // computed again
+    this->is_data_valid = false;
+    this->output_hash = 0;
+    this->tile_tracker.reset();
+  }
+  else
+  {
+    this->is_data_valid = true;
+
+    // fingerprint the output tiles for the downstream nodes
+    if (model_settings.enable_tile_update)
+      this->tile_tracker.end_update(*this, true);
+    else
+      this->tile_tracker.reset();
+  }
+
+  // previews are rebuilt on demand, only for the ports actually displayed
+  {
+    std::lock_guard<std::mutex> lock(this->preview_pyramids_mutex);
+    this->preview_pyramids.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->region_caches_mutex);
+    this->region_caches.clear();
+  }
+
+  data_lock.unlock();
 
   this->update_runtime_info(NodeRuntimeStep::NRS_UPDATE_END);
 
@@ -108,7 +448,9 @@ std::string BaseNode::get_category() const { return this->category; }
 
 std::shared_ptr<const GraphConfig> BaseNode::get_config_ref() const
 {
-  auto ptr = config.lock();
+  std::unique_lock<std::mutex> lock(this->config_mutex);
+  auto                         ptr = this->config.lock();
+  lock.unlock();
 
   if (!ptr)
   {
@@ -309,6 +651,58 @@ std::string BaseNode::get_documentation_short_html() const
 
 std::string BaseNode::get_id() const { return gnode::Node::get_id(); }
 
+uint64_t BaseNode::get_output_hash() const { return this->output_hash; }
+
+const TileHashes *BaseNode::get_output_tile_hashes(int port_index) const
+{
+  return this->tile_tracker.get_output_tile_hashes(port_index);
+}
+
+std::shared_ptr<const PreviewPyramid> BaseNode::get_preview_pyramid(int port_index)
+{
+  if (port_index < 0 || port_index >= this->get_nports() ||
+      this->get_data_type(port_index) != typeid(hmap::VirtualArray).name())
+    return nullptr;
+
+  if (this->get_port_type(port_index) == gngui::PortType::IN &&
+      this->get_upstream_preview_pyramid)
+  {
+    if (auto sp_pyramid = this->get_upstream_preview_pyramid(port_index))
+      return sp_pyramid;
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lock(this->preview_pyramids_mutex);
+
+    auto it = this->preview_pyramids.find(port_index);
+    if (it != this->preview_pyramids.end())
+      return it->second;
+  }
+
+  // not built yet (or input without upstream node), the data cannot be read while it
+  // is being computed
+  auto data_lock = this->try_lock_data(port_index);
+  if (!data_lock.owns_lock())
+    return nullptr;
+
+  hmap::VirtualArray *p_array = this->get_value_ref<hmap::VirtualArray>(port_index);
+  if (!p_array)
+    return nullptr;
+
+  auto sp_pyramid = PreviewPyramid::build(*p_array,
+                                          this->cfg().tile_shape,
+                                          this->cfg().cm_cpu);
+
+  if (this->get_port_type(port_index) == gngui::PortType::OUT)
+  {
+    // keep the one built meanwhile by another thread, if any
+    std::lock_guard<std::mutex> lock(this->preview_pyramids_mutex);
+    this->preview_pyramids.try_emplace(port_index, sp_pyramid);
+  }
+
+  return sp_pyramid;
+}
+
 float BaseNode::get_memory_usage() const
 {
   // only count big float arrays
@@ -365,6 +759,8 @@ std::string BaseNode::get_node_type() const { return this->get_label(); }
 
 NodeRuntimeInfo BaseNode::get_runtime_info() const { return this->runtime_info; }
 
+TileDependency BaseNode::get_tile_dependency() const { return this->tile_dependency; }
+
 std::shared_ptr<BaseNode> BaseNode::get_shared()
 {
   try
@@ -378,6 +774,16 @@ std::shared_ptr<BaseNode> BaseNode::get_shared()
   }
 }
 
+bool BaseNode::is_cancelled() const
+{
+  return this->p_cancel_flag && this->p_cancel_flag->load(std::memory_order_relaxed);
+}
+
+bool BaseNode::is_tile_dirty(const hmap::TileRegion &region) const
+{
+  return this->tile_tracker.is_tile_dirty(region);
+}
+
 void BaseNode::json_from(nlohmann::json const &json)
 {
   try
@@ -490,6 +896,37 @@ void BaseNode::propagate_config_change()
                        this->get_caption(),
                        this->get_id());
 
+  std::unique_lock<std::shared_mutex> data_lock(this->data_mutex);
+  this->reallocate_outputs();
+}
+
+bool BaseNode::query_probe(int port_index, RegionProbe &probe)
+{
+  // the tiles are not read while the graph is evaluated, and the evaluation is not
+  // cancelled for a probe: the caller tries again later
+  std::unique_lock<std::recursive_mutex> graph_lock;
+
+  if (this->try_suspend_async_update && !this->try_suspend_async_update(graph_lock))
+    return false;
+
+  auto                data_lock = this->try_lock_data(port_index);
+  hmap::VirtualArray *p_array = get_heightmap_ref(*this, port_index);
+
+  if (!data_lock.owns_lock() || !p_array)
+    return false;
+
+  std::lock_guard<std::mutex> cache_lock(this->region_caches_mutex);
+
+  hesiod::query_probe(*p_array,
+                      probe,
+                      this->cfg().tile_shape,
+                      this->cfg().cm_cpu,
+                      &this->region_caches[port_index]);
+  return true;
+}
+
+void BaseNode::reallocate_outputs()
+{
   const GraphConfig &cfg = *this->get_config_ref();
 
   // go through the data and modify is needed (only outputs hold data)
@@ -527,6 +964,15 @@ void BaseNode::propagate_config_change()
         }
       }
     }
+
+  // the outputs are reset, they can no longer be identified
+  this->output_hash = 0;
+  this->tile_tracker.reset();
+
+  std::lock_guard<std::mutex> lock(this->preview_pyramids_mutex);
+  this->preview_pyramids.clear();
+  std::lock_guard<std::mutex> cache_lock(this->region_caches_mutex);
+  this->region_caches.clear();
 }
 
 void BaseNode::reseed(bool backward)
@@ -544,6 +990,43 @@ void BaseNode::reseed(bool backward)
       }
 }
 
+void BaseNode::restore_outputs()
+{
+  if (!this->outputs_backup)
+    return;
+
+  Logger::log()->trace("BaseNode::restore_outputs: node {}/{}",
+                       this->get_caption(),
+                       this->get_id());
+
+  const GraphConfig &cfg = *this->get_config_ref();
+
+  std::unique_lock<std::shared_mutex> data_lock(this->data_mutex);
+
+  for (auto &[k, sp_v] : this->outputs_backup->textures)
+    if (auto *p_v = this->get_value_ref<hmap::VirtualTexture>(k))
+      p_v->copy_from(*sp_v, cfg.cm_cpu);
+
+  for (auto &[k, array] : this->outputs_backup->arrays)
+    if (auto *p_v = this->get_value_ref<hmap::Array>(k))
+      *p_v = std::move(array);
+
+  for (auto &[k, sp_v] : this->outputs_backup->heightmaps)
+    if (auto *p_v = this->get_value_ref<hmap::VirtualArray>(k))
+      p_v->copy_from(*sp_v, cfg.cm_cpu);
+
+  this->output_hash = this->outputs_backup->output_hash;
+  this->tile_tracker = std::move(this->outputs_backup->tile_tracker);
+  this->outputs_backup.reset();
+  this->is_data_valid = true;
+
+  // rebuilt on demand
+  std::lock_guard<std::mutex> lock(this->preview_pyramids_mutex);
+  this->preview_pyramids.clear();
+  std::lock_guard<std::mutex> cache_lock(this->region_caches_mutex);
+  this->region_caches.clear();
+}
+
 void BaseNode::set_attr_ordered_key(const std::vector<std::string> &new_attr_ordered_key)
 {
   this->attr_ordered_key = new_attr_ordered_key;
@@ -554,13 +1037,72 @@ void BaseNode::set_comment(const std::string &new_comment)
   this->comment = new_comment;
 }
 
+void BaseNode::set_cancel_flag(const std::atomic<bool> *new_p_cancel_flag)
+{
+  this->p_cancel_flag = new_p_cancel_flag;
+}
+
+void BaseNode::set_compute_failed() { this->compute_failed = true; }
+
 void BaseNode::set_compute_fct(std::function<void(BaseNode &node)> new_compute_fct)
 {
   this->compute_fct = std::move(new_compute_fct);
 }
 
+void BaseNode::set_config_ref(std::weak_ptr<GraphConfig> new_config, bool deferred)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->config_mutex);
+
+    if (deferred)
+    {
+      this->pending_config = new_config;
+      return;
+    }
+
+    this->config = new_config;
+    this->pending_config.reset();
+  }
+
+  this->propagate_config_change();
+}
+
 void BaseNode::set_id(const std::string &new_id) { gnode::Node::set_id(new_id); }
 
+void BaseNode::set_tile_dependency(TileDependency new_tile_dependency)
+{
+  this->tile_dependency = new_tile_dependency;
+}
+
+bool BaseNode::swap_pending_config()
+{
+  std::lock_guard<std::mutex> lock(this->config_mutex);
+
+  if (this->pending_config.expired())
+    return false;
+
+  this->config = std::move(this->pending_config);
+  this->pending_config.reset();
+  return true;
+}
+
+std::shared_lock<std::shared_mutex> BaseNode::try_lock_data(int port_index) const
+{
+  if (port_index < 0 || port_index >= this->get_nports())
+    return {};
+
+  if (this->get_port_type(port_index) == gngui::PortType::IN)
+    return this->try_lock_upstream_data ? this->try_lock_upstream_data(port_index)
+                                        : std::shared_lock<std::shared_mutex>();
+
+  std::shared_lock<std::shared_mutex> lock(this->data_mutex, std::try_to_lock);
+
+  if (lock.owns_lock() && !this->is_data_valid)
+    return {};
+
+  return lock;
+}
+
 void BaseNode::update_attributes_tool_tip()
 {
   Logger::log()->trace("BaseNode::update_attributes_tool_tip");
@@ -613,6 +1155,12 @@ void BaseNode::update_runtime_info(NodeRuntimeStep step)
   case NodeRuntimeStep::NRS_UPDATE_START:
   {
     this->runtime_info.timer_t0 = std::chrono::steady_clock::now();
+    this->runtime_info.rss0 = get_process_rss();
+    this->runtime_info.peak_rss0 = get_process_peak_rss();
+    this->runtime_info.cpu0 = get_thread_cpu_time();
+    this->tiles_cpu_time = 0;
+    this->compute_thread = std::this_thread::get_id();
+    Profiler::take_post_process_time(); // reset
   }
   break;
 
@@ -628,6 +1176,44 @@ void BaseNode::update_runtime_info(NodeRuntimeStep step)
                            t1 - this->runtime_info.timer_t0)
                            .count() *
                        1e-6f;
+
+    // profile
+    const float mb = 1024.f * 1024.f;
+    // node thread and tiles computed by the other threads (see TileSpan)
+    const float cpu_time = 1e-6f * float(get_thread_cpu_time() - this->runtime_info.cpu0 +
+                                         this->tiles_cpu_time); // ms
+
+    this->runtime_info.post_process_time = 1e-3f *
+                                           float(Profiler::take_post_process_time());
+    this->runtime_info.rss_delta = (float(get_process_rss()) -
+                                    float(this->runtime_info.rss0)) /
+                                   mb;
+    this->runtime_info.peak_rss_delta = (float(get_process_peak_rss()) -
+                                         float(this->runtime_info.peak_rss0)) /
+                                        mb;
+    this->runtime_info.cpu_utilization = this->runtime_info.update_time > 0.f
+                                             ? cpu_time / this->runtime_info.update_time
+                                             : 0.f;
+
+    if (HSD_CTX.app_settings.model.enable_profiling)
+    {
+      Profiler              &profiler = HSD_CTX.profiler;
+      const NodeRuntimeInfo &info = this->runtime_info;
+
+      ProfileRecord record;
+      record.node_id = this->get_id();
+      record.node_type = this->get_node_type();
+      record.t_start = profiler.get_time(info.timer_t0);
+      record.duration = profiler.get_time(t1) - record.t_start;
+      record.post_process_duration = int64_t(1e3f * info.post_process_time);
+      record.ntiles = info.ntiles;
+      record.rss_delta = int64_t(info.rss_delta * mb);
+      record.peak_rss_delta = int64_t(info.peak_rss_delta * mb);
+      record.cpu_utilization = info.cpu_utilization;
+      record.thread_id = Profiler::get_thread_index();
+
+      profiler.add_record(record);
+    }
   }
   break;
 
@@ -0,0 +1,222 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <format>
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/import_cache.hpp"
+
+namespace hesiod
+{
+
+void ImportCache::clear()
+{
+  Logger::log()->trace("ImportCache::clear");
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->entries.clear();
+  this->lru.clear();
+  this->memory_usage = 0;
+}
+
+void ImportCache::evict()
+{
+  // always keep the most recent entry, even beyond the budget
+  while (this->memory_usage > this->budget && this->lru.size() > 1)
+  {
+    const std::string key = this->lru.back();
+    auto              it = this->entries.find(key);
+
+    Logger::log()->trace("ImportCache::evict: {}", key);
+
+    this->memory_usage -= it->second.bytes;
+    this->entries.erase(it);
+    this->lru.pop_back();
+  }
+}
+
+ImportCache::Entry *ImportCache::find(const std::string &key)
+{
+  auto it = this->entries.find(key);
+
+  if (it == this->entries.end())
+  {
+    this->nmisses++;
+    return nullptr;
+  }
+
+  this->nhits++;
+  this->lru.splice(this->lru.begin(), this->lru, it->second.lru_it);
+  return &it->second;
+}
+
+std::shared_ptr<const hmap::Array> ImportCache::get_array(
+    const std::filesystem::path &fname,
+    bool                         flip_y)
+{
+  const std::string key = this->get_key(fname, flip_y, "array");
+
+  if (key.empty())
+    return nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (Entry *p_entry = this->find(key))
+      return p_entry->array;
+  }
+
+  // decode outside of the lock, concurrent misses on the same file only waste work
+  Logger::log()->trace("ImportCache::get_array: decoding {}", fname.string());
+
+  auto array = std::make_shared<const hmap::Array>(fname.string(), flip_y);
+
+  Entry entry;
+  entry.array = array;
+  entry.bytes = array->vector.size() * sizeof(float);
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->insert(key, std::move(entry));
+
+  return array;
+}
+
+size_t ImportCache::get_budget() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->budget;
+}
+
+std::string ImportCache::get_key(const std::filesystem::path &fname,
+                                 bool                         flip_y,
+                                 const std::string           &kind) const
+{
+  std::error_code ec;
+  auto            mtime = std::filesystem::last_write_time(fname, ec);
+
+  if (ec)
+    return "";
+
+  return std::format("{}/{}/{}/{}",
+                     kind,
+                     flip_y ? 1 : 0,
+                     mtime.time_since_epoch().count(),
+                     std::filesystem::absolute(fname, ec).string());
+}
+
+size_t ImportCache::get_memory_usage() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->memory_usage;
+}
+
+size_t ImportCache::get_nhits() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->nhits;
+}
+
+size_t ImportCache::get_nmisses() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->nmisses;
+}
+
+std::shared_ptr<const RasterSource> ImportCache::get_raster(
+    const std::filesystem::path &fname,
+    bool                         flip_y)
+{
+  const std::string key = this->get_key(fname, flip_y, "raster");
+
+  if (key.empty())
+    return nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (Entry *p_entry = this->find(key))
+      return p_entry->raster;
+  }
+
+  Entry entry;
+
+  if (auto sp_mapped = MappedTiffSource::open(fname, flip_y))
+  {
+    // pages are loaded (and released) by the system on demand, the whole mapping is
+    // accounted for since the pages read remain resident until the entry is evicted
+    entry.raster = sp_mapped;
+    entry.bytes = sp_mapped->get_mapped_size();
+  }
+  else
+  {
+    Logger::log()->trace("ImportCache::get_raster: decoding {}", fname.string());
+
+    auto array = std::make_shared<const hmap::Array>(fname.string(), flip_y);
+
+    entry.raster = std::make_shared<const ArrayRasterSource>(array);
+    entry.bytes = array->vector.size() * sizeof(float);
+  }
+
+  std::shared_ptr<const RasterSource> raster = entry.raster;
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->insert(key, std::move(entry));
+
+  return raster;
+}
+
+std::shared_ptr<const hmap::Tensor> ImportCache::get_tensor(
+    const std::filesystem::path &fname,
+    bool                         flip_y)
+{
+  const std::string key = this->get_key(fname, flip_y, "tensor");
+
+  if (key.empty())
+    return nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (Entry *p_entry = this->find(key))
+      return p_entry->tensor;
+  }
+
+  Logger::log()->trace("ImportCache::get_tensor: decoding {}", fname.string());
+
+  auto tensor = std::make_shared<const hmap::Tensor>(fname.string(), flip_y);
+
+  Entry entry;
+  entry.tensor = tensor;
+  entry.bytes = tensor->vector.size() * sizeof(float);
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->insert(key, std::move(entry));
+
+  return tensor;
+}
+
+void ImportCache::insert(const std::string &key, Entry &&entry)
+{
+  // another thread decoded the same file meanwhile
+  if (this->entries.contains(key))
+    return;
+
+  this->lru.push_front(key);
+  entry.lru_it = this->lru.begin();
+
+  this->memory_usage += entry.bytes;
+  this->entries[key] = std::move(entry);
+
+  this->evict();
+}
+
+void ImportCache::set_budget(size_t new_budget_bytes)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->budget = new_budget_bytes;
+  this->evict();
+}
+
+} // namespace hesiod
@@ -0,0 +1,672 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <fstream>
+
+#include <zlib.h>
+
+#include <QFile>
+
+#include "highmap/geometry/cloud.hpp"
+#include "highmap/geometry/path.hpp"
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/graph/graph_manager.hpp"
+#include "hesiod/model/graph/graph_node.hpp"
+#include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/nodes/node_data_store.hpp"
+#include "hesiod/model/project_model.hpp"
+#include "hesiod/model/streaming_export.hpp"
+
+namespace hesiod
+{
+
+// file layout (host byte order, a file written with another byte order is rejected by
+// the version check): magic, version, key, number of outputs, then for each output its
+// type followed by:
+// - heightmap/texture: shape, chunk shape, number of channels, chunk table (offset and
+//   size of each chunk, channel-major, chunks along x first), then the chunks. A chunk
+//   holds float32 values indexed as (i * chunk_shape.y + j) and is deflate-compressed
+//   when its size is smaller than the raw size,
+// - cloud/path: closed flag, number of points, then the x, y and v arrays.
+static constexpr char     STORE_MAGIC[4] = {'H', 'S', 'D', 'N'};
+static constexpr uint32_t STORE_FORMAT_VERSION = 1;
+
+enum class StoredType : uint32_t
+{
+  NONE,
+  HEIGHTMAP,
+  TEXTURE,
+  CLOUD,
+  PATH
+};
+
+struct ChunkEntry
+{
+  uint64_t offset = 0;
+  uint64_t size = 0;
+};
+
+// --- helpers
+
+static StoredType get_stored_type(const BaseNode &node, int port_index)
+{
+  const std::string type = node.get_data_type(port_index);
+
+  if (type == typeid(hmap::VirtualArray).name())
+    return StoredType::HEIGHTMAP;
+  else if (type == typeid(hmap::VirtualTexture).name())
+    return StoredType::TEXTURE;
+  else if (type == typeid(hmap::Cloud).name())
+    return StoredType::CLOUD;
+  else if (type == typeid(hmap::Path).name())
+    return StoredType::PATH;
+
+  return StoredType::NONE;
+}
+
+static std::vector<hmap::VirtualArray *> get_channels(BaseNode  &node,
+                                                      int        port_index,
+                                                      StoredType type)
+{
+  if (type == StoredType::HEIGHTMAP)
+    return {node.get_value_ref<hmap::VirtualArray>(port_index)};
+
+  std::vector<hmap::VirtualArray *> channels;
+  auto *p_texture = node.get_value_ref<hmap::VirtualTexture>(port_index);
+
+  for (int nch = 0; nch < 4; ++nch)
+    channels.push_back(&p_texture->channel(nch));
+
+  return channels;
+}
+
+static std::vector<ExportBlock> get_chunks(const glm::ivec2 &shape,
+                                           const glm::ivec2 &chunk_shape)
+{
+  std::vector<ExportBlock> chunks;
+
+  for (int i = 0; i < shape.x; i += chunk_shape.x)
+    for (int j = 0; j < shape.y; j += chunk_shape.y)
+      chunks.push_back({{i, j}, glm::min(chunk_shape, shape - glm::ivec2(i, j))});
+
+  return chunks;
+}
+
+template <typename T> static void write_value(std::ofstream &file, const T &value)
+{
+  file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static void write_vector(std::ofstream &file, const std::vector<T> &v)
+{
+  file.write(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+}
+
+static bool write_grid(std::ofstream                           &file,
+                       const std::vector<hmap::VirtualArray *> &channels,
+                       const glm::ivec2                        &tile_shape,
+                       bool                                     compress,
+                       const hmap::ComputeMode                 &cm)
+{
+  const glm::ivec2               shape = channels.front()->shape;
+  const std::vector<ExportBlock> chunks = get_chunks(shape, tile_shape);
+  const size_t                   nchannels = channels.size();
+
+  write_value(file, int32_t(shape.x));
+  write_value(file, int32_t(shape.y));
+  write_value(file, int32_t(tile_shape.x));
+  write_value(file, int32_t(tile_shape.y));
+  write_value(file, uint32_t(nchannels));
+
+  // placeholder, the table is filled once the chunks are written
+  std::vector<ChunkEntry> table(nchannels * chunks.size());
+  const std::streampos    table_pos = file.tellp();
+
+  write_vector(file, table);
+
+  // chunks are encoded concurrently and appended in completion order
+  ParallelTileWriter writer;
+  std::mutex         mutex;
+  uint64_t           offset = static_cast<uint64_t>(file.tellp());
+
+  auto write_chunk = [&](size_t k, std::vector<hmap::Array> &block)
+  {
+    auto sp_block = std::make_shared<std::vector<hmap::Array>>(std::move(block));
+
+    writer.submit(
+        [&, k, sp_block]()
+        {
+          for (size_t nch = 0; nch < nchannels; ++nch)
+          {
+            const hmap::Array &array = (*sp_block)[nch];
+            std::vector<float> values(array.vector.size());
+
+            for (int i = 0; i < array.shape.x; ++i)
+              for (int j = 0; j < array.shape.y; ++j)
+                values[size_t(i) * array.shape.y + j] = array(i, j);
+
+            const Bytef *p_src = reinterpret_cast<const Bytef *>(values.data());
+            const uLong  src_size = static_cast<uLong>(values.size() * sizeof(float));
+
+            std::vector<Bytef> bytes(p_src, p_src + src_size);
+
+            if (compress)
+            {
+              uLongf             size = compressBound(src_size);
+              std::vector<Bytef> deflated(size);
+
+              if (compress2(deflated.data(), &size, p_src, src_size, 6) == Z_OK &&
+                  size < src_size)
+              {
+                deflated.resize(size);
+                bytes = std::move(deflated);
+              }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            table[nch * chunks.size() + k] = {offset, bytes.size()};
+            file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+            offset += bytes.size();
+
+            if (!file)
+              return false;
+          }
+          return true;
+        });
+
+    return true;
+  };
+
+  bool ok = stream_export_blocks(channels, tile_shape, chunks, write_chunk, cm);
+  ok = writer.wait() && ok;
+
+  file.seekp(table_pos);
+  write_vector(file, table);
+  file.seekp(0, std::ios::end);
+
+  return ok && file.good();
+}
+
+template <typename T> static void write_points(std::ofstream &file, const T &points)
+{
+  const std::vector<float> x = points.get_x();
+  const std::vector<float> y = points.get_y();
+  const std::vector<float> v = points.get_values();
+
+  write_value(file, uint64_t(x.size()));
+  write_vector(file, x);
+  write_vector(file, y);
+  write_vector(file, v);
+}
+
+// bounds-checked sequential reads from the mapped file
+struct MappedReader
+{
+  const uchar *p_data = nullptr;
+  size_t       size = 0;
+  size_t       pos = 0;
+  bool         ok = true;
+
+  template <typename T> T get()
+  {
+    T value{};
+    if (this->pos + sizeof(T) > this->size)
+    {
+      this->ok = false;
+      return value;
+    }
+
+    std::memcpy(&value, this->p_data + this->pos, sizeof(T));
+    this->pos += sizeof(T);
+    return value;
+  }
+
+  template <typename T> std::vector<T> get_vector(size_t n)
+  {
+    std::vector<T> v;
+    if (n > (this->size - this->pos) / sizeof(T))
+    {
+      this->ok = false;
+      return v;
+    }
+
+    v.resize(n);
+    std::memcpy(v.data(), this->p_data + this->pos, n * sizeof(T));
+    this->pos += n * sizeof(T);
+    return v;
+  }
+};
+
+static bool decode_chunk(const MappedReader &reader,
+                         const ChunkEntry   &entry,
+                         std::vector<float> &values) // sized to the chunk
+{
+  const size_t raw_size = values.size() * sizeof(float);
+
+  if (entry.offset + entry.size > reader.size)
+    return false;
+
+  const uchar *p_src = reader.p_data + entry.offset;
+
+  if (entry.size == raw_size)
+  {
+    std::memcpy(values.data(), p_src, raw_size);
+    return true;
+  }
+
+  uLongf size = static_cast<uLongf>(raw_size);
+  return uncompress(reinterpret_cast<Bytef *>(values.data()),
+                    &size,
+                    p_src,
+                    static_cast<uLong>(entry.size)) == Z_OK &&
+         size == raw_size;
+}
+
+static bool read_grid(MappedReader                            &reader,
+                      const std::vector<hmap::VirtualArray *> &channels,
+                      const hmap::ComputeMode                 &cm)
+{
+  const glm::ivec2 shape = channels.front()->shape;
+
+  glm::ivec2 stored_shape;
+  glm::ivec2 chunk_shape;
+
+  stored_shape.x = reader.get<int32_t>();
+  stored_shape.y = reader.get<int32_t>();
+  chunk_shape.x = reader.get<int32_t>();
+  chunk_shape.y = reader.get<int32_t>();
+
+  const uint32_t nchannels = reader.get<uint32_t>();
+
+  if (!reader.ok || stored_shape != shape || nchannels != channels.size() ||
+      chunk_shape.x <= 0 || chunk_shape.y <= 0)
+    return false;
+
+  const std::vector<ExportBlock> chunks = get_chunks(shape, chunk_shape);
+  const std::vector<ChunkEntry>  table = reader.get_vector<ChunkEntry>(nchannels *
+                                                                      chunks.size());
+  if (!reader.ok)
+    return false;
+
+  const int         ncy = (shape.y + chunk_shape.y - 1) / chunk_shape.y;
+  std::atomic<bool> ok = true;
+
+  // tile by tile, only the overlapping chunks are decoded (and paged in)
+  hmap::ComputeMode cm_fill = cm;
+  cm_fill.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+
+  hmap::for_each_tile(
+      channels,
+      [&](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
+      {
+        const glm::ivec2 tile_shape = p_arrays[0]->shape;
+        const glm::ivec2 ij0 = {int(std::lround(region.bbox.x * float(shape.x))),
+                                int(std::lround(region.bbox.z * float(shape.y)))};
+
+        const glm::ivec2 a = glm::clamp(ij0, glm::ivec2(0), shape - 1);
+        const glm::ivec2 b = glm::clamp(ij0 + tile_shape - 1, glm::ivec2(0), shape - 1);
+        const glm::ivec2 c0 = a / chunk_shape;
+        const glm::ivec2 c1 = b / chunk_shape;
+
+        for (int ci = c0.x; ci <= c1.x; ++ci)
+          for (int cj = c0.y; cj <= c1.y; ++cj)
+          {
+            const size_t       k = size_t(ci) * ncy + cj;
+            const ExportBlock &chunk = chunks[k];
+            std::vector<float> values(size_t(chunk.shape.x) * chunk.shape.y);
+
+            for (size_t nch = 0; nch < nchannels; ++nch)
+            {
+              if (!decode_chunk(reader, table[nch * chunks.size() + k], values))
+              {
+                ok = false;
+                return;
+              }
+
+              // tile elements falling in this chunk, the halo being clamped to the
+              // domain
+              for (int i = 0; i < tile_shape.x; ++i)
+              {
+                const int gi = std::clamp(ij0.x + i, 0, shape.x - 1) - chunk.ij0.x;
+                if (gi < 0 || gi >= chunk.shape.x)
+                  continue;
+
+                for (int j = 0; j < tile_shape.y; ++j)
+                {
+                  const int gj = std::clamp(ij0.y + j, 0, shape.y - 1) - chunk.ij0.y;
+                  if (gj >= 0 && gj < chunk.shape.y)
+                    (*p_arrays[nch])(i, j) = values[size_t(gi) * chunk.shape.y + gj];
+                }
+              }
+            }
+          }
+      },
+      cm_fill);
+
+  return ok;
+}
+
+// --- NodeDataStore
+
+void NodeDataStore::attach(const std::filesystem::path &project_fname)
+{
+  Logger::log()->trace("NodeDataStore::attach: {}", project_fname.string());
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->dir = project_fname.empty() ? std::filesystem::path()
+                                    : NodeDataStore::get_dir(project_fname);
+  this->nrestored = 0;
+}
+
+std::filesystem::path NodeDataStore::get_dir() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->dir;
+}
+
+std::filesystem::path NodeDataStore::get_dir(const std::filesystem::path &project_fname)
+{
+  std::filesystem::path path = project_fname;
+  path += ".data";
+  return path;
+}
+
+std::filesystem::path NodeDataStore::get_entry_path(uint64_t key) const
+{
+  std::filesystem::path dir = this->get_dir();
+  if (dir.empty())
+    return {};
+
+  return dir / std::format("{:016x}.hsn", key);
+}
+
+size_t NodeDataStore::get_nrestored() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->nrestored;
+}
+
+bool NodeDataStore::is_storable(const BaseNode &node)
+{
+  int nouts = 0;
+
+  for (int k = 0; k < node.get_nports(); k++)
+  {
+    if (node.get_port_type(k) == gngui::PortType::IN)
+      continue;
+
+    if (get_stored_type(node, k) == StoredType::NONE)
+      return false;
+
+    nouts++;
+  }
+
+  return nouts > 0;
+}
+
+bool NodeDataStore::read_file(const std::filesystem::path &path,
+                              uint64_t                     key,
+                              BaseNode                    &node)
+{
+  QFile file(QString::fromStdString(path.string()));
+
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  // the mapping is released when the file is closed
+  MappedReader reader;
+  reader.size = static_cast<size_t>(file.size());
+  reader.p_data = file.map(0, file.size());
+
+  if (!reader.p_data)
+  {
+    Logger::log()->warn("NodeDataStore::read_file: could not map {}", path.string());
+    return false;
+  }
+
+  char magic[4];
+  for (char &c : magic)
+    c = reader.get<char>();
+
+  const uint32_t version = reader.get<uint32_t>();
+  const uint64_t stored_key = reader.get<uint64_t>();
+  const uint32_t nouts = reader.get<uint32_t>();
+
+  uint32_t n = 0;
+  bool     ok = reader.ok && std::equal(magic, magic + 4, STORE_MAGIC) &&
+            version == STORE_FORMAT_VERSION && stored_key == key;
+
+  for (int k = 0; ok && k < node.get_nports(); k++)
+  {
+    if (node.get_port_type(k) == gngui::PortType::IN)
+      continue;
+
+    const StoredType type = get_stored_type(node, k);
+
+    if (n++ >= nouts || reader.get<uint32_t>() != static_cast<uint32_t>(type))
+    {
+      ok = false;
+      break;
+    }
+
+    switch (type)
+    {
+    case StoredType::HEIGHTMAP:
+    case StoredType::TEXTURE:
+      ok = read_grid(reader, get_channels(node, k, type), node.cfg().cm_cpu);
+      break;
+
+    case StoredType::CLOUD:
+    case StoredType::PATH:
+    {
+      const bool     closed = reader.get<uint32_t>() != 0;
+      const uint64_t npoints = reader.get<uint64_t>();
+
+      std::vector<float> x = reader.get_vector<float>(npoints);
+      std::vector<float> y = reader.get_vector<float>(npoints);
+      std::vector<float> v = reader.get_vector<float>(npoints);
+
+      if (!reader.ok)
+        ok = false;
+      else if (type == StoredType::CLOUD)
+        *node.get_value_ref<hmap::Cloud>(k) = hmap::Cloud(x, y, v);
+      else
+      {
+        auto *p_path = node.get_value_ref<hmap::Path>(k);
+        *p_path = hmap::Path(x, y, v);
+        p_path->set_closed(closed);
+      }
+      break;
+    }
+
+    default:
+      ok = false;
+    }
+  }
+
+  return ok && n == nouts;
+}
+
+bool NodeDataStore::restore(uint64_t key, BaseNode &node)
+{
+  const std::filesystem::path path = this->get_entry_path(key);
+  std::error_code             ec;
+
+  if (path.empty() || !std::filesystem::exists(path, ec))
+    return false;
+
+  if (!NodeDataStore::read_file(path, key, node))
+  {
+    Logger::log()->warn("NodeDataStore::restore: invalid or outdated entry {}",
+                        path.string());
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->nrestored++;
+
+  return true;
+}
+
+bool NodeDataStore::save(uint64_t key, BaseNode &node, bool compress)
+{
+  const std::filesystem::path path = this->get_entry_path(key);
+  std::error_code             ec;
+
+  // content-addressed, an existing entry is up to date
+  if (path.empty() || std::filesystem::exists(path, ec))
+    return !path.empty();
+
+  Logger::log()->trace("NodeDataStore::save: node [{}]/[{}] -> {}",
+                       node.get_node_type(),
+                       node.get_id(),
+                       path.string());
+
+  std::filesystem::create_directories(path.parent_path(), ec);
+
+  std::filesystem::path tmp_path = path;
+  tmp_path += ".tmp";
+
+  const bool ok = NodeDataStore::write_file(tmp_path, key, node, compress);
+
+  if (ok)
+    std::filesystem::rename(tmp_path, path, ec);
+
+  if (!ok || ec)
+  {
+    Logger::log()->error("NodeDataStore::save: could not write {}", path.string());
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+
+  return true;
+}
+
+void NodeDataStore::save_project(ProjectModel &project, bool compress)
+{
+  const std::filesystem::path dir = this->get_dir();
+
+  if (dir.empty())
+    return;
+
+  Logger::log()->trace("NodeDataStore::save_project: {}", dir.string());
+
+  std::set<std::string> fnames; // entries still in use
+  size_t                nsaved = 0;
+
+  for (auto &[graph_id, p_graph] : project.get_graph_manager_ref()->get_graph_nodes())
+  {
+    // no background evaluation while the outputs are read
+    auto lock = p_graph->suspend_async_update();
+
+    for (auto &[node_id, p_node] : p_graph->get_nodes())
+    {
+      BaseNode *p_basenode = dynamic_cast<BaseNode *>(p_node.get());
+
+      // nodes never computed, with a cancelled compute, or with outputs not identified
+      // by a hash (export, broadcast...)
+      if (!p_basenode || !p_basenode->get_output_hash() || p_basenode->is_cancelled() ||
+          !NodeDataStore::is_storable(*p_basenode))
+        continue;
+
+      const uint64_t key = p_basenode->get_output_hash();
+
+      // outputs not up to date, parameters or inputs changed since the compute
+      if (p_basenode->compute_hash() != key)
+        continue;
+
+      if (this->save(key, *p_basenode, compress))
+      {
+        fnames.insert(this->get_entry_path(key).filename().string());
+        nsaved++;
+      }
+    }
+  }
+
+  // stale entries
+  std::error_code ec;
+
+  for (auto &entry : std::filesystem::directory_iterator(dir, ec))
+    if (entry.path().extension() == ".hsn" &&
+        !fnames.contains(entry.path().filename().string()))
+      std::filesystem::remove(entry.path(), ec);
+
+  Logger::log()->info("NodeDataStore::save_project: {} node output(s) stored in {}",
+                      nsaved,
+                      dir.string());
+}
+
+bool NodeDataStore::write_file(const std::filesystem::path &path,
+                               uint64_t                     key,
+                               BaseNode                    &node,
+                               bool                         compress)
+{
+  bool ok = true;
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open())
+  {
+    Logger::log()->error("NodeDataStore::write_file: could not write {}", path.string());
+    return false;
+  }
+
+  uint32_t nouts = 0;
+
+  for (int k = 0; k < node.get_nports(); k++)
+    if (node.get_port_type(k) == gngui::PortType::OUT)
+      nouts++;
+
+  file.write(STORE_MAGIC, 4);
+  write_value(file, STORE_FORMAT_VERSION);
+  write_value(file, key);
+  write_value(file, nouts);
+
+  for (int k = 0; ok && k < node.get_nports(); k++)
+  {
+    if (node.get_port_type(k) == gngui::PortType::IN)
+      continue;
+
+    const StoredType type = get_stored_type(node, k);
+    write_value(file, static_cast<uint32_t>(type));
+
+    switch (type)
+    {
+    case StoredType::HEIGHTMAP:
+    case StoredType::TEXTURE:
+      ok = write_grid(file,
+                      get_channels(node, k, type),
+                      node.cfg().tile_shape,
+                      compress,
+                      node.cfg().cm_cpu);
+      break;
+
+    case StoredType::CLOUD:
+      write_value(file, uint32_t(0));
+      write_points(file, *node.get_value_ref<hmap::Cloud>(k));
+      break;
+
+    case StoredType::PATH:
+    {
+      const hmap::Path &path_data = *node.get_value_ref<hmap::Path>(k);
+      write_value(file, uint32_t(path_data.closed ? 1 : 0));
+      write_points(file, path_data);
+      break;
+    }
+
+    default:
+      ok = false;
+    }
+  }
+
+  return ok && file.good();
+}
+
+} // namespace hesiod
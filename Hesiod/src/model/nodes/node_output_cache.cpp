@@ -0,0 +1,442 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <atomic>
+#include <format>
+
+#include <QCoreApplication>
+
+#include "hesiod/model/nodes/node_output_cache.hpp"
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/nodes/node_data_store.hpp"
+
+namespace hesiod
+{
+
+// on-disk entries use the NodeDataStore format (uncompressed), written and read tile
+// by tile. Temporary files are named after the process and a counter since the cache
+// directory can be shared by several processes and written by several threads
+static std::atomic<uint64_t> tmp_counter = 0;
+
+void NodeOutputCache::clear()
+{
+  Logger::log()->trace("NodeOutputCache::clear");
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->entries.clear();
+  this->lru.clear();
+  this->memory_usage = 0;
+}
+
+void NodeOutputCache::evict()
+{
+  while (this->memory_usage > this->budget && !this->lru.empty())
+  {
+    uint64_t key = this->lru.back();
+    auto     it = this->entries.find(key);
+
+    Logger::log()->trace("NodeOutputCache::evict: key {:016x}", key);
+
+    this->memory_usage -= it->second.bytes;
+    this->entries.erase(it);
+    this->lru.pop_back();
+  }
+}
+
+void NodeOutputCache::evict_disk()
+{
+  if (this->disk_usage <= this->disk_budget)
+    return;
+
+  const std::filesystem::path dir = this->get_disk_path();
+
+  // oldest access first
+  std::vector<std::pair<std::filesystem::file_time_type, uint64_t>> keys;
+
+  for (auto &[key, disk_entry] : this->disk_entries)
+    keys.push_back({disk_entry.last_access, key});
+
+  std::sort(keys.begin(), keys.end());
+
+  for (auto &[_, key] : keys)
+  {
+    if (this->disk_usage <= this->disk_budget)
+      break;
+
+    const std::filesystem::path path = dir / std::format("{:016x}.hsc", key);
+    std::error_code             ec;
+
+    // files already removed (e.g. by another process) are dropped from the index
+    // anyway
+    std::filesystem::remove(path, ec);
+    Logger::log()->trace("NodeOutputCache::evict_disk: removed {}", path.string());
+
+    this->disk_usage -= this->disk_entries.at(key).bytes;
+    this->disk_entries.erase(key);
+  }
+}
+
+size_t NodeOutputCache::get_budget() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->budget;
+}
+
+std::filesystem::path NodeOutputCache::get_disk_path() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->disk_dir;
+}
+
+std::filesystem::path NodeOutputCache::get_entry_path(uint64_t key) const
+{
+  std::filesystem::path dir = this->get_disk_path();
+  if (dir.empty())
+    return {};
+
+  return dir / std::format("{:016x}.hsc", key);
+}
+
+size_t NodeOutputCache::get_memory_usage() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->memory_usage;
+}
+
+size_t NodeOutputCache::get_ndisk_hits() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->ndisk_hits;
+}
+
+size_t NodeOutputCache::get_nentries() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->entries.size();
+}
+
+size_t NodeOutputCache::get_nhits() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->nhits;
+}
+
+size_t NodeOutputCache::get_nmisses() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->nmisses;
+}
+
+bool NodeOutputCache::is_cacheable(const BaseNode &node)
+{
+  // only heightmap outputs can be stored
+  int nouts = 0;
+
+  for (int k = 0; k < node.get_nports(); k++)
+  {
+    if (node.get_port_type(k) == gngui::PortType::IN)
+      continue;
+
+    if (node.get_data_type(k) != typeid(hmap::VirtualArray).name())
+      return false;
+
+    nouts++;
+  }
+
+  return nouts > 0;
+}
+
+bool NodeOutputCache::load_from_disk(uint64_t key, BaseNode &node)
+{
+  const std::filesystem::path path = this->get_entry_path(key);
+  std::error_code             ec;
+
+  if (path.empty())
+    return false;
+
+  std::lock_guard<std::mutex> lock(this->disk_mutex);
+
+  // entries written by other processes are not indexed, the file is checked anyway
+  if (!std::filesystem::exists(path, ec))
+  {
+    if (this->disk_entries.contains(key))
+    {
+      this->disk_usage -= this->disk_entries.at(key).bytes;
+      this->disk_entries.erase(key);
+    }
+    return false;
+  }
+
+  if (!NodeDataStore::read_file(path, key, node))
+  {
+    Logger::log()->warn("NodeOutputCache::load_from_disk: invalid entry {}, removed",
+                        path.string());
+
+    std::filesystem::remove(path, ec);
+    if (this->disk_entries.contains(key))
+    {
+      this->disk_usage -= this->disk_entries.at(key).bytes;
+      this->disk_entries.erase(key);
+    }
+    return false;
+  }
+
+  // last access time, used for the eviction
+  const auto now = std::filesystem::file_time_type::clock::now();
+  std::filesystem::last_write_time(path, now, ec);
+
+  if (!this->disk_entries.contains(key))
+  {
+    const size_t bytes = std::filesystem::file_size(path, ec);
+    this->disk_entries[key].bytes = ec ? 0 : bytes;
+    this->disk_usage += this->disk_entries[key].bytes;
+  }
+  this->disk_entries[key].last_access = now;
+
+  return true;
+}
+
+bool NodeOutputCache::restore(uint64_t key, BaseNode &node)
+{
+  std::vector<std::shared_ptr<hmap::VirtualArray>> outputs;
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    auto it = this->entries.find(key);
+
+    if (it != this->entries.end())
+    {
+      // move to front
+      this->lru.splice(this->lru.begin(), this->lru, it->second.lru_it);
+
+      outputs = it->second.outputs;
+      this->nhits++;
+    }
+  }
+
+  // fall back on the persistent storage, hits are promoted to memory
+  if (outputs.empty())
+  {
+    bool ret = this->load_from_disk(key, node);
+
+    if (ret)
+      this->store_in_memory(key, node);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (ret)
+      this->ndisk_hits++;
+    else
+      this->nmisses++;
+
+    return ret;
+  }
+
+  // copies are done outside the lock, the arrays are kept alive by the shared ptrs
+  size_t n = 0;
+
+  for (int k = 0; k < node.get_nports(); k++)
+  {
+    if (node.get_port_type(k) == gngui::PortType::IN)
+      continue;
+
+    auto *p_out = node.get_value_ref<hmap::VirtualArray>(k);
+
+    if (!p_out || n >= outputs.size())
+    {
+      Logger::log()->error("NodeOutputCache::restore: output mismatch for node {}",
+                           node.get_id());
+      return false;
+    }
+
+    p_out->copy_from(*outputs[n++], node.cfg().cm_cpu);
+  }
+
+  return true;
+}
+
+void NodeOutputCache::save_to_disk(uint64_t key, BaseNode &node)
+{
+  const std::filesystem::path path = this->get_entry_path(key);
+  std::error_code             ec;
+
+  if (path.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock(this->disk_mutex);
+
+  if (this->disk_entries.contains(key) || std::filesystem::exists(path, ec))
+    return;
+
+  // write to a temporary file first, renamed once complete
+  std::filesystem::path tmp_path = path;
+  tmp_path += std::format(".{}.{}.tmp",
+                          QCoreApplication::applicationPid(),
+                          tmp_counter++);
+
+  if (!NodeDataStore::write_file(tmp_path, key, node, false))
+  {
+    Logger::log()->error("NodeOutputCache::save_to_disk: write error {}",
+                         tmp_path.string());
+    std::filesystem::remove(tmp_path, ec);
+    return;
+  }
+
+  const size_t bytes = std::filesystem::file_size(tmp_path, ec);
+
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec)
+  {
+    std::filesystem::remove(tmp_path, ec);
+    return;
+  }
+
+  this->disk_entries[key] = {bytes, std::filesystem::file_time_type::clock::now()};
+  this->disk_usage += bytes;
+
+  this->evict_disk();
+}
+
+void NodeOutputCache::set_budget(size_t new_budget_bytes)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->budget = new_budget_bytes;
+  this->evict();
+}
+
+void NodeOutputCache::set_disk_storage(const std::filesystem::path &new_dir,
+                                       size_t                       new_budget_bytes)
+{
+  std::lock_guard<std::mutex> disk_lock(this->disk_mutex);
+
+  this->disk_budget = new_budget_bytes;
+
+  if (new_dir == this->requested_dir)
+  {
+    this->evict_disk();
+    return;
+  }
+
+  this->requested_dir = new_dir;
+
+  std::filesystem::path dir = new_dir;
+
+  // node implementations may change between versions, keep the entries apart
+  if (!dir.empty())
+  {
+    dir /= std::format("v{}.{}.{}",
+                       HESIOD_VERSION_MAJOR,
+                       HESIOD_VERSION_MINOR,
+                       HESIOD_VERSION_PATCH);
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    if (ec)
+    {
+      Logger::log()->error("NodeOutputCache::set_disk_storage: could not create {}: {}",
+                           dir.string(),
+                           ec.message());
+      dir.clear();
+    }
+  }
+
+  Logger::log()->trace("NodeOutputCache::set_disk_storage: {}", dir.string());
+
+  // index of the existing entries, kept up to date afterwards
+  this->disk_entries.clear();
+  this->disk_usage = 0;
+
+  if (!dir.empty())
+  {
+    std::error_code ec;
+
+    for (auto &entry : std::filesystem::directory_iterator(dir, ec))
+    {
+      if (!entry.is_regular_file(ec) || entry.path().extension() != ".hsc")
+        continue;
+
+      uint64_t key = 0;
+
+      try
+      {
+        key = std::stoull(entry.path().stem().string(), nullptr, 16);
+      }
+      catch (...)
+      {
+        continue;
+      }
+
+      const size_t bytes = entry.file_size(ec);
+      this->disk_entries[key] = {bytes, entry.last_write_time(ec)};
+      this->disk_usage += bytes;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->disk_dir = dir;
+  }
+
+  this->evict_disk();
+}
+
+void NodeOutputCache::store(uint64_t key, BaseNode &node)
+{
+  bool in_memory;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    in_memory = this->entries.contains(key);
+  }
+
+  if (!in_memory)
+    this->store_in_memory(key, node);
+
+  this->save_to_disk(key, node);
+}
+
+void NodeOutputCache::store_in_memory(uint64_t key, BaseNode &node)
+{
+  Entry        entry;
+  const auto  &cfg = node.cfg();
+  const size_t unit = size_t(cfg.shape.x) * size_t(cfg.shape.y) * sizeof(float);
+
+  for (int k = 0; k < node.get_nports(); k++)
+  {
+    if (node.get_port_type(k) == gngui::PortType::IN)
+      continue;
+
+    auto *p_out = node.get_value_ref<hmap::VirtualArray>(k);
+    if (!p_out)
+      return;
+
+    auto sp_copy = std::make_shared<hmap::VirtualArray>(cfg.shape,
+                                                        cfg.tile_shape,
+                                                        cfg.halo,
+                                                        cfg.storage_mode);
+    sp_copy->copy_from(*p_out, cfg.cm_cpu);
+
+    entry.outputs.push_back(sp_copy);
+    entry.bytes += unit;
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  // an entry larger than the whole budget is not stored
+  if (entry.bytes > this->budget || this->entries.contains(key))
+    return;
+
+  this->lru.push_front(key);
+  entry.lru_it = this->lru.begin();
+
+  this->memory_usage += entry.bytes;
+  this->entries[key] = std::move(entry);
+
+  this->evict();
+}
+
+} // namespace hesiod
@@ -36,14 +36,14 @@ void setup_brush_node(BaseNode &node)
 
   auto lambda = [&node, port_id]()
   {
-    hmap::VirtualArray *p_in = node.get_value_ref<hmap::VirtualArray>(port_id);
+    auto sp_pyramid = node.get_preview_pyramid(node.get_port_index(port_id));
 
-    if (!p_in)
+    if (!sp_pyramid)
       return QImage();
 
     // generate a preview of the heightmap
     glm::ivec2  shape_preview = glm::ivec2(256, 256);
-    hmap::Array array = p_in->to_array(shape_preview, node.cfg().cm_cpu);
+    hmap::Array array = sp_pyramid->get_array(shape_preview);
 
     std::vector<uint8_t> img(shape_preview.x * shape_preview.y);
 
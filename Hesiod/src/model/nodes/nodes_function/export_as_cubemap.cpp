@@ -61,7 +61,8 @@ void compute_export_as_cubemap_node(BaseNode &node)
 
   if (p_in && node.get_attr<BoolAttribute>("auto_export"))
   {
-    hmap::Array z = p_in->to_array(node.cfg().cm_cpu);
+    // the dense array is the snapshot of the input
+    auto sp_z = std::make_shared<hmap::Array>(p_in->to_array(node.cfg().cm_cpu));
 
     std::filesystem::path fname = node.get_attr<FilenameAttribute>("fname");
     fname = ensure_extension(fname, ".png");
@@ -69,14 +70,25 @@ void compute_export_as_cubemap_node(BaseNode &node)
     if (node.get_attr<BoolAttribute>("add_prefix"))
       fname = prepend_project_name_to_path(fname);
 
-    hmap::export_as_cubemap(fname.string(),
-                            z,
-                            node.get_attr<IntAttribute>("cubemap_resolution"),
-                            node.get_attr<FloatAttribute>("overlap"),
-                            node.get_attr<IntAttribute>("ir"),
-                            hmap::Cmap::GRAY,
-                            node.get_attr<BoolAttribute>("splitted"),
-                            nullptr);
+    const int   cubemap_resolution = node.get_attr<IntAttribute>("cubemap_resolution");
+    const float overlap = node.get_attr<FloatAttribute>("overlap");
+    const int   ir = node.get_attr<IntAttribute>("ir");
+    const bool  splitted = node.get_attr<BoolAttribute>("splitted");
+
+    submit_export(node,
+                  fname,
+                  [sp_z, fname, cubemap_resolution, overlap, ir, splitted]()
+                  {
+                    hmap::export_as_cubemap(fname.string(),
+                                            *sp_z,
+                                            cubemap_resolution,
+                                            overlap,
+                                            ir,
+                                            hmap::Cmap::GRAY,
+                                            splitted,
+                                            nullptr);
+                    return true;
+                  });
   }
 }
 
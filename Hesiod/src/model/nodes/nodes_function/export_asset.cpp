@@ -1,6 +1,8 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <algorithm>
+
 #include "highmap/colorize.hpp"
 #include "highmap/export.hpp"
 #include "highmap/gradient.hpp"
@@ -20,6 +22,70 @@ using namespace attr;
 namespace hesiod
 {
 
+// --- helper
+
+// base normals of a tile at the scale of the whole heightmap (central differences,
+// vertical component 2 / shape.x with 'shape' the heightmap shape), encoded to [0, 1].
+// The halo provides the neighborhood of the tile borders
+static void compute_base_normals(const hmap::Array &elev,
+                                 const glm::ivec2  &shape,
+                                 hmap::Array       &nx,
+                                 hmap::Array       &ny,
+                                 hmap::Array       &nz)
+{
+  const float dz = 2.f / float(shape.x);
+
+  for (int i = 0; i < elev.shape.x; ++i)
+    for (int j = 0; j < elev.shape.y; ++j)
+    {
+      // one-sided differences at the array borders, scaled as central ones
+      const int ip = std::min(i + 1, elev.shape.x - 1);
+      const int im = std::max(i - 1, 0);
+      const int jp = std::min(j + 1, elev.shape.y - 1);
+      const int jm = std::max(j - 1, 0);
+
+      glm::vec3 n = {ip > im ? 2.f * (elev(im, j) - elev(ip, j)) / float(ip - im) : 0.f,
+                     jp > jm ? 2.f * (elev(i, jm) - elev(i, jp)) / float(jp - jm) : 0.f,
+                     dz};
+      n = glm::normalize(n);
+
+      nx(i, j) = 0.5f * n.x + 0.5f;
+      ny(i, j) = 0.5f * n.y + 0.5f;
+      nz(i, j) = 0.5f * n.z + 0.5f;
+    }
+}
+
+static std::vector<hmap::VirtualArray *> get_channels(hmap::VirtualTexture &texture)
+{
+  std::vector<hmap::VirtualArray *> channels;
+
+  for (int nch = 0; nch < 4; ++nch)
+    channels.push_back(&texture.channel(nch));
+
+  return channels;
+}
+
+// extension of the formats written by the streamed mesh writer, empty otherwise
+static std::string get_streamed_mesh_extension(hmap::AssetExportFormat export_format,
+                                               hmap::MeshType          mesh_type)
+{
+  // regular and optimized triangle meshes
+  if (!hmap::mesh_type_as_string.at(mesh_type).starts_with("triangles"))
+    return "";
+
+  // format description, e.g. "GL Transmission Format v. 2 (binary) - *.glb"
+  const std::string description = hmap::asset_export_format_as_string.at(
+      export_format)[0];
+
+  for (const std::string ext : {".glb", ".obj"})
+    if (description.ends_with("*" + ext))
+      return ext;
+
+  return "";
+}
+
+// --- function(s)
+
 void setup_export_asset_node(BaseNode &node)
 {
   Logger::log()->trace("setup node {}", node.get_label());
@@ -94,63 +160,129 @@ void compute_export_asset_node(BaseNode &node)
     hmap::VirtualTexture *p_nmap = node.get_value_ref<hmap::VirtualTexture>(
         "normal map details");
 
-    hmap::Array           array = p_elev->to_array(node.cfg().cm_cpu);
     std::filesystem::path fpath = node.get_attr<FilenameAttribute>("fname");
 
     if (node.get_attr<BoolAttribute>("add_prefix"))
       fpath = prepend_project_name_to_path(fpath);
 
-    std::string fname = fpath.string();
-
-    // --- if available export RGBA to an image file
-
-    std::string texture_fname = "";
-
-    if (p_color)
+    // snapshot of the inputs and parameters, the export runs in the background
+    auto sp_elev = snapshot_heightmap(node, *p_elev);
+    auto sp_color = p_color ? snapshot_texture(node, *p_color) : nullptr;
+    auto sp_nmap = p_nmap ? snapshot_texture(node, *p_nmap) : nullptr;
+
+    const GraphConfig cfg = node.cfg();
+    const auto mesh_type = (hmap::MeshType)node.get_attr<EnumAttribute>("mesh_type");
+    const auto export_format = (hmap::AssetExportFormat)node.get_attr<EnumAttribute>(
+        "export_format");
+    const auto blending_method = (hmap::NormalMapBlendingMethod)
+                                     node.get_attr<EnumAttribute>("blending_method");
+    const float elevation_scaling = node.get_attr<FloatAttribute>("elevation_scaling");
+    const float detail_scaling = node.get_attr<FloatAttribute>("detail_scaling");
+    const float max_error = node.get_attr<FloatAttribute>("max_error");
+
+    auto export_fct = [=]()
     {
-      texture_fname = fname + ".png";
-      p_color->to_png(texture_fname, node.cfg().cm_cpu, CV_16U);
-    }
-
-    // --- blend details normal map with base normal map
-
-    std::string nmap_fname = fname + "_nmap.png";
-
-    // TODO optimize / distribute this
-    hmap::Tensor nvec = hmap::normal_map(p_elev->to_array(node.cfg().cm_cpu));
-    hmap::Array  nx = nvec.get_slice(0);
-    hmap::Array  ny = nvec.get_slice(1);
-    hmap::Array  nz = nvec.get_slice(2);
-    hmap::Array  alpha(node.cfg().shape, 1.f);
-
-    hmap::VirtualTexture normal_map(CONFIG_TEX(node));
-
-    normal_map.from_arrays({&nx, &ny, &nz, &alpha}, node.cfg().cm_cpu);
-
-    if (p_nmap)
-    {
-      hmap::mix_normal_map(
-          normal_map,
-          normal_map,
-          *p_nmap,
-          node.cfg().cm_cpu,
-          node.get_attr<FloatAttribute>("detail_scaling"),
-          (hmap::NormalMapBlendingMethod)node.get_attr<EnumAttribute>("blending_method"));
-    }
-
-    normal_map.to_png(nmap_fname, node.cfg().cm_cpu, CV_16U);
-
-    // --- export
-
-    hmap::export_asset(
-        fname,
-        array,
-        (hmap::MeshType)node.get_attr<EnumAttribute>("mesh_type"),
-        (hmap::AssetExportFormat)node.get_attr<EnumAttribute>("export_format"),
-        node.get_attr<FloatAttribute>("elevation_scaling"),
-        texture_fname,
-        nmap_fname,
-        node.get_attr<FloatAttribute>("max_error"));
+      std::string fname = fpath.string();
+
+      // --- if available export RGBA to an image file, written band by band
+
+      std::string texture_fname = "";
+
+      if (sp_color)
+      {
+        texture_fname = fname + ".png";
+
+        if (!export_png_streamed(get_channels(*sp_color),
+                                 cfg.tile_shape,
+                                 texture_fname,
+                                 16,
+                                 cfg.cm_cpu))
+          return false;
+      }
+
+      // --- blend details normal map with base normal map, the base normals are
+      // --- computed tile by tile at the scale of the whole heightmap
+
+      std::string nmap_fname = fname + "_nmap.png";
+
+      hmap::VirtualTexture normal_map(cfg.shape,
+                                      cfg.tile_shape,
+                                      cfg.halo,
+                                      4, // RGBA
+                                      cfg.storage_mode);
+
+      hmap::for_each_tile(
+          {&normal_map.channel(0),
+           &normal_map.channel(1),
+           &normal_map.channel(2),
+           sp_elev.get()},
+          [&cfg](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+          {
+            auto [pa_nx, pa_ny, pa_nz, pa_elev] = unpack<4>(p_arrays);
+            compute_base_normals(*pa_elev, cfg.shape, *pa_nx, *pa_ny, *pa_nz);
+          },
+          cfg.cm_cpu);
+
+      normal_map.fill(3, 1.f, cfg.cm_cpu);
+
+      if (sp_nmap)
+      {
+        hmap::mix_normal_map(normal_map,
+                             normal_map,
+                             *sp_nmap,
+                             cfg.cm_cpu,
+                             detail_scaling,
+                             blending_method);
+      }
+
+      if (!export_png_streamed(get_channels(normal_map),
+                               cfg.tile_shape,
+                               nmap_fname,
+                               16,
+                               cfg.cm_cpu))
+        return false;
+
+      // --- export, triangle meshes to glb/obj files are simplified and written
+      // --- chunk by chunk, the other formats go through the whole heightmap
+
+      const std::string mesh_ext = get_streamed_mesh_extension(export_format, mesh_type);
+
+      if (!mesh_ext.empty())
+      {
+        std::filesystem::path mesh_fname = fpath;
+
+        if (mesh_fname.extension() != mesh_ext)
+          mesh_fname += mesh_ext;
+
+        MeshExportOptions options;
+        options.elevation_scaling = elevation_scaling;
+        options.max_error = max_error;
+        options.simplify = hmap::mesh_type_as_string.at(mesh_type) != "triangles";
+        options.texture_fname = texture_fname;
+        options.normal_map_fname = nmap_fname;
+
+        return export_mesh_streamed(*sp_elev,
+                                    cfg.tile_shape,
+                                    mesh_fname.string(),
+                                    options,
+                                    cfg.cm_cpu);
+      }
+
+      hmap::Array array = sp_elev->to_array(cfg.cm_cpu);
+
+      hmap::export_asset(fname,
+                         array,
+                         mesh_type,
+                         export_format,
+                         elevation_scaling,
+                         texture_fname,
+                         nmap_fname,
+                         max_error);
+
+      return true;
+    };
+
+    submit_export(node, fpath, export_fct);
   }
 
   // not output, do not propagate
@@ -52,7 +52,13 @@ void compute_export_cloud_node(BaseNode &node)
     if (node.get_attr<BoolAttribute>("add_prefix"))
       fname = prepend_project_name_to_path(fname);
 
-    p_in->to_csv(fname.string());
+    submit_export(node,
+                  fname,
+                  [data = *p_in, fname]() mutable
+                  {
+                    data.to_csv(fname.string());
+                    return true;
+                  });
   }
 }
 
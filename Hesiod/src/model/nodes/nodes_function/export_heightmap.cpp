@@ -1,14 +1,13 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
-#include "highmap/export.hpp"
-
 #include "attributes.hpp"
 
 #include "hesiod/app/enum_mappings.hpp"
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/node_factory.hpp"
+#include "hesiod/model/nodes/post_process.hpp"
 #include "hesiod/model/utils.hpp"
 
 using namespace attr;
@@ -33,11 +32,13 @@ void setup_export_heightmap_node(BaseNode &node)
                                "File Format",
                                enum_mappings.heightmap_export_format_map,
                                "png (16 bit)");
+  node.add_attr<BoolAttribute>("tiff_compression", "TIFF Lossless Compression", true);
   node.add_attr<BoolAttribute>("auto_export", "Auto Export on Node Update", false);
   node.add_attr<BoolAttribute>("add_prefix", "Add Project Name as Prefix", false);
 
   // attribute(s) order
-  node.set_attr_ordered_key({"fname", "format", "auto_export", "add_prefix"});
+  node.set_attr_ordered_key(
+      {"fname", "format", "tiff_compression", "auto_export", "add_prefix"});
 }
 
 void compute_export_heightmap_node(BaseNode &node)
@@ -53,29 +54,48 @@ void compute_export_heightmap_node(BaseNode &node)
     if (node.get_attr<BoolAttribute>("add_prefix"))
       fname = prepend_project_name_to_path(fname);
 
-    switch (node.get_attr<EnumAttribute>("format"))
-    {
-    case ExportFormat::PNG8BIT:
-    {
-      fname = ensure_extension(fname, ".png");
-      p_in->to_array(node.cfg().cm_cpu).to_png_grayscale(fname.string(), CV_8U);
-    }
-    break;
-
-    case ExportFormat::PNG16BIT:
-    {
-      fname = ensure_extension(fname, ".png");
-      p_in->to_array(node.cfg().cm_cpu).to_png_grayscale(fname.string(), CV_16U);
-    }
-    break;
-
-    case ExportFormat::RAW16BIT:
-    {
-      fname = ensure_extension(fname, ".raw");
-      p_in->to_array(node.cfg().cm_cpu).to_raw_16bit(fname.string());
-    }
-    break;
-    }
+    // written tile by tile in the background, the full heightmap is never assembled
+    const glm::ivec2        tile_shape = node.cfg().tile_shape;
+    const hmap::ComputeMode cm = node.cfg().cm_cpu;
+    const int               format = node.get_attr<EnumAttribute>("format");
+    const bool              compress = node.get_attr<BoolAttribute>("tiff_compression");
+
+    const std::map<int, std::string> extensions = {{ExportFormat::PNG8BIT, ".png"},
+                                                   {ExportFormat::PNG16BIT, ".png"},
+                                                   {ExportFormat::RAW16BIT, ".raw"},
+                                                   {ExportFormat::TIFF32BIT, ".tif"}};
+
+    fname = ensure_extension(fname, extensions.at(format));
+
+    auto sp_in = snapshot_heightmap(node, *p_in);
+
+    submit_export(node,
+                  fname,
+                  [sp_in, tile_shape, cm, format, compress, fname]()
+                  {
+                    switch (format)
+                    {
+                    case ExportFormat::PNG8BIT:
+                    case ExportFormat::PNG16BIT:
+                      return export_png_streamed(*sp_in,
+                                                 tile_shape,
+                                                 fname.string(),
+                                                 format == ExportFormat::PNG8BIT ? 8 : 16,
+                                                 cm);
+                    case ExportFormat::RAW16BIT:
+                      return export_raw_16bit_streamed(*sp_in,
+                                                       tile_shape,
+                                                       fname.string(),
+                                                       cm);
+                    case ExportFormat::TIFF32BIT:
+                      return export_tiff_float32_streamed(*sp_in,
+                                                          tile_shape,
+                                                          fname.string(),
+                                                          compress,
+                                                          cm);
+                    }
+                    return false;
+                  });
   }
 }
 
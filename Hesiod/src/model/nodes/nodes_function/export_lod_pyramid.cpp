@@ -0,0 +1,156 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include "highmap/virtual_array/virtual_texture.hpp"
+
+#include "attributes.hpp"
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/nodes/node_factory.hpp"
+#include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/utils.hpp"
+
+using namespace attr;
+
+namespace hesiod
+{
+
+void setup_export_lod_pyramid_node(BaseNode &node)
+{
+  Logger::log()->trace("setup node {}", node.get_label());
+
+  // port(s)
+  node.add_port<hmap::VirtualArray>(gnode::PortType::IN, "elevation");
+  node.add_port<hmap::VirtualTexture>(gnode::PortType::IN, "texture");
+
+  // attribute(s)
+  node.add_attr<FilenameAttribute>("fname",
+                                   "Manifest File",
+                                   std::filesystem::path("terrain_lod.json"),
+                                   "JSON (*.json)",
+                                   true);
+
+  std::vector<std::string> chunk_sizes = {"64", "128", "256", "512", "1024"};
+  node.add_attr<ChoiceAttribute>("chunk_size", "Chunk Size", chunk_sizes, "256");
+
+  std::vector<std::string> formats = {"16 bit PNG", "32 bit float raw"};
+  node.add_attr<ChoiceAttribute>("elevation_format",
+                                 "Elevation Format",
+                                 formats,
+                                 "16 bit PNG");
+  node.add_attr<BoolAttribute>("texture_16bit", "16 bit Texture", false);
+  node.add_attr<BoolAttribute>("auto_export", "Auto Export on Node Update", false);
+  node.add_attr<BoolAttribute>("add_prefix", "Add Project Name as Prefix", false);
+
+  // attribute(s) order
+  node.set_attr_ordered_key({"fname",
+                             "chunk_size",
+                             "elevation_format",
+                             "texture_16bit",
+                             "_SEPARATOR_",
+                             "auto_export",
+                             "add_prefix"});
+}
+
+void compute_export_lod_pyramid_node(BaseNode &node)
+{
+  Logger::log()->trace("computing node [{}]/[{}]", node.get_label(), node.get_id());
+
+  hmap::VirtualArray   *p_elev = node.get_value_ref<hmap::VirtualArray>("elevation");
+  hmap::VirtualTexture *p_color = node.get_value_ref<hmap::VirtualTexture>("texture");
+
+  if ((p_elev || p_color) && node.get_attr<BoolAttribute>("auto_export"))
+  {
+    std::filesystem::path fname = node.get_attr<FilenameAttribute>("fname");
+    fname = ensure_extension(fname, ".json");
+
+    if (node.get_attr<BoolAttribute>("add_prefix"))
+      fname = prepend_project_name_to_path(fname);
+
+    const int  chunk_size = std::stoi(node.get_attr<ChoiceAttribute>("chunk_size"));
+    const bool raw = node.get_attr<ChoiceAttribute>("elevation_format") ==
+                     "32 bit float raw";
+    const bool texture_16bit = node.get_attr<BoolAttribute>("texture_16bit");
+    const glm::ivec2        shape = node.cfg().shape;
+    const glm::ivec2        tile_shape = node.cfg().tile_shape;
+    const hmap::ComputeMode cm = node.cfg().cm_cpu;
+
+    auto sp_elev = p_elev ? snapshot_heightmap(node, *p_elev) : nullptr;
+    auto sp_color = p_color ? snapshot_texture(node, *p_color) : nullptr;
+
+    auto export_fct = [=]()
+    {
+      // chunks in <fname stem>/elevation|texture/lod<l>/, next to the manifest
+      const std::filesystem::path root = std::filesystem::path(fname).replace_extension();
+
+      nlohmann::json json;
+      json["format_version"] = 1;
+      json["shape"] = {shape.x, shape.y};
+      json["chunk_size"] = chunk_size;
+      json["chunk_indexing"] = "i along x, j along y from the bottom, rows from the top";
+
+      for (const LodLevel &level : get_lod_pyramid_levels(shape, chunk_size))
+        json["levels"].push_back({{"shape", {level.shape.x, level.shape.y}},
+                                  {"nchunks", {level.nchunks.x, level.nchunks.y}}});
+
+      bool ok = true;
+
+      if (sp_elev)
+      {
+        const float vmin = sp_elev->min(cm);
+        const float vmax = sp_elev->max(cm);
+
+        ok = export_lod_pyramid_streamed({sp_elev.get()},
+                                         tile_shape,
+                                         root / "elevation",
+                                         chunk_size,
+                                         raw ? LodChunkFormat::RAW_FLOAT32
+                                             : LodChunkFormat::PNG_16BIT,
+                                         vmin,
+                                         vmax,
+                                         cm) &&
+             ok;
+
+        json["layers"]["elevation"] = {
+            {"path", (root.filename() / "elevation").string()},
+            {"encoding", raw ? "float32" : "png16"},
+            {"vmin", vmin},
+            {"vmax", vmax}};
+      }
+
+      if (sp_color)
+      {
+        std::vector<hmap::VirtualArray *> channels;
+        for (int nch = 0; nch < 4; ++nch)
+          channels.push_back(&sp_color->channel(nch));
+
+        ok = export_lod_pyramid_streamed(channels,
+                                         tile_shape,
+                                         root / "texture",
+                                         chunk_size,
+                                         texture_16bit ? LodChunkFormat::PNG_16BIT
+                                                       : LodChunkFormat::PNG_8BIT,
+                                         0.f,
+                                         1.f,
+                                         cm) &&
+             ok;
+
+        json["layers"]["texture"] = {{"path", (root.filename() / "texture").string()},
+                                     {"encoding", texture_16bit ? "png16" : "png8"}};
+      }
+
+      // the manifest comes last, its presence means the pyramid is complete
+      if (ok)
+        json_to_file(json, fname.string());
+
+      return ok;
+    };
+
+    submit_export(node, fname, export_fct);
+  }
+
+  // not output, do not propagate
+}
+
+} // namespace hesiod
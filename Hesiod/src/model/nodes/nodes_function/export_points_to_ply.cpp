@@ -118,7 +118,14 @@ void compute_export_points_to_ply_node(BaseNode &node)
                                     node.get_attr<FloatAttribute>("zmin"),
                                     node.get_attr<FloatAttribute>("zmax"));
 
-    hmap::export_points_to_ply(fname.string(), xr, yr, zr, custom_fields);
+    // the rescaled vectors are the snapshot of the inputs
+    submit_export(node,
+                  fname,
+                  [fname, xr, yr, zr, custom_fields]()
+                  {
+                    hmap::export_points_to_ply(fname.string(), xr, yr, zr, custom_fields);
+                    return true;
+                  });
   }
 }
 
@@ -31,11 +31,24 @@ void setup_export_texture_node(BaseNode &node)
                                    "PNG (*.png)",
                                    true);
   node.add_attr<BoolAttribute>("16 bit", "16 bit", false);
+  node.add_attr<BoolAttribute>("tiled", "Tiled Export", false);
+  setup_tiled_export_attributes(node);
   node.add_attr<BoolAttribute>("auto_export", "Auto Export on Node Update", false);
   node.add_attr<BoolAttribute>("add_prefix", "Add Project Name as Prefix", false);
 
   // attribute(s) order
-  node.set_attr_ordered_key({"fname", "16 bit", "auto_export", "add_prefix"});
+  node.set_attr_ordered_key({"fname",
+                             "16 bit",
+                             "_SEPARATOR_",
+                             "tiled",
+                             "tiling.x",
+                             "tiling.y",
+                             "leading_zeros",
+                             "overlapping_edges",
+                             "reverse_tile_y_indexing",
+                             "_SEPARATOR_",
+                             "auto_export",
+                             "add_prefix"});
 
   // specialized GUI
 }
@@ -54,10 +67,33 @@ void compute_export_texture_node(BaseNode &node)
     if (node.get_attr<BoolAttribute>("add_prefix"))
       fname = prepend_project_name_to_path(fname);
 
-    if (node.get_attr<BoolAttribute>("16 bit"))
-      p_in->to_png(fname.string(), node.cfg().cm_cpu, CV_16U);
-    else
-      p_in->to_png(fname.string(), node.cfg().cm_cpu, CV_8U);
+    const bool              tiled = node.get_attr<BoolAttribute>("tiled");
+    const bool              is_16bit = node.get_attr<BoolAttribute>("16 bit");
+    const TiledExportLayout layout = get_tiled_export_layout(node);
+    const glm::ivec2        tile_shape = node.cfg().tile_shape;
+    const hmap::ComputeMode cm = node.cfg().cm_cpu;
+
+    auto sp_in = snapshot_texture(node, *p_in);
+
+    submit_export(node,
+                  fname,
+                  [sp_in, tiled, is_16bit, layout, tile_shape, cm, fname]()
+                  {
+                    if (tiled)
+                    {
+                      // one file per tile, <fname stem>_<i>_<j>.png
+                      return export_texture_tiled_streamed(
+                          *sp_in,
+                          tile_shape,
+                          std::filesystem::path(fname).replace_extension().string(),
+                          layout,
+                          is_16bit ? 16 : 8,
+                          cm);
+                    }
+
+                    sp_in->to_png(fname.string(), cm, is_16bit ? CV_16U : CV_8U);
+                    return true;
+                  });
   }
 }
 
@@ -1,14 +1,13 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
-#include "highmap/export.hpp"
-
 #include "attributes.hpp"
 
 #include "hesiod/app/enum_mappings.hpp"
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/node_factory.hpp"
+#include "hesiod/model/nodes/post_process.hpp"
 #include "hesiod/model/utils.hpp"
 
 using namespace attr;
@@ -32,11 +31,7 @@ void setup_export_tiled_node(BaseNode &node)
 
   std::vector<std::string> choices = {"8 bit", "16 bit"};
   node.add_attr<ChoiceAttribute>("bit_depth", "PNG Bit Depth", choices, "16 bit");
-  node.add_attr<IntAttribute>("tiling.x", "Nb. of Tiles (x)", 4, 1, INT_MAX);
-  node.add_attr<IntAttribute>("tiling.y", "Nb. of Tiles (y)", 4, 1, INT_MAX);
-  node.add_attr<IntAttribute>("leading_zeros", "Leading Zeroes", 3, 1, 6);
-  node.add_attr<BoolAttribute>("overlapping_edges", "Overlapping Edges", false);
-  node.add_attr<BoolAttribute>("reverse_tile_y_indexing", "Reverse y-indexing", false);
+  setup_tiled_export_attributes(node);
   node.add_attr<BoolAttribute>("auto_export", "Auto Export on Node Update", false);
   node.add_attr<BoolAttribute>("add_prefix", "Add Project Name as Prefix", false);
 
@@ -66,24 +61,27 @@ void compute_export_tiled_node(BaseNode &node)
     if (node.get_attr<BoolAttribute>("add_prefix"))
       fname = prepend_project_name_to_path(fname);
 
-    int bit_depth;
-    if (node.get_attr<ChoiceAttribute>("bit_depth") == "8 bit")
-      bit_depth = CV_8U;
-    else
-      bit_depth = CV_16U;
-
-    glm::ivec2 tiling = {node.get_attr<IntAttribute>("tiling.x"),
-                         node.get_attr<IntAttribute>("tiling.y")};
-
-    // export
-    hmap::export_tiled(fname.string(),
-                       "png",
-                       p_in->to_array(node.cfg().cm_cpu),
-                       tiling,
-                       node.get_attr<IntAttribute>("leading_zeros"),
-                       bit_depth,
-                       node.get_attr<BoolAttribute>("overlapping_edges"),
-                       node.get_attr<BoolAttribute>("reverse_tile_y_indexing"));
+    int bit_depth = node.get_attr<ChoiceAttribute>("bit_depth") == "8 bit" ? 8 : 16;
+
+    const TiledExportLayout layout = get_tiled_export_layout(node);
+    const glm::ivec2        tile_shape = node.cfg().tile_shape;
+    const hmap::ComputeMode cm = node.cfg().cm_cpu;
+
+    // export, each file is written as soon as its heightmap tiles have been read, the
+    // files being encoded concurrently
+    auto sp_in = snapshot_heightmap(node, *p_in);
+
+    submit_export(node,
+                  fname,
+                  [sp_in, tile_shape, fname, layout, bit_depth, cm]()
+                  {
+                    return export_tiled_streamed(*sp_in,
+                                                 tile_shape,
+                                                 fname.string(),
+                                                 layout,
+                                                 bit_depth,
+                                                 cm);
+                  });
   }
 }
 
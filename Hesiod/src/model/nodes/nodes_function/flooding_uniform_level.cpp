@@ -8,6 +8,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -24,6 +25,8 @@ void setup_flooding_uniform_level_node(BaseNode &node)
 
   // attribute(s)
   node.add_attr<FloatAttribute>("elevation", "elevation", 0.2f, -1.f, 2.f);
+
+  node.set_tile_dependency(TileDependency::TDP_TILE);
 }
 
 void compute_flooding_uniform_level_node(BaseNode &node)
@@ -38,8 +41,13 @@ void compute_flooding_uniform_level_node(BaseNode &node)
 
     hmap::for_each_tile(
         {p_out, p_in},
-        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
         {
+          if (!node.is_tile_dirty(region))
+            return;
+
+          TileSpan span(node, region);
+
           auto [pa_out, pa_in] = unpack<2>(p_arrays);
           *pa_out = hmap::flooding_uniform_level(
               *pa_in,
@@ -8,6 +8,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -59,6 +60,11 @@ void compute_hydraulic_musgrave_node(BaseNode &node)
         {p_out, p_in, p_moisture_map},
         [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
         {
+          if (node.is_cancelled())
+            return;
+
+          TileSpan span(node, region);
+
           hmap::Array *pa_out = p_arrays[0];
           hmap::Array *pa_in = p_arrays[1];
           hmap::Array *pa_moisutre_map = p_arrays[2];
@@ -15,6 +15,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -235,6 +236,11 @@ void compute_hydraulic_particle_node(BaseNode &node)
                                    std::vector<hmap::Array *>       p_arrays_out,
                                    const hmap::TileRegion          &region)
       {
+        if (node.is_cancelled())
+          return;
+
+        TileSpan span(node, region);
+
         auto [pa_in, pa_bedrock, pa_moisture, pa_mask] = unpack<4>(p_arrays_in);
         auto [pa_out, pa_erosion, pa_deposition] = unpack<3>(p_arrays_out);
 
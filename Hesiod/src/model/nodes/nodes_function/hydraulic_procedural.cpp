@@ -9,6 +9,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -213,6 +214,11 @@ void compute_hydraulic_procedural_node(BaseNode &node)
                        std::vector<hmap::Array *>       p_arrays_out,
                        const hmap::TileRegion          &region)
       {
+        if (node.is_cancelled())
+          return;
+
+        TileSpan span(node, region);
+
         const auto [pa_in,
                     pa_noise_x,
                     pa_noise_y,
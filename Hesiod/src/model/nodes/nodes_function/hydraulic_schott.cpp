@@ -9,6 +9,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -58,8 +59,14 @@ void compute_hydraulic_schott_node(BaseNode &node)
 
     hmap::for_each_tile(
         {p_out, p_in, p_flow_map},
-        [&node, iterations](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+        [&node, iterations](std::vector<hmap::Array *> p_arrays,
+                            const hmap::TileRegion    &region)
         {
+          if (node.is_cancelled())
+            return;
+
+          TileSpan span(node, region);
+
           auto [pa_out, pa_in, pa_flow_map] = unpack<3>(p_arrays);
 
           *pa_out = *pa_in;
@@ -8,6 +8,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -50,8 +51,13 @@ void compute_hydraulic_stream_node(BaseNode &node)
 
     hmap::for_each_tile(
         {p_out, p_in, p_mask, p_erosion_map},
-        [&node, &ir](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+        [&node, &ir](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
         {
+          if (node.is_cancelled())
+            return;
+
+          TileSpan span(node, region);
+
           hmap::Array *pa_out = p_arrays[0];
           hmap::Array *pa_in = p_arrays[1];
           hmap::Array *pa_mask = p_arrays[2];
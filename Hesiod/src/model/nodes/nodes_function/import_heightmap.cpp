@@ -1,12 +1,15 @@
 /* Copyright (c) 2023 Otto Link. Distributed under the terms of the GNU General
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
+#include <atomic>
+#include <cmath>
 #include <fstream>
 
 #include "highmap/range.hpp"
 
 #include "attributes.hpp"
 
+#include "hesiod/app/hesiod_application.hpp"
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
@@ -16,6 +19,63 @@ using namespace attr;
 namespace hesiod
 {
 
+#ifdef HESIOD_DEBUG_CHECKS
+// the tiled resampling of the source is expected to match the dense resampling of the
+// whole image (any image shape, the grid corners matching the image corners)
+static void check_import_resampling(BaseNode                &node,
+                                    const std::string       &fname,
+                                    bool                     bicubic,
+                                    bool                     clip_range,
+                                    hmap::VirtualArray      &out,
+                                    const hmap::ComputeMode &cm)
+{
+  hmap::Array      z = hmap::Array(fname, node.get_attr<BoolAttribute>("flip_y"));
+  const glm::ivec2 source_shape = z.shape;
+
+  z = bicubic ? z.resample_to_shape_bicubic(out.shape)
+              : z.resample_to_shape_nearest(out.shape);
+
+  if (clip_range)
+    hmap::clamp(z, 0.f, 1.f);
+
+  const hmap::Array tiled = out.to_array(cm);
+
+  float      max_error = 0.f;
+  glm::ivec2 ij_max = {0, 0};
+
+  for (int j = 0; j < z.shape.y; ++j)
+    for (int i = 0; i < z.shape.x; ++i)
+    {
+      const float error = std::abs(tiled(i, j) - z(i, j));
+
+      if (error > max_error)
+      {
+        max_error = error;
+        ij_max = {i, j};
+      }
+    }
+
+  if (max_error > 1e-4f)
+    Logger::log()->warn("check_import_resampling: node [{}]/[{}], {} ({}x{} -> {}x{}): "
+                        "max error {} at ({}, {})",
+                        node.get_label(),
+                        node.get_id(),
+                        fname,
+                        source_shape.x,
+                        source_shape.y,
+                        out.shape.x,
+                        out.shape.y,
+                        max_error,
+                        ij_max.x,
+                        ij_max.y);
+  else
+    Logger::log()->trace("check_import_resampling: node [{}]/[{}], max error {}",
+                         node.get_label(),
+                         node.get_id(),
+                         max_error);
+}
+#endif
+
 void setup_import_heightmap_node(BaseNode &node)
 {
   Logger::log()->trace("setup node {}", node.get_label());
@@ -64,33 +124,64 @@ void compute_import_heightmap_node(BaseNode &node)
     }
   }
 
-  // raw import
-  hmap::Array z = hmap::Array(fname, node.get_attr<BoolAttribute>("flip_y"));
+  // source image, decoded (or mapped) once for all the nodes using this file, and kept
+  // across recomputes as long as the file is not modified
+  std::shared_ptr<const RasterSource> sp_src = HSD_CTX.import_cache.get_raster(
+      fname,
+      node.get_attr<BoolAttribute>("flip_y"));
+
+  if (!sp_src)
+  {
+    node.set_compute_failed();
+    return;
+  }
 
-  // resample to current shape
+  // resample to current shape, each tile reads the source window it covers
   const std::string sampling_method = node.get_attr<ChoiceAttribute>("sampling_method");
+  const bool        bicubic = sampling_method == "Bicubic";
+  const bool        clip_range = node.get_attr<BoolAttribute>("clip_range");
+  const glm::ivec2  shape = p_out->shape;
+  std::atomic<int>  nfailed = 0;
 
-  if (sampling_method == "Bicubic")
-    z = z.resample_to_shape_bicubic(p_out->shape);
-  else if (sampling_method == "Nearest")
-    z = z.resample_to_shape_nearest(p_out->shape);
+  hmap::for_each_tile(
+      {p_out},
+      [&](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
+      {
+        auto [pa_out] = unpack<1>(p_arrays);
 
-  p_out->from_array(z, node.cfg().cm_cpu);
+        const glm::ivec2 ij0 = {int(std::lround(region.bbox.x * float(shape.x))),
+                                int(std::lround(region.bbox.z * float(shape.y)))};
 
-  // make sure value range remains within [0, 1] to avoid overshoots
-  // due to interpolation
-  if (node.get_attr<BoolAttribute>("clip_range"))
-  {
-    hmap::for_each_tile(
-        {p_out},
-        [](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+        if (!sp_src->resample(ij0, shape, bicubic, *pa_out))
         {
-          auto [pa_out] = unpack<1>(p_arrays);
+          nfailed++;
+          return;
+        }
+
+        // make sure value range remains within [0, 1] to avoid overshoots
+        // due to interpolation
+        if (clip_range)
           hmap::clamp(*pa_out, 0.f, 1.f);
-        },
-        node.cfg().cm_cpu);
+      },
+      node.cfg().cm_cpu);
+
+  // short read or decoding error, the tiles are not filled
+  if (nfailed)
+  {
+    Logger::log()->error("compute_import_heightmap_node: node [{}]/[{}], {}: {} tile(s) "
+                         "could not be read",
+                         node.get_label(),
+                         node.get_id(),
+                         fname,
+                         nfailed.load());
+    node.set_compute_failed();
+    return;
   }
 
+#ifdef HESIOD_DEBUG_CHECKS
+  check_import_resampling(node, fname, bicubic, clip_range, *p_out, node.cfg().cm_cpu);
+#endif
+
   // post-process
   post_process_heightmap(node, *p_out);
 }
@@ -8,6 +8,7 @@
 
 #include "attributes.hpp"
 
+#include "hesiod/app/hesiod_application.hpp"
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
@@ -49,9 +50,15 @@ void compute_import_texture_node(BaseNode &node)
   std::ifstream f(fname.c_str());
   if (f.good())
   {
-    // load rgba data
-    hmap::Tensor tensor4(fname, node.get_attr<BoolAttribute>("flip_y"));
-    tensor4 = tensor4.resample_to_shape_xy(node.cfg().shape);
+    // load rgba data, decoded once for all the nodes using this file
+    std::shared_ptr<const hmap::Tensor> sp_raw = HSD_CTX.import_cache.get_tensor(
+        fname,
+        node.get_attr<BoolAttribute>("flip_y"));
+
+    if (!sp_raw)
+      return;
+
+    hmap::Tensor tensor4 = sp_raw->resample_to_shape_xy(node.cfg().shape);
 
     hmap::Array ra = tensor4.get_slice(0);
     hmap::Array ga = tensor4.get_slice(1);
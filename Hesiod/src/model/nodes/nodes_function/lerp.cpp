@@ -8,6 +8,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -45,6 +46,8 @@ void setup_lerp_node(BaseNode &node)
 
   // attribute(s) order
   node.set_attr_ordered_key({A_T, A_SWAP_INPUTS});
+
+  node.set_tile_dependency(TileDependency::TDP_TILE);
 }
 
 // -----------------------------------------------------------------------------
@@ -73,8 +76,13 @@ void compute_lerp_node(BaseNode &node)
       {p_out},
       [&node](std::vector<const hmap::Array *> p_arrays_in,
               std::vector<hmap::Array *>       p_arrays_out,
-              const hmap::TileRegion &)
+              const hmap::TileRegion &region)
       {
+        if (!node.is_tile_dirty(region))
+          return;
+
+        TileSpan span(node, region);
+
         auto [pa_a, pa_b, pa_t] = unpack<3>(p_arrays_in);
         auto [pa_out] = unpack<1>(p_arrays_out);
 
@@ -8,6 +8,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -30,6 +31,8 @@ void setup_recast_canyon_node(BaseNode &node)
 
   // attribute(s) order
   node.set_attr_ordered_key({"vcut", "gamma"});
+
+  node.set_tile_dependency(TileDependency::TDP_TILE);
 }
 
 void compute_recast_canyon_node(BaseNode &node)
@@ -46,8 +49,13 @@ void compute_recast_canyon_node(BaseNode &node)
 
     hmap::for_each_tile(
         {p_out, p_in, p_noise, p_mask},
-        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
         {
+          if (!node.is_tile_dirty(region))
+            return;
+
+          TileSpan span(node, region);
+
           hmap::Array *pa_out = p_arrays[0];
           hmap::Array *pa_in = p_arrays[1];
           hmap::Array *pa_noise = p_arrays[2];
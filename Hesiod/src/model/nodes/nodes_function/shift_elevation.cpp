@@ -6,6 +6,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -22,6 +23,8 @@ void setup_shift_elevation_node(BaseNode &node)
 
   // attribute(s)
   node.add_attr<FloatAttribute>("shift", "shift", 0.f, -2.f, 2.f);
+
+  node.set_tile_dependency(TileDependency::TDP_TILE);
 }
 
 void compute_shift_elevation_node(BaseNode &node)
@@ -36,8 +39,13 @@ void compute_shift_elevation_node(BaseNode &node)
 
     hmap::for_each_tile(
         {p_out, p_in},
-        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
         {
+          if (!node.is_tile_dirty(region))
+            return;
+
+          TileSpan span(node, region);
+
           auto [pa_out, pa_in] = unpack<2>(p_arrays);
           *pa_out = *pa_in + node.get_attr<FloatAttribute>("shift");
         },
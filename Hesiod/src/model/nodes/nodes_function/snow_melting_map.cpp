@@ -7,6 +7,7 @@
 
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -70,6 +71,9 @@ void setup_snow_melting_map_node(BaseNode &node)
                              A_SLOPE_EXP,
                              A_SLOPE_STRENGTH,
                              "_GROUPBOX_END_"});
+
+  // gradients are computed using the tile halo, neighbor tiles are also recomputed
+  node.set_tile_dependency(TileDependency::TDP_HALO);
 }
 
 // -----------------------------------------------------------------------------
@@ -123,8 +127,13 @@ void compute_snow_melting_map_node(BaseNode &node)
       {p_melting_map},
       [&node, &params](std::vector<const hmap::Array *> p_arrays_in,
                        std::vector<hmap::Array *>       p_arrays_out,
-                       const hmap::TileRegion &)
+                       const hmap::TileRegion &region)
       {
+        if (!node.is_tile_dirty(region))
+          return;
+
+        TileSpan span(node, region);
+
         const auto [pa_z] = unpack<1>(p_arrays_in);
         auto [pa_melting_map] = unpack<1>(p_arrays_out);
 
@@ -12,6 +12,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -89,8 +90,13 @@ void compute_thermal_node(BaseNode &node)
     hmap::for_each_tile(
         {p_out, p_in, p_mask, &talus_map, p_deposition_map},
         [&node, talus, iterations](std::vector<hmap::Array *> p_arrays,
-                                   const hmap::TileRegion &)
+                                   const hmap::TileRegion &region)
         {
+          if (node.is_cancelled())
+            return;
+
+          TileSpan span(node, region);
+
           auto [pa_out, pa_in, pa_mask, pa_talus_map, pa_deposition_map] = unpack<5>(
               p_arrays);
 
@@ -12,6 +12,7 @@
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -31,6 +32,8 @@ void setup_thru_node(BaseNode &node)
 
   // attribute(s) order
   node.set_attr_ordered_key({"block_update"});
+
+  node.set_tile_dependency(TileDependency::TDP_TILE);
 }
 
 void compute_thru_node(BaseNode &node)
@@ -46,8 +49,13 @@ void compute_thru_node(BaseNode &node)
     // copy the input data
     hmap::for_each_tile(
         {p_out, p_in},
-        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
         {
+          if (!node.is_tile_dirty(region))
+            return;
+
+          TileSpan span(node, region);
+
           auto [pa_out, pa_in] = unpack<2>(p_arrays);
           *pa_out = *pa_in;
         },
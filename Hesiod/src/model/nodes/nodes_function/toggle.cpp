@@ -7,6 +7,7 @@
 
 #include "hesiod/logger.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -27,6 +28,8 @@ void setup_toggle_node(BaseNode &node)
 
   // attribute(s) order
   node.set_attr_ordered_key({"toggle"});
+
+  node.set_tile_dependency(TileDependency::TDP_TILE);
 }
 
 void compute_toggle_node(BaseNode &node)
@@ -43,8 +46,13 @@ void compute_toggle_node(BaseNode &node)
     // copy the either A or B input heightmap based on the toggle state
     hmap::for_each_tile(
         {p_out, p_in_a, p_in_b},
-        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &)
+        [&node](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
         {
+          if (!node.is_tile_dirty(region))
+            return;
+
+          TileSpan span(node, region);
+
           hmap::Array *pa_out = p_arrays[0];
           hmap::Array *pa_in_a = p_arrays[1];
           hmap::Array *pa_in_b = p_arrays[2];
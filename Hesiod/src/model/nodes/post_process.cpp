@@ -12,6 +12,7 @@
 #include "hesiod/app/enum_mappings.hpp"
 #include "hesiod/model/nodes/base_node.hpp"
 #include "hesiod/model/nodes/post_process.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -76,6 +77,9 @@ void post_process_heightmap(BaseNode           &node,
                        node.get_node_type(),
                        node.get_id());
 
+  PostProcessTimer timer;
+  ProfileSpan      span("post_process_heightmap", "post_process");
+
   // mix
   if (p_in)
   {
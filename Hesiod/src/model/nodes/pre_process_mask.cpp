@@ -9,6 +9,7 @@
 #include "attributes.hpp"
 
 #include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/profiler.hpp"
 
 using namespace attr;
 
@@ -24,6 +25,9 @@ std::shared_ptr<hmap::VirtualArray> pre_process_mask(BaseNode            &node,
   if (p_mask || !node.get_attr<BoolAttribute>("mask_activate"))
     return std::make_shared<hmap::VirtualArray>();
 
+  PostProcessTimer timer;
+  ProfileSpan      span("pre_process_mask", "post_process");
+
   // create mask storage and assign to current mask pointer
   std::shared_ptr<hmap::VirtualArray> sp_mask = std::make_shared<hmap::VirtualArray>(
       node.cfg().shape,
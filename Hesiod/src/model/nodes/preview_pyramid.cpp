@@ -0,0 +1,140 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/preview_pyramid.hpp"
+#include "hesiod/model/streaming_export.hpp"
+
+namespace hesiod
+{
+
+std::shared_ptr<const PreviewPyramid> PreviewPyramid::build(
+    hmap::VirtualArray      &array,
+    const glm::ivec2        &tile_shape,
+    const hmap::ComputeMode &cm)
+{
+  const glm::ivec2 shape = array.shape;
+
+  if (shape.x < 1 || shape.y < 1)
+    return nullptr;
+
+  auto sp_pyramid = std::make_shared<PreviewPyramid>();
+  sp_pyramid->source_shape = shape;
+
+  // finest level, with the aspect ratio of the heightmap. Each cell takes the value of
+  // its nearest heightmap cell (the domain corners are kept)
+  const float      ratio = float(PreviewPyramid::max_resolution) /
+                      float(std::max(shape.x, shape.y));
+  const glm::ivec2 n = {std::max(2, int(std::lround(ratio * float(shape.x)))),
+                        std::max(2, int(std::lround(ratio * float(shape.y))))};
+  hmap::Array      finest(n);
+
+  std::vector<int> src_i(n.x), src_j(n.y);
+
+  for (int k = 0; k < n.x; ++k)
+    src_i[k] = int(std::lround(float(k) * float(shape.x - 1) / float(n.x - 1)));
+
+  for (int k = 0; k < n.y; ++k)
+    src_j[k] = int(std::lround(float(k) * float(shape.y - 1) / float(n.y - 1)));
+
+  float      vmin = std::numeric_limits<float>::max();
+  float      vmax = std::numeric_limits<float>::lowest();
+  std::mutex mutex;
+
+  // tile layout expected by get_tile_interior
+  hmap::ComputeMode cm_tiles = cm;
+  cm_tiles.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+
+  hmap::for_each_tile(
+      {&array},
+      [&](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
+      {
+        const hmap::Array &tile = *p_arrays[0];
+
+        // each cell of the level is written by the tile owning its heightmap cell
+        const TileInterior interior = get_tile_interior(region, shape, tile_shape);
+        const glm::ivec2  &tile_ij0 = interior.ij0;
+        const glm::ivec2  &a = interior.a;
+        const glm::ivec2  &b = interior.b;
+
+        auto first = [](const std::vector<int> &v, int value)
+        { return int(std::lower_bound(v.begin(), v.end(), value) - v.begin()); };
+
+        for (int i = first(src_i, a.x); i < first(src_i, b.x); ++i)
+          for (int j = first(src_j, a.y); j < first(src_j, b.y); ++j)
+            finest(i, j) = tile(src_i[i] - tile_ij0.x, src_j[j] - tile_ij0.y);
+
+        // the halo belongs to the heightmap as well, no need to exclude it
+        const auto [it_min, it_max] = std::minmax_element(tile.vector.begin(),
+                                                          tile.vector.end());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        vmin = std::min(vmin, *it_min);
+        vmax = std::max(vmax, *it_max);
+      },
+      cm_tiles);
+
+  sp_pyramid->vmin = vmin;
+  sp_pyramid->vmax = vmax;
+
+  // coarser levels, box-filtered
+  sp_pyramid->levels.push_back(std::move(finest));
+
+  auto largest_side = [](const hmap::Array &level)
+  { return std::max(level.shape.x, level.shape.y); };
+
+  while (largest_side(sp_pyramid->levels.back()) > PreviewPyramid::min_resolution)
+    sp_pyramid->levels.push_back(downsample_2x(sp_pyramid->levels.back()));
+
+  return sp_pyramid;
+}
+
+hmap::Array PreviewPyramid::get_array(const glm::ivec2 &shape) const
+{
+  const hmap::Array &level = this->get_level(std::max(shape.x, shape.y));
+
+  if (level.shape == shape)
+    return level;
+  else
+    return level.resample_to_shape_nearest(shape);
+}
+
+std::vector<float> PreviewPyramid::get_histogram(int nbins) const
+{
+  std::vector<float> hist(std::max(nbins, 0), 0.f);
+
+  if (nbins < 1 || this->vmin >= this->vmax)
+    return hist;
+
+  const hmap::Array &level = this->get_level(256);
+  const float        a = float(nbins - 1) / (this->vmax - this->vmin);
+  const float        b = -this->vmin * a;
+
+  for (float v : level.vector)
+    hist[std::clamp(int(a * v + b), 0, nbins - 1)] += 1.f;
+
+  return hist;
+}
+
+const hmap::Array &PreviewPyramid::get_level(int resolution) const
+{
+  // levels are sorted from the finest to the coarsest
+  for (auto it = this->levels.rbegin(); it != this->levels.rend(); ++it)
+    if (std::max(it->shape.x, it->shape.y) >= resolution)
+      return *it;
+
+  return this->levels.front();
+}
+
+float PreviewPyramid::get_max() const { return this->vmax; }
+
+float PreviewPyramid::get_min() const { return this->vmin; }
+
+glm::ivec2 PreviewPyramid::get_source_shape() const { return this->source_shape; }
+
+} // namespace hesiod
@@ -0,0 +1,463 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <zlib.h>
+
+#include <QFile>
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/raster_source.hpp"
+
+namespace hesiod
+{
+
+// --- helpers
+
+// Catmull-Rom interpolation between p1 (t = 0) and p2 (t = 1)
+static float cubic(float p0, float p1, float p2, float p3, float t)
+{
+  return p1 + 0.5f * t *
+                  (p2 - p0 +
+                   t * (2.f * p0 - 5.f * p1 + 4.f * p2 - p3 +
+                        t * (3.f * (p1 - p2) + p3 - p0)));
+}
+
+template <typename T> static T read_le(const uint8_t *p)
+{
+  T value;
+  std::memcpy(&value, p, sizeof(T)); // TIFF little endian, as the supported platforms
+  return value;
+}
+
+// =====================================
+// RasterSource
+// =====================================
+
+glm::ivec2 RasterSource::get_shape() const { return this->shape; }
+
+bool RasterSource::resample(const glm::ivec2 &ij0,
+                            const glm::ivec2 &grid_shape,
+                            bool              bicubic,
+                            hmap::Array      &tile) const
+{
+  if (this->shape.x < 1 || this->shape.y < 1)
+    return false;
+
+  // grid corners match the image corners, as hmap::Array::resample_to_shape_*
+  const glm::vec2 scale = {grid_shape.x > 1 ? float(this->shape.x - 1) /
+                                                  float(grid_shape.x - 1)
+                                            : 0.f,
+                           grid_shape.y > 1 ? float(this->shape.y - 1) /
+                                                  float(grid_shape.y - 1)
+                                            : 0.f};
+
+  auto source_coord = [&](int i, int axis)
+  {
+    const int k = std::clamp(ij0[axis] + i, 0, grid_shape[axis] - 1);
+    return float(k) * scale[axis];
+  };
+
+  // source window covered by the tile, with the bicubic stencil margin
+  const int  margin = bicubic ? 2 : 1;
+  glm::ivec2 w0, w1;
+
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    w0[axis] = int(std::floor(source_coord(0, axis))) - margin;
+    w1[axis] = int(std::floor(source_coord(tile.shape[axis] - 1, axis))) + margin + 1;
+    w0[axis] = std::clamp(w0[axis], 0, this->shape[axis] - 1);
+    w1[axis] = std::clamp(w1[axis], w0[axis] + 1, this->shape[axis]);
+  }
+
+  hmap::Array window;
+  if (!this->read_window(w0, w1 - w0, window))
+    return false;
+
+  auto at = [&](int i, int j)
+  {
+    return window(std::clamp(i - w0.x, 0, window.shape.x - 1),
+                  std::clamp(j - w0.y, 0, window.shape.y - 1));
+  };
+
+  for (int j = 0; j < tile.shape.y; ++j)
+  {
+    const float y = source_coord(j, 1);
+    const int   jy = int(std::floor(y));
+    const float ty = y - float(jy);
+
+    for (int i = 0; i < tile.shape.x; ++i)
+    {
+      const float x = source_coord(i, 0);
+
+      if (!bicubic)
+      {
+        tile(i, j) = at(int(std::lround(x)), int(std::lround(y)));
+        continue;
+      }
+
+      const int   ix = int(std::floor(x));
+      const float tx = x - float(ix);
+      float       rows[4];
+
+      for (int r = 0; r < 4; ++r)
+        rows[r] = cubic(at(ix - 1, jy - 1 + r),
+                        at(ix, jy - 1 + r),
+                        at(ix + 1, jy - 1 + r),
+                        at(ix + 2, jy - 1 + r),
+                        tx);
+
+      tile(i, j) = cubic(rows[0], rows[1], rows[2], rows[3], ty);
+    }
+  }
+
+  return true;
+}
+
+// =====================================
+// ArrayRasterSource
+// =====================================
+
+ArrayRasterSource::ArrayRasterSource(std::shared_ptr<const hmap::Array> array)
+    : array(array)
+{
+  if (this->array)
+    this->shape = this->array->shape;
+}
+
+bool ArrayRasterSource::read_window(const glm::ivec2 &ij0,
+                                    const glm::ivec2 &window_shape,
+                                    hmap::Array      &out) const
+{
+  if (!this->array)
+    return false;
+
+  out = hmap::Array(window_shape);
+
+  for (int j = 0; j < window_shape.y; ++j)
+    for (int i = 0; i < window_shape.x; ++i)
+      out(i, j) = (*this->array)(ij0.x + i, ij0.y + j);
+
+  return true;
+}
+
+// =====================================
+// MappedTiffSource
+// =====================================
+
+MappedTiffSource::~MappedTiffSource() = default; // QFile complete here
+
+const uint8_t *MappedTiffSource::get_block(size_t                block_index,
+                                           int                   nrows,
+                                           std::vector<uint8_t> &buffer) const
+{
+  const size_t bytes_per_sample = size_t(this->bits_per_sample / 8);
+  const size_t row_bytes = size_t(this->block_shape.x) * bytes_per_sample;
+  const size_t raw_size = row_bytes * size_t(nrows);
+
+  const uint64_t offset = this->offsets[block_index];
+  const uint64_t count = this->byte_counts[block_index];
+
+  if (offset + count > this->size)
+    return nullptr;
+
+  // uncompressed, read in place
+  if (this->compression == 1)
+    return count < raw_size ? nullptr : this->p_data + offset;
+
+  buffer.resize(raw_size);
+
+  uLongf dst_size = static_cast<uLongf>(raw_size);
+  if (uncompress(buffer.data(),
+                 &dst_size,
+                 this->p_data + offset,
+                 static_cast<uLong>(count)) != Z_OK ||
+      dst_size != raw_size)
+    return nullptr;
+
+  // undo the predictor, row by row
+  if (this->predictor == 2)
+  {
+    for (int r = 0; r < nrows; ++r)
+    {
+      uint8_t *p_row = buffer.data() + size_t(r) * row_bytes;
+
+      if (bytes_per_sample == 1)
+        for (size_t k = 1; k < row_bytes; ++k)
+          p_row[k] += p_row[k - 1];
+      else
+        for (size_t k = 2; k < row_bytes; k += 2)
+        {
+          const uint16_t v = read_le<uint16_t>(p_row + k) +
+                             read_le<uint16_t>(p_row + k - 2);
+          std::memcpy(p_row + k, &v, 2);
+        }
+    }
+  }
+  else if (this->predictor == 3)
+  {
+    // byte differencing, then byte planes, most significant first
+    std::vector<uint8_t> row(row_bytes);
+    const size_t         w = size_t(this->block_shape.x);
+
+    for (int r = 0; r < nrows; ++r)
+    {
+      uint8_t *p_row = buffer.data() + size_t(r) * row_bytes;
+
+      for (size_t k = 1; k < row_bytes; ++k)
+        p_row[k] += p_row[k - 1];
+
+      for (size_t i = 0; i < w; ++i)
+      {
+        const uint32_t bits = (uint32_t(p_row[i]) << 24) |
+                              (uint32_t(p_row[w + i]) << 16) |
+                              (uint32_t(p_row[2 * w + i]) << 8) |
+                              uint32_t(p_row[3 * w + i]);
+        std::memcpy(row.data() + 4 * i, &bits, 4);
+      }
+
+      std::memcpy(p_row, row.data(), row_bytes);
+    }
+  }
+
+  return buffer.data();
+}
+
+size_t MappedTiffSource::get_mapped_size() const { return this->size; }
+
+float MappedTiffSource::get_sample(const uint8_t *p) const
+{
+  if (this->sample_format == 3)
+    return read_le<float>(p);
+  else if (this->bits_per_sample == 16)
+    return float(read_le<uint16_t>(p)) / 65535.f;
+  else
+    return float(*p) / 255.f;
+}
+
+std::shared_ptr<MappedTiffSource> MappedTiffSource::open(
+    const std::filesystem::path &fname,
+    bool                         flip_y)
+{
+  std::string ext = fname.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+  if (ext != ".tif" && ext != ".tiff")
+    return nullptr;
+
+  std::shared_ptr<MappedTiffSource> sp_source(new MappedTiffSource());
+  MappedTiffSource                 &src = *sp_source;
+
+  src.flip_y = flip_y;
+  src.file = std::make_unique<QFile>(QString::fromStdString(fname.string()));
+
+  if (!src.file->open(QIODevice::ReadOnly))
+    return nullptr;
+
+  src.size = static_cast<size_t>(src.file->size());
+  src.p_data = src.file->map(0, src.file->size());
+
+  if (!src.p_data || src.size < 16 || src.p_data[0] != 'I' || src.p_data[1] != 'I')
+    return nullptr; // not mapped, or big endian
+
+  // header, classic TIFF or BigTIFF
+  const uint16_t version = read_le<uint16_t>(src.p_data + 2);
+  const bool     big = version == 43;
+
+  if (version != 42 && !big)
+    return nullptr;
+
+  const uint64_t ifd = big ? read_le<uint64_t>(src.p_data + 8)
+                           : read_le<uint32_t>(src.p_data + 4);
+  const size_t   entry_size = big ? 20 : 12;
+  const size_t   count_size = big ? 8 : 2;
+
+  if (ifd + count_size > src.size)
+    return nullptr;
+
+  const uint64_t nentries = big ? read_le<uint64_t>(src.p_data + ifd)
+                                : read_le<uint16_t>(src.p_data + ifd);
+
+  if (ifd + count_size + nentries * entry_size > src.size)
+    return nullptr;
+
+  // values of the first image directory (full resolution image, overviews follow)
+  auto get_values = [&](const uint8_t *p_entry)
+  {
+    const uint16_t type = read_le<uint16_t>(p_entry + 2);
+    const uint64_t n = big ? read_le<uint64_t>(p_entry + 4)
+                           : read_le<uint32_t>(p_entry + 4);
+    const size_t   type_size = type == 3 ? 2 : (type == 4 ? 4 : (type == 16 ? 8 : 0));
+
+    std::vector<uint64_t> values;
+    const size_t          inline_size = big ? 8 : 4;
+    const uint8_t        *p_value = p_entry + (big ? 12 : 8);
+
+    if (type_size == 0)
+      return values;
+
+    if (n * type_size > inline_size)
+    {
+      const uint64_t offset = big ? read_le<uint64_t>(p_value)
+                                  : read_le<uint32_t>(p_value);
+      if (offset + n * type_size > src.size)
+        return values;
+      p_value = src.p_data + offset;
+    }
+
+    values.resize(n);
+    for (size_t k = 0; k < n; ++k)
+    {
+      const uint8_t *p = p_value + k * type_size;
+      values[k] = type == 3   ? read_le<uint16_t>(p)
+                  : type == 4 ? read_le<uint32_t>(p)
+                              : read_le<uint64_t>(p);
+    }
+    return values;
+  };
+
+  uint64_t              samples_per_pixel = 1;
+  uint64_t              planar = 1;
+  uint64_t              rows_per_strip = 0;
+  glm::ivec2            tile_shape = {0, 0};
+  std::vector<uint64_t> strip_offsets, strip_counts;
+
+  for (size_t k = 0; k < nentries; ++k)
+  {
+    const uint8_t        *p_entry = src.p_data + ifd + count_size + k * entry_size;
+    const uint16_t        tag = read_le<uint16_t>(p_entry);
+    std::vector<uint64_t> v = get_values(p_entry);
+
+    if (v.empty())
+      continue;
+
+    switch (tag)
+    {
+    case 256: src.shape.x = int(v[0]); break;
+    case 257: src.shape.y = int(v[0]); break;
+    case 258: src.bits_per_sample = int(v[0]); break;
+    case 259: src.compression = int(v[0]); break;
+    case 273: strip_offsets = v; break;
+    case 277: samples_per_pixel = v[0]; break;
+    case 278: rows_per_strip = v[0]; break;
+    case 279: strip_counts = v; break;
+    case 284: planar = v[0]; break;
+    case 317: src.predictor = int(v[0]); break;
+    case 322: tile_shape.x = int(v[0]); break;
+    case 323: tile_shape.y = int(v[0]); break;
+    case 324: src.offsets = v; break;
+    case 325: src.byte_counts = v; break;
+    case 339: src.sample_format = int(v[0]); break;
+    }
+  }
+
+  // blocks, tiles or strips
+  src.tiled = tile_shape.x > 0 && tile_shape.y > 0;
+
+  if (src.tiled)
+  {
+    src.block_shape = tile_shape;
+  }
+  else
+  {
+    rows_per_strip = std::clamp(rows_per_strip, uint64_t(1), uint64_t(src.shape.y));
+    src.block_shape = {src.shape.x, int(rows_per_strip)};
+    src.offsets = strip_offsets;
+    src.byte_counts = strip_counts;
+  }
+
+  const bool supported_format = (src.sample_format == 1 && (src.bits_per_sample == 8 ||
+                                                            src.bits_per_sample == 16)) ||
+                                (src.sample_format == 3 && src.bits_per_sample == 32);
+  const bool supported_compression = src.compression == 1 || src.compression == 8 ||
+                                     src.compression == 32946;
+  const bool supported_predictor = src.predictor == 1 ||
+                                   (src.predictor == 2 && src.sample_format == 1) ||
+                                   (src.predictor == 3 && src.sample_format == 3);
+
+  // large compressed strips would be decoded again by each tile, the file is better
+  // decoded once
+  const bool large_strips = !src.tiled && src.compression != 1 && rows_per_strip > 64;
+
+  if (src.shape.x < 1 || src.shape.y < 1 || samples_per_pixel != 1 || planar != 1 ||
+      !supported_format || !supported_compression || !supported_predictor ||
+      large_strips || src.block_shape.x < 1)
+  {
+    Logger::log()->trace("MappedTiffSource::open: unsupported layout, {}", fname.string());
+    return nullptr;
+  }
+
+  src.nblocks = (src.shape + src.block_shape - 1) / src.block_shape;
+
+  const size_t nblocks_total = size_t(src.nblocks.x) * size_t(src.nblocks.y);
+
+  if (src.offsets.size() < nblocks_total || src.byte_counts.size() < nblocks_total)
+    return nullptr;
+
+  Logger::log()->trace("MappedTiffSource::open: {}, {}x{}, blocks {}x{}",
+                       fname.string(),
+                       src.shape.x,
+                       src.shape.y,
+                       src.block_shape.x,
+                       src.block_shape.y);
+
+  return sp_source;
+}
+
+bool MappedTiffSource::read_window(const glm::ivec2 &ij0,
+                                   const glm::ivec2 &window_shape,
+                                   hmap::Array      &out) const
+{
+  out = hmap::Array(window_shape);
+
+  // window rows, counted from the image top
+  const int row0 = this->flip_y ? this->shape.y - ij0.y - window_shape.y : ij0.y;
+  const int row1 = row0 + window_shape.y;
+  const int col0 = ij0.x;
+  const int col1 = ij0.x + window_shape.x;
+
+  const size_t         bytes_per_sample = size_t(this->bits_per_sample / 8);
+  const glm::ivec2    &bs = this->block_shape;
+  std::vector<uint8_t> buffer;
+
+  for (int bj = row0 / bs.y; bj * bs.y < row1; ++bj)
+    for (int bi = col0 / bs.x; bi * bs.x < col1; ++bi)
+    {
+      // tiles are padded, the last strip is not
+      const int nrows = this->tiled ? bs.y : std::min(bs.y, this->shape.y - bj * bs.y);
+
+      const size_t   block_index = size_t(bj) * size_t(this->nblocks.x) + size_t(bi);
+      const uint8_t *p_block = this->get_block(block_index, nrows, buffer);
+
+      if (!p_block)
+      {
+        Logger::log()->error("MappedTiffSource::read_window: corrupted block {} {}",
+                             bi,
+                             bj);
+        return false;
+      }
+
+      const int r0 = std::max(row0, bj * bs.y);
+      const int r1 = std::min(row1, bj * bs.y + nrows);
+      const int c0 = std::max(col0, bi * bs.x);
+      const int c1 = std::min(col1, (bi + 1) * bs.x);
+
+      for (int r = r0; r < r1; ++r)
+      {
+        const int      j = this->flip_y ? this->shape.y - 1 - r - ij0.y : r - ij0.y;
+        const uint8_t *p_row = p_block + size_t(r - bj * bs.y) * size_t(bs.x) *
+                                             bytes_per_sample;
+
+        for (int c = c0; c < c1; ++c)
+          out(c - col0, j) = this->get_sample(p_row + size_t(c - bi * bs.x) *
+                                                          bytes_per_sample);
+      }
+    }
+
+  return true;
+}
+
+} // namespace hesiod
@@ -0,0 +1,368 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/region_query.hpp"
+#include "hesiod/model/streaming_export.hpp"
+
+namespace hesiod
+{
+
+static void               add_profile_cells(const glm::ivec2        &shape,
+                                            const glm::vec2         &p0,
+                                            const glm::vec2         &p1,
+                                            int                      nsamples,
+                                            std::vector<glm::ivec2> &cells,
+                                            std::vector<float>      &weights);
+static void               add_window_cells(const glm::ivec2        &shape,
+                                           const glm::ivec2        &ij0,
+                                           const glm::ivec2        &window_shape,
+                                           const glm::ivec2        &shape_out,
+                                           std::vector<glm::ivec2> &cells);
+static std::vector<float> get_samples(const std::vector<float> &values,
+                                      const std::vector<float> &weights);
+static hmap::Array        get_window(const std::vector<float> &values,
+                                     size_t                    offset,
+                                     const glm::ivec2         &shape_out);
+static std::vector<float> read_cells(hmap::VirtualArray            &array,
+                                     const std::vector<glm::ivec2> &cells,
+                                     const glm::ivec2              &tile_shape,
+                                     const hmap::ComputeMode       &cm,
+                                     RegionTileCache               *p_cache);
+
+// =====================================
+// RegionTileCache
+// =====================================
+
+RegionTileCache::RegionTileCache(size_t max_bytes) : max_bytes(max_bytes) {}
+
+void RegionTileCache::clear()
+{
+  this->entries.clear();
+  this->nbytes = 0;
+}
+
+const hmap::Array *RegionTileCache::get(const glm::ivec2 &tile_index, glm::ivec2 &ij0)
+{
+  auto it = this->entries.find({tile_index.x, tile_index.y});
+  if (it == this->entries.end())
+    return nullptr;
+
+  it->second.last_use = ++this->counter;
+  ij0 = it->second.ij0;
+  return &it->second.interior;
+}
+
+void RegionTileCache::store(const glm::ivec2 &tile_index,
+                            const glm::ivec2 &ij0,
+                            hmap::Array     &&interior)
+{
+  Entry &entry = this->entries[{tile_index.x, tile_index.y}];
+
+  this->nbytes -= entry.interior.vector.size() * sizeof(float);
+  this->nbytes += interior.vector.size() * sizeof(float);
+
+  entry.ij0 = ij0;
+  entry.interior = std::move(interior);
+  entry.last_use = ++this->counter;
+
+  // the latest tile is kept anyway
+  while (this->nbytes > this->max_bytes && this->entries.size() > 1)
+  {
+    auto lru = std::min_element(this->entries.begin(),
+                                this->entries.end(),
+                                [](const auto &a, const auto &b)
+                                { return a.second.last_use < b.second.last_use; });
+
+    this->nbytes -= lru->second.interior.vector.size() * sizeof(float);
+    this->entries.erase(lru);
+  }
+}
+
+// =====================================
+// Queries
+// =====================================
+
+hmap::Array query_region(hmap::VirtualArray      &array,
+                         const glm::ivec2        &ij0,
+                         const glm::ivec2        &window_shape,
+                         const glm::ivec2        &shape_out,
+                         const glm::ivec2        &tile_shape,
+                         const hmap::ComputeMode &cm,
+                         RegionTileCache         *p_cache)
+{
+  std::vector<glm::ivec2> cells;
+  add_window_cells(array.shape, ij0, window_shape, shape_out, cells);
+
+  return get_window(read_cells(array, cells, tile_shape, cm, p_cache), 0, shape_out);
+}
+
+std::vector<float> query_profile(hmap::VirtualArray      &array,
+                                 const glm::vec2         &p0,
+                                 const glm::vec2         &p1,
+                                 int                      nsamples,
+                                 const glm::ivec2        &tile_shape,
+                                 const hmap::ComputeMode &cm,
+                                 RegionTileCache         *p_cache)
+{
+  std::vector<glm::ivec2> cells;
+  std::vector<float>      weights;
+  add_profile_cells(array.shape, p0, p1, nsamples, cells, weights);
+
+  return get_samples(read_cells(array, cells, tile_shape, cm, p_cache), weights);
+}
+
+float query_value(hmap::VirtualArray      &array,
+                  const glm::vec2         &p,
+                  const glm::ivec2        &tile_shape,
+                  const hmap::ComputeMode &cm,
+                  RegionTileCache         *p_cache)
+{
+  return query_profile(array, p, p, 1, tile_shape, cm, p_cache).front();
+}
+
+void query_probe(hmap::VirtualArray      &array,
+                 RegionProbe             &probe,
+                 const glm::ivec2        &tile_shape,
+                 const hmap::ComputeMode &cm,
+                 RegionTileCache         *p_cache)
+{
+  const glm::ivec2 shape = array.shape;
+
+  // value and profile stencils first, then the window cells
+  std::vector<glm::ivec2> cells;
+  std::vector<float>      weights;
+
+  add_profile_cells(shape, probe.p, probe.p, 1, cells, weights);
+  add_profile_cells(shape, probe.p0, probe.p1, probe.nsamples, cells, weights);
+
+  const bool has_window = probe.window_shape.x > 0 && probe.window_shape.y > 0;
+
+  if (has_window)
+  {
+    // cells covered by the bounding box, both ends included
+    const glm::vec4 &bbox = probe.bbox;
+    const glm::ivec2 ij0 = {int(std::lround(bbox.x * float(shape.x - 1))),
+                            int(std::lround(bbox.z * float(shape.y - 1)))};
+    const glm::ivec2 ij1 = {int(std::lround(bbox.y * float(shape.x - 1))) + 1,
+                            int(std::lround(bbox.w * float(shape.y - 1))) + 1};
+
+    add_window_cells(shape, ij0, ij1 - ij0, probe.window_shape, cells);
+  }
+
+  const std::vector<float> values = read_cells(array, cells, tile_shape, cm, p_cache);
+  const std::vector<float> samples = get_samples(values, weights);
+
+  probe.value = samples.front();
+  probe.profile.assign(samples.begin() + 1, samples.end());
+  probe.window = has_window ? get_window(values, weights.size(), probe.window_shape)
+                            : hmap::Array();
+}
+
+// --- helper(s)
+
+void add_profile_cells(const glm::ivec2        &shape,
+                       const glm::vec2         &p0,
+                       const glm::vec2         &p1,
+                       int                      nsamples,
+                       std::vector<glm::ivec2> &cells,
+                       std::vector<float>      &weights)
+{
+  // bilinear stencil of each sample, cells with no contribution are not read
+  for (int k = 0; k < nsamples; ++k)
+  {
+    if (shape.x < 1 || shape.y < 1)
+    {
+      cells.insert(cells.end(), 4, glm::ivec2(-1));
+      weights.insert(weights.end(), 4, 0.f);
+      continue;
+    }
+
+    const float     t = nsamples > 1 ? float(k) / float(nsamples - 1) : 0.f;
+    const glm::vec2 p = glm::clamp(p0 + t * (p1 - p0), glm::vec2(0.f), glm::vec2(1.f));
+    const glm::vec2 xy = p * glm::vec2(shape - 1);
+
+    const glm::ivec2 ij0 = glm::clamp(glm::ivec2(glm::floor(xy)),
+                                      glm::ivec2(0),
+                                      glm::max(shape - 2, glm::ivec2(0)));
+    const glm::ivec2 ij1 = glm::min(ij0 + 1, shape - 1);
+    const glm::vec2  uv = glm::clamp(xy - glm::vec2(ij0), glm::vec2(0.f), glm::vec2(1.f));
+
+    for (int c = 0; c < 4; ++c)
+    {
+      const int   i = (c & 1) ? ij1.x : ij0.x;
+      const int   j = (c & 2) ? ij1.y : ij0.y;
+      const float w = ((c & 1) ? uv.x : 1.f - uv.x) * ((c & 2) ? uv.y : 1.f - uv.y);
+
+      cells.push_back(w > 0.f ? glm::ivec2(i, j) : glm::ivec2(-1));
+      weights.push_back(w);
+    }
+  }
+}
+
+void add_window_cells(const glm::ivec2        &shape,
+                      const glm::ivec2        &ij0,
+                      const glm::ivec2        &window_shape,
+                      const glm::ivec2        &shape_out,
+                      std::vector<glm::ivec2> &cells)
+{
+  const glm::ivec2 n = glm::max(shape_out, glm::ivec2(1));
+
+  // window clamped to the heightmap, nothing is read if it is empty
+  const glm::ivec2 w0 = glm::max(ij0, glm::ivec2(0));
+  const glm::ivec2 w1 = glm::min(ij0 + window_shape, shape);
+
+  if (w1.x <= w0.x || w1.y <= w0.y)
+  {
+    cells.insert(cells.end(), size_t(n.x) * size_t(n.y), glm::ivec2(-1));
+    return;
+  }
+
+  // source index of each output cell
+  auto sample_index = [](int i0, int i1, int n, int k)
+  {
+    return n > 1 ? i0 + int(std::lround(float(k) * float(i1 - 1 - i0) / float(n - 1)))
+                 : i0;
+  };
+
+  for (int i = 0; i < n.x; ++i)
+    for (int j = 0; j < n.y; ++j)
+      cells.push_back(
+          {sample_index(w0.x, w1.x, n.x, i), sample_index(w0.y, w1.y, n.y, j)});
+}
+
+std::vector<float> get_samples(const std::vector<float> &values,
+                               const std::vector<float> &weights)
+{
+  std::vector<float> samples(weights.size() / 4, 0.f);
+
+  for (size_t k = 0; k < weights.size(); ++k)
+    samples[k / 4] += weights[k] * values[k];
+
+  return samples;
+}
+
+hmap::Array get_window(const std::vector<float> &values,
+                       size_t                    offset,
+                       const glm::ivec2         &shape_out)
+{
+  hmap::Array out(glm::max(shape_out, glm::ivec2(1)));
+
+  for (int i = 0; i < out.shape.x; ++i)
+    for (int j = 0; j < out.shape.y; ++j)
+      out(i, j) = values[offset + size_t(i) * size_t(out.shape.y) + size_t(j)];
+
+  return out;
+}
+
+std::vector<float> read_cells(hmap::VirtualArray            &array,
+                              const std::vector<glm::ivec2> &cells,
+                              const glm::ivec2              &tile_shape,
+                              const hmap::ComputeMode       &cm,
+                              RegionTileCache               *p_cache)
+{
+  const glm::ivec2   shape = array.shape;
+  const glm::ivec2   ts = glm::max(tile_shape, glm::ivec2(1));
+  std::vector<float> values(cells.size(), 0.f);
+
+  // cells grouped by owning tile, from the tile grid only. Cells out of the heightmap
+  // (e.g. (-1, -1)) are not read and left to 0
+  std::map<std::pair<int, int>, std::vector<size_t>> tile_cells;
+
+  for (size_t k = 0; k < cells.size(); ++k)
+  {
+    const glm::ivec2 &ij = cells[k];
+
+    if (ij.x >= 0 && ij.y >= 0 && ij.x < shape.x && ij.y < shape.y)
+      tile_cells[{ij.x / ts.x, ij.y / ts.y}].push_back(k);
+  }
+
+  const size_t nselected = tile_cells.size();
+
+  // cached tiles first, only the missing ones go through the tiles
+  if (p_cache)
+    for (auto it = tile_cells.begin(); it != tile_cells.end();)
+    {
+      glm::ivec2         ij0;
+      const hmap::Array *p_interior = p_cache->get({it->first.first, it->first.second},
+                                                   ij0);
+      if (!p_interior)
+      {
+        ++it;
+        continue;
+      }
+
+      for (size_t k : it->second)
+        values[k] = (*p_interior)(cells[k].x - ij0.x, cells[k].y - ij0.y);
+
+      it = tile_cells.erase(it);
+    }
+
+  if (tile_cells.empty())
+    return values;
+
+  // tile layout expected by get_tile_interior
+  hmap::ComputeMode cm_tiles = cm;
+  cm_tiles.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+
+  std::mutex                                                   mutex;
+  std::vector<std::tuple<glm::ivec2, glm::ivec2, hmap::Array>> interiors;
+
+  hmap::for_each_tile(
+      {&array},
+      [&](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
+      {
+        const TileInterior interior = get_tile_interior(region, shape, ts);
+        const glm::ivec2  &tile_ij0 = interior.ij0;
+        const glm::ivec2  &a = interior.a;
+        const glm::ivec2  &b = interior.b;
+
+        // the tiles that were not selected are left untouched
+        auto it = tile_cells.find({interior.tile_index.x, interior.tile_index.y});
+        if (it == tile_cells.end() || b.x <= a.x || b.y <= a.y)
+          return;
+
+        const hmap::Array &tile = *p_arrays[0];
+
+        // each cell is owned by a single tile, no synchronization needed
+        for (size_t k : it->second)
+        {
+          const glm::ivec2 &ij = cells[k];
+
+          if (ij.x >= a.x && ij.x < b.x && ij.y >= a.y && ij.y < b.y)
+            values[k] = tile(ij.x - tile_ij0.x, ij.y - tile_ij0.y);
+        }
+
+        if (!p_cache)
+          return;
+
+        hmap::Array copy(b - a);
+
+        for (int i = a.x; i < b.x; ++i)
+          for (int j = a.y; j < b.y; ++j)
+            copy(i - a.x, j - a.y) = tile(i - tile_ij0.x, j - tile_ij0.y);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        interiors.emplace_back(interior.tile_index, a, std::move(copy));
+      },
+      cm_tiles);
+
+  if (p_cache)
+    for (auto &[tile_index, ij0, copy] : interiors)
+      p_cache->store(tile_index, ij0, std::move(copy));
+
+  Logger::log()->trace("read_cells: {} cell(s), {} selected tile(s), {} read",
+                       cells.size(),
+                       nselected,
+                       tile_cells.size());
+
+  return values;
+}
+
+} // namespace hesiod
@@ -2,7 +2,6 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #include "highmap/operator.hpp"
-#include "highmap/virtual_array/virtual_array.hpp"
 
 #include "attributes.hpp"
 
@@ -25,31 +24,24 @@ void setup_histogram_for_range_attribute(BaseNode          &node,
   {
     std::pair<std::vector<float>, std::vector<float>> hist;
 
-    hmap::VirtualArray *p_in = node.get_value_ref<hmap::VirtualArray>(port_id);
+    // value range and reduced heightmap computed once per upstream update
+    auto sp_pyramid = node.get_preview_pyramid(node.get_port_index(port_id));
 
-    if (p_in)
+    if (sp_pyramid)
     {
-      float vmin = p_in->min(node.cfg().cm_cpu);
-      float vmax = p_in->max(node.cfg().cm_cpu);
+      float vmin = sp_pyramid->get_min();
+      float vmax = sp_pyramid->get_max();
 
       if (vmin != vmax)
       {
-        int   nbins = p_in->shape.x;
-        float a = 1.f / (vmax - vmin) * (float)(nbins - 1);
-        float b = -vmin / (vmax - vmin) * (float)(nbins - 1);
-
-        hmap::Array array = p_in->to_array({256, 256}, node.cfg().cm_cpu);
+        int nbins = sp_pyramid->get_source_shape().x;
 
         // values
         bool endpoint = false;
         hist.first = hmap::linspace(vmin, vmax, nbins, endpoint);
 
         // cumul
-        hist.second.resize(nbins);
-
-        for (int j = 0; j < array.shape.y; j++)
-          for (int i = 0; i < array.shape.x; i++)
-            hist.second[(int)(a * array(i, j) + b)] += 1;
+        hist.second = sp_pyramid->get_histogram(nbins);
       }
     }
 
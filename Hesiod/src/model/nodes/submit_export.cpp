@@ -0,0 +1,82 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <format>
+
+#include "hesiod/app/hesiod_application.hpp"
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/nodes/post_process.hpp"
+
+namespace hesiod
+{
+
+static ExportQueue &get_export_queue(BaseNode &node);
+static bool         is_async_export(BaseNode &node);
+
+std::shared_ptr<hmap::VirtualArray> snapshot_heightmap(BaseNode                 &node,
+                                                       const hmap::VirtualArray &array)
+{
+  // synchronous export, the input outlives the task
+  if (!is_async_export(node))
+    return std::shared_ptr<hmap::VirtualArray>(
+        const_cast<hmap::VirtualArray *>(&array),
+        [](hmap::VirtualArray *) {});
+
+  auto sp_copy = std::make_shared<hmap::VirtualArray>(CONFIG(node));
+  sp_copy->copy_from(array, node.cfg().cm_cpu);
+  return sp_copy;
+}
+
+std::shared_ptr<hmap::VirtualTexture> snapshot_texture(
+    BaseNode                   &node,
+    const hmap::VirtualTexture &texture)
+{
+  if (!is_async_export(node))
+    return std::shared_ptr<hmap::VirtualTexture>(
+        const_cast<hmap::VirtualTexture *>(&texture),
+        [](hmap::VirtualTexture *) {});
+
+  auto sp_copy = std::make_shared<hmap::VirtualTexture>(CONFIG_TEX(node));
+  sp_copy->copy_from(texture, node.cfg().cm_cpu);
+  return sp_copy;
+}
+
+void submit_export(BaseNode                    &node,
+                   const std::filesystem::path &fname,
+                   std::function<bool()>        task)
+{
+  const std::string label = std::format("{}/{}: {}",
+                                        node.get_label(),
+                                        node.get_id(),
+                                        fname.string());
+
+  ExportQueue &export_queue = get_export_queue(node);
+
+  // synchronous exports also go through the queue report
+  if (!is_async_export(node))
+  {
+    export_queue.run(label, task);
+    return;
+  }
+
+  std::error_code ec;
+  export_queue.submit(std::filesystem::absolute(fname, ec).string(),
+                      label,
+                      std::move(task));
+}
+
+// --- helper(s)
+
+ExportQueue &get_export_queue(BaseNode &node)
+{
+  return node.get_export_queue ? node.get_export_queue() : HSD_CTX.export_queue;
+}
+
+bool is_async_export(BaseNode &node)
+{
+  return HSD_CTX.app_settings.model.enable_async_export &&
+         !get_export_queue(node).is_synchronous();
+}
+
+} // namespace hesiod
@@ -0,0 +1,201 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <mutex>
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/nodes/tile_dirty_tracker.hpp"
+#include "hesiod/model/utils.hpp"
+
+namespace hesiod
+{
+
+void TileDirtyTracker::begin_update(BaseNode &node, uint64_t new_parameters_hash)
+{
+  this->partial_update = false;
+  this->dirty_tiles.clear();
+
+  if (node.get_tile_dependency() == TileDependency::TDP_GLOBAL)
+    return;
+
+  // a partial update requires valid outputs computed with the same parameters
+  bool eligible = new_parameters_hash == this->parameters_hash &&
+                  !this->output_hashes.empty();
+
+  this->parameters_hash = new_parameters_hash;
+
+  // compare the current input tiles with the ones consumed last time
+  std::map<int, TileHashes> current_hashes;
+
+  for (int k = 0; k < node.get_nports(); k++)
+  {
+    if (node.get_port_type(k) == gngui::PortType::OUT || !node.get_data_ref(k))
+      continue;
+
+    const TileHashes *p_hashes = node.get_upstream_tile_hashes
+                                     ? node.get_upstream_tile_hashes(k)
+                                     : nullptr;
+
+    // not a heightmap or unknown upstream state
+    if (!p_hashes)
+    {
+      eligible = false;
+      continue;
+    }
+
+    current_hashes[k] = *p_hashes;
+
+    auto it = this->input_hashes.find(k);
+    if (it == this->input_hashes.end())
+    {
+      eligible = false;
+      continue;
+    }
+
+    for (const auto &[key, hash] : *p_hashes)
+    {
+      auto it_prev = it->second.find(key);
+      if (it_prev == it->second.end() || it_prev->second != hash)
+        this->dirty_tiles.insert(key);
+    }
+
+    // tiling changed
+    if (it->second.size() != p_hashes->size())
+      eligible = false;
+  }
+
+  // inputs connected or disconnected
+  if (current_hashes.size() != this->input_hashes.size())
+    eligible = false;
+
+  this->input_hashes = std::move(current_hashes);
+  this->partial_update = eligible;
+
+  if (this->partial_update)
+  {
+    if (node.get_tile_dependency() == TileDependency::TDP_HALO)
+      this->dilate_dirty_tiles();
+
+    Logger::log()->trace("TileDirtyTracker::begin_update: [{}]/[{}], {} dirty tile(s)",
+                         node.get_node_type(),
+                         node.get_id(),
+                         this->dirty_tiles.size());
+  }
+}
+
+void TileDirtyTracker::dilate_dirty_tiles()
+{
+  // tiles sharing an edge or a corner with a dirty tile (extents are contiguous in
+  // unit square coordinates)
+  const float      eps = 1e-5f;
+  std::set<size_t> dilated = this->dirty_tiles;
+
+  for (size_t key : this->dirty_tiles)
+  {
+    auto it = this->tile_bboxes.find(key);
+    if (it == this->tile_bboxes.end())
+      continue;
+
+    const glm::vec4 &a = it->second;
+
+    for (const auto &[other_key, b] : this->tile_bboxes)
+      if (a.x <= b.y + eps && b.x <= a.y + eps && a.z <= b.w + eps && b.z <= a.w + eps)
+        dilated.insert(other_key);
+  }
+
+  this->dirty_tiles = std::move(dilated);
+}
+
+void TileDirtyTracker::disable_partial_update() { this->partial_update = false; }
+
+void TileDirtyTracker::end_update(BaseNode &node, bool completed)
+{
+  // interrupted update, the outputs cannot be trusted anymore
+  if (!completed)
+  {
+    this->reset();
+    return;
+  }
+
+  this->output_hashes.clear();
+  this->tile_bboxes.clear();
+
+  std::mutex mutex;
+
+  for (int k = 0; k < node.get_nports(); k++)
+  {
+    if (node.get_port_type(k) == gngui::PortType::IN ||
+        node.get_data_type(k) != typeid(hmap::VirtualArray).name())
+      continue;
+
+    hmap::VirtualArray *p_out = node.get_value_ref<hmap::VirtualArray>(k);
+    if (!p_out)
+      continue;
+
+    TileHashes &hashes = this->output_hashes[k];
+
+    hmap::for_each_tile(
+        {p_out},
+        [this, &hashes, &mutex](std::vector<hmap::Array *> p_arrays,
+                                const hmap::TileRegion    &region)
+        {
+          const std::vector<float> &v = p_arrays[0]->vector;
+          uint64_t hash = hash_data(v.data(), v.size() * sizeof(float));
+
+          std::lock_guard<std::mutex> lock(mutex);
+          hashes[region.key.hash()] = hash;
+          this->tile_bboxes[region.key.hash()] = region.bbox;
+        },
+        node.cfg().cm_cpu);
+  }
+}
+
+const TileHashes *TileDirtyTracker::get_output_tile_hashes(int port_index) const
+{
+  auto it = this->output_hashes.find(port_index);
+  return it == this->output_hashes.end() ? nullptr : &it->second;
+}
+
+size_t TileDirtyTracker::get_ndirty_tiles() const { return this->dirty_tiles.size(); }
+
+TileHashes TileDirtyTracker::get_tile_hashes(hmap::VirtualArray      &array,
+                                             const hmap::ComputeMode &cm)
+{
+  TileHashes hashes;
+  std::mutex mutex;
+
+  hmap::for_each_tile(
+      {&array},
+      [&hashes, &mutex](std::vector<hmap::Array *> p_arrays,
+                        const hmap::TileRegion    &region)
+      {
+        const std::vector<float> &v = p_arrays[0]->vector;
+        uint64_t hash = hash_data(v.data(), v.size() * sizeof(float));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        hashes[region.key.hash()] = hash;
+      },
+      cm);
+
+  return hashes;
+}
+
+bool TileDirtyTracker::is_partial_update() const { return this->partial_update; }
+
+bool TileDirtyTracker::is_tile_dirty(const hmap::TileRegion &region) const
+{
+  return !this->partial_update || this->dirty_tiles.contains(region.key.hash());
+}
+
+void TileDirtyTracker::reset()
+{
+  this->input_hashes.clear();
+  this->output_hashes.clear();
+  this->tile_bboxes.clear();
+  this->dirty_tiles.clear();
+  this->partial_update = false;
+  this->parameters_hash = 0;
+}
+
+} // namespace hesiod
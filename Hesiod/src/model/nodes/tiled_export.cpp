@@ -0,0 +1,37 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include "attributes.hpp"
+
+#include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/nodes/post_process.hpp"
+
+using namespace attr;
+
+namespace hesiod
+{
+
+TiledExportLayout get_tiled_export_layout(BaseNode &node)
+{
+  TiledExportLayout layout;
+
+  layout.tiling = {node.get_attr<IntAttribute>("tiling.x"),
+                   node.get_attr<IntAttribute>("tiling.y")};
+  layout.leading_zeros = node.get_attr<IntAttribute>("leading_zeros");
+  layout.overlapping_edges = node.get_attr<BoolAttribute>("overlapping_edges");
+  layout.reverse_tile_y_indexing = node.get_attr<BoolAttribute>(
+      "reverse_tile_y_indexing");
+
+  return layout;
+}
+
+void setup_tiled_export_attributes(BaseNode &node)
+{
+  node.add_attr<IntAttribute>("tiling.x", "Nb. of Tiles (x)", 4, 1, INT_MAX);
+  node.add_attr<IntAttribute>("tiling.y", "Nb. of Tiles (y)", 4, 1, INT_MAX);
+  node.add_attr<IntAttribute>("leading_zeros", "Leading Zeroes", 3, 1, 6);
+  node.add_attr<BoolAttribute>("overlapping_edges", "Overlapping Edges", false);
+  node.add_attr<BoolAttribute>("reverse_tile_y_indexing", "Reverse y-indexing", false);
+}
+
+} // namespace hesiod
@@ -0,0 +1,390 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "hesiod/app/hesiod_application.hpp"
+#include "hesiod/logger.hpp"
+#include "hesiod/model/nodes/base_node.hpp"
+#include "hesiod/model/profiler.hpp"
+
+namespace hesiod
+{
+
+static thread_local int64_t post_process_time = 0; // us
+
+// tracks not bound to a thread, far above any thread index
+static const size_t track_tid_broadcast = 100000;
+static const size_t track_tid_export = 100001;
+
+// --- helpers
+
+static bool write_json(const nlohmann::json &json, const std::filesystem::path &fname)
+{
+  std::ofstream file(fname);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("Profiler: cannot write file {}", fname.string());
+    return false;
+  }
+
+  file << json.dump(2) << std::endl;
+  return true;
+}
+
+static size_t read_proc_kb(const std::string &fname, const std::string &key)
+{
+#if defined(__linux__)
+  std::ifstream file(fname);
+  std::string   line;
+
+  while (std::getline(file, line))
+    if (line.starts_with(key + ":"))
+    {
+      std::istringstream iss(line.substr(key.size() + 1));
+      size_t             value = 0;
+      iss >> value;
+      return value * 1024;
+    }
+#else
+  (void)fname;
+  (void)key;
+#endif
+
+  return 0;
+}
+
+size_t get_available_memory() { return read_proc_kb("/proc/meminfo", "MemAvailable"); }
+
+size_t get_process_rss() { return read_proc_kb("/proc/self/status", "VmRSS"); }
+
+size_t get_process_peak_rss() { return read_proc_kb("/proc/self/status", "VmHWM"); }
+
+int64_t get_thread_cpu_time()
+{
+#if defined(__linux__) || defined(__APPLE__)
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return int64_t(ts.tv_sec) * 1000000000 + int64_t(ts.tv_nsec);
+#endif
+
+  return 0;
+}
+
+// --- Profiler
+
+Profiler::Profiler() : origin(std::chrono::steady_clock::now()) {}
+
+void Profiler::add_post_process_time(int64_t duration_us)
+{
+  post_process_time += duration_us;
+}
+
+void Profiler::add_event(const TraceEvent &event)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->events.push_back(event);
+
+  while (this->events.size() > this->max_events)
+    this->events.pop_front();
+}
+
+void Profiler::add_record(const ProfileRecord &record)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->records.push_back(record);
+
+  while (this->records.size() > this->max_records)
+    this->records.pop_front();
+}
+
+void Profiler::clear()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->records.clear();
+  this->events.clear();
+  this->origin = std::chrono::steady_clock::now();
+}
+
+bool Profiler::export_chrome_trace(const std::filesystem::path &fname) const
+{
+  Logger::log()->trace("Profiler::export_chrome_trace: {}", fname.string());
+  return write_json(this->get_chrome_trace(), fname);
+}
+
+bool Profiler::export_report(const std::filesystem::path &fname) const
+{
+  Logger::log()->trace("Profiler::export_report: {}", fname.string());
+  return write_json(this->get_report(), fname);
+}
+
+nlohmann::json Profiler::get_chrome_trace() const
+{
+  nlohmann::json   events = nlohmann::json::array();
+  std::set<size_t> tids;
+
+  // node evaluations
+  for (const auto &r : this->get_records())
+  {
+    nlohmann::json e;
+    e["name"] = r.node_type;
+    e["cat"] = "node";
+    e["ph"] = "X";
+    e["ts"] = r.t_start;
+    e["dur"] = r.duration;
+    e["pid"] = 1;
+    e["tid"] = r.thread_id;
+    e["args"] = {{"id", r.node_id},
+                 {"post_process_us", r.post_process_duration},
+                 {"tiles", r.ntiles},
+                 {"rss_delta_bytes", r.rss_delta},
+                 {"peak_rss_delta_bytes", r.peak_rss_delta},
+                 {"cpu_utilization", r.cpu_utilization}};
+    events.push_back(e);
+    tids.insert(r.thread_id);
+  }
+
+  // tiles, broadcasts, exports...
+  for (const auto &ev : this->get_events())
+  {
+    nlohmann::json e;
+    e["name"] = ev.name;
+    e["cat"] = ev.category;
+    e["ph"] = "X";
+    e["ts"] = ev.t_start;
+    e["dur"] = ev.duration;
+    e["pid"] = 1;
+    e["tid"] = ev.tid;
+    e["args"] = ev.args;
+    events.push_back(e);
+    tids.insert(ev.tid);
+  }
+
+  // track names
+  events.push_back({{"name", "process_name"},
+                    {"ph", "M"},
+                    {"pid", 1},
+                    {"args", {{"name", "Hesiod"}}}});
+
+  for (size_t tid : tids)
+  {
+    std::string name = "thread " + std::to_string(tid);
+
+    if (tid == track_tid_broadcast)
+      name = "broadcast";
+    else if (tid == track_tid_export)
+      name = "export";
+
+    events.push_back({{"name", "thread_name"},
+                      {"ph", "M"},
+                      {"pid", 1},
+                      {"tid", tid},
+                      {"args", {{"name", name}}}});
+  }
+
+  nlohmann::json json;
+  json["traceEvents"] = events;
+  json["displayTimeUnit"] = "ms";
+  return json;
+}
+
+std::vector<TraceEvent> Profiler::get_events() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return std::vector<TraceEvent>(this->events.begin(), this->events.end());
+}
+
+std::vector<ProfileRecord> Profiler::get_records() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return std::vector<ProfileRecord>(this->records.begin(), this->records.end());
+}
+
+nlohmann::json Profiler::get_report() const
+{
+  std::vector<ProfileRecord> all = this->get_records();
+
+  // --- evaluations
+
+  nlohmann::json evaluations = nlohmann::json::array();
+
+  for (const auto &r : all)
+  {
+    const int64_t compute_duration = r.duration - r.post_process_duration;
+
+    evaluations.push_back({{"id", r.node_id},
+                           {"type", r.node_type},
+                           {"start_ms", 1e-3 * r.t_start},
+                           {"wall_time_ms", 1e-3 * r.duration},
+                           {"compute_time_ms", 1e-3 * compute_duration},
+                           {"post_process_time_ms", 1e-3 * r.post_process_duration},
+                           {"tiles", r.ntiles},
+                           {"rss_delta_mb", double(r.rss_delta) / 1048576.0},
+                           {"peak_rss_delta_mb", double(r.peak_rss_delta) / 1048576.0},
+                           {"cpu_utilization", r.cpu_utilization}});
+  }
+
+  // --- summary per node type, most expensive first
+
+  struct Summary
+  {
+    size_t  count = 0;
+    int64_t duration = 0;
+    int64_t post_process_duration = 0;
+    int64_t max_duration = 0;
+    int64_t peak_rss_delta = 0;
+  };
+
+  std::map<std::string, Summary> summaries;
+
+  for (const auto &r : all)
+  {
+    Summary &s = summaries[r.node_type];
+    s.count++;
+    s.duration += r.duration;
+    s.post_process_duration += r.post_process_duration;
+    s.max_duration = std::max(s.max_duration, r.duration);
+    s.peak_rss_delta = std::max(s.peak_rss_delta, r.peak_rss_delta);
+  }
+
+  std::vector<std::pair<std::string, Summary>> sorted(summaries.begin(), summaries.end());
+  std::sort(sorted.begin(),
+            sorted.end(),
+            [](const auto &a, const auto &b)
+            { return a.second.duration > b.second.duration; });
+
+  nlohmann::json summary = nlohmann::json::array();
+
+  for (const auto &[type, s] : sorted)
+    summary.push_back({{"type", type},
+                       {"count", s.count},
+                       {"total_time_ms", 1e-3 * s.duration},
+                       {"mean_time_ms", 1e-3 * s.duration / double(s.count)},
+                       {"max_time_ms", 1e-3 * s.max_duration},
+                       {"post_process_time_ms", 1e-3 * s.post_process_duration},
+                       {"max_peak_rss_delta_mb", double(s.peak_rss_delta) / 1048576.0}});
+
+  nlohmann::json json;
+  json["summary"] = summary;
+  json["evaluations"] = evaluations;
+  return json;
+}
+
+int64_t Profiler::get_time(std::chrono::steady_clock::time_point t) const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return std::chrono::duration_cast<std::chrono::microseconds>(t - this->origin).count();
+}
+
+size_t Profiler::get_thread_index()
+{
+  static std::atomic<size_t> count = 0;
+  thread_local size_t        index = count++;
+  return index;
+}
+
+size_t Profiler::get_track_tid(TraceTrack track)
+{
+  switch (track)
+  {
+  case TraceTrack::TTR_BROADCAST: return track_tid_broadcast;
+  case TraceTrack::TTR_EXPORT: return track_tid_export;
+  default: return Profiler::get_thread_index();
+  }
+}
+
+int64_t Profiler::take_post_process_time()
+{
+  int64_t t = post_process_time;
+  post_process_time = 0;
+  return t;
+}
+
+// --- ProfileSpan
+
+ProfileSpan::ProfileSpan(const std::string &name,
+                         const std::string &category,
+                         TraceTrack         track,
+                         nlohmann::json     args)
+    : active(HSD_CTX.app_settings.model.enable_profiling)
+{
+  if (!this->active)
+    return;
+
+  this->event.name = name;
+  this->event.category = category;
+  this->event.tid = Profiler::get_track_tid(track);
+  this->event.args = std::move(args);
+  this->t0 = std::chrono::steady_clock::now();
+}
+
+ProfileSpan::~ProfileSpan()
+{
+  if (!this->active)
+    return;
+
+  Profiler &profiler = HSD_CTX.profiler;
+  auto      t1 = std::chrono::steady_clock::now();
+
+  this->event.t_start = profiler.get_time(this->t0);
+  this->event.duration = profiler.get_time(t1) - this->event.t_start;
+  profiler.add_event(this->event);
+}
+
+// --- TileSpan
+
+TileSpan::TileSpan(const BaseNode &node, const hmap::TileRegion &region)
+    : p_node(&node), cpu0(get_thread_cpu_time())
+{
+  node.add_computed_tile();
+
+  if (!HSD_CTX.app_settings.model.enable_profiling)
+    return;
+
+  this->recording = true;
+  this->key = region.key.hash();
+  this->t0 = std::chrono::steady_clock::now();
+}
+
+TileSpan::~TileSpan()
+{
+  this->p_node->add_tile_cpu_time(get_thread_cpu_time() - this->cpu0);
+
+  if (!this->recording)
+    return;
+
+  Profiler &profiler = HSD_CTX.profiler;
+  auto      t1 = std::chrono::steady_clock::now();
+
+  TraceEvent event;
+  event.name = this->p_node->get_node_type();
+  event.category = "tile";
+  event.t_start = profiler.get_time(this->t0);
+  event.duration = profiler.get_time(t1) - event.t_start;
+  event.tid = Profiler::get_thread_index();
+  event.args = {{"id", this->p_node->get_id()}, {"tile", this->key}};
+
+  profiler.add_event(event);
+}
+
+// --- PostProcessTimer
+
+PostProcessTimer::PostProcessTimer() : t0(std::chrono::steady_clock::now()) {}
+
+PostProcessTimer::~PostProcessTimer()
+{
+  auto t1 = std::chrono::steady_clock::now();
+  Profiler::add_post_process_time(
+      std::chrono::duration_cast<std::chrono::microseconds>(t1 - this->t0).count());
+}
+
+} // namespace hesiod
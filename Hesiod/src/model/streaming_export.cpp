@@ -0,0 +1,1074 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include <zlib.h>
+
+#include "highmap/gradient.hpp"
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/streaming_export.hpp"
+
+namespace hesiod
+{
+
+// --- helpers
+
+// minimal streaming PNG encoder (grayscale, RGB or RGBA, 8 or 16 bit, no filtering),
+// rows are compressed as they come
+class PngWriter
+{
+public:
+  ~PngWriter()
+  {
+    if (this->zs_initialized)
+      deflateEnd(&this->zs);
+  }
+
+  bool open(const std::string &fname,
+            const glm::ivec2  &shape,
+            int                new_bit_depth,
+            int                nchannels = 1)
+  {
+    // PNG color types: grayscale, RGB and RGBA
+    const std::map<int, uint8_t> color_types = {{1, 0}, {3, 2}, {4, 6}};
+
+    this->bit_depth = new_bit_depth;
+    this->file.open(fname, std::ios::binary);
+
+    if (!this->file.is_open())
+    {
+      Logger::log()->error("PngWriter::open: could not open file {}", fname);
+      return false;
+    }
+
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    this->file.write(reinterpret_cast<const char *>(signature), 8);
+
+    // IHDR: width, height, bit depth, color type, deflate, no filter, no interlace
+    std::vector<uint8_t> ihdr;
+    push_u32(ihdr, static_cast<uint32_t>(shape.x));
+    push_u32(ihdr, static_cast<uint32_t>(shape.y));
+    ihdr.insert(ihdr.end(),
+                {uint8_t(this->bit_depth), color_types.at(nchannels), 0, 0, 0});
+    this->write_chunk("IHDR", ihdr.data(), ihdr.size());
+
+    std::memset(&this->zs, 0, sizeof(this->zs));
+    if (deflateInit(&this->zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+      return false;
+
+    this->zs_initialized = true;
+    this->out_buffer.resize(1 << 20);
+
+    return this->file.good();
+  }
+
+  // normalized values in [0, 1], channels interleaved
+  bool write_row(const std::vector<float> &values)
+  {
+    this->row_buffer.clear();
+    this->append_row(values, this->row_buffer);
+
+    this->zs.next_in = this->row_buffer.data();
+    this->zs.avail_in = static_cast<uInt>(this->row_buffer.size());
+
+    return this->deflate_pending(Z_NO_FLUSH);
+  }
+
+  // run of rows compressed on its own (raw deflate, sync flushed, no history), so that
+  // segments can be encoded concurrently and in any order. They are then appended in
+  // image order with 'write_segment', instead of 'write_row'
+  struct Segment
+  {
+    std::vector<uint8_t> data;
+    uLong                adler = 1; // of the uncompressed rows
+    size_t               nbytes_raw = 0;
+  };
+
+  using RowGetter = std::function<void(int row_index, std::vector<float> &row)>;
+
+  bool encode_segment(int nrows, const RowGetter &get_row, Segment &segment) const
+  {
+    std::vector<uint8_t> raw;
+    std::vector<float>   row;
+
+    for (int r = 0; r < nrows; ++r)
+    {
+      get_row(r, row);
+      this->append_row(row, raw);
+    }
+
+    z_stream zs_segment;
+    std::memset(&zs_segment, 0, sizeof(zs_segment));
+
+    // raw deflate (negative window bits), the zlib header is written once by the writer
+    if (deflateInit2(&zs_segment,
+                     Z_DEFAULT_COMPRESSION,
+                     Z_DEFLATED,
+                     -15,
+                     8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+      return false;
+
+    segment.data.resize(deflateBound(&zs_segment, uLong(raw.size())) + 16);
+    zs_segment.next_in = raw.data();
+    zs_segment.avail_in = static_cast<uInt>(raw.size());
+    zs_segment.next_out = segment.data.data();
+    zs_segment.avail_out = static_cast<uInt>(segment.data.size());
+
+    int ret = deflate(&zs_segment, Z_SYNC_FLUSH);
+
+    segment.data.resize(segment.data.size() - zs_segment.avail_out);
+    segment.adler = adler32(adler32(0L, Z_NULL, 0), raw.data(), uInt(raw.size()));
+    segment.nbytes_raw = raw.size();
+    deflateEnd(&zs_segment);
+
+    return ret == Z_OK && zs_segment.avail_in == 0;
+  }
+
+  bool write_segment(const Segment &segment)
+  {
+    // zlib header (deflate, 32K window, default compression) before the first segment
+    if (!this->is_segmented)
+    {
+      const uint8_t header[2] = {0x78, 0x9c};
+      this->write_chunk("IDAT", header, 2);
+      this->is_segmented = true;
+      this->adler = adler32(0L, Z_NULL, 0);
+    }
+
+    if (!segment.data.empty())
+      this->write_chunk("IDAT", segment.data.data(), segment.data.size());
+
+    this->adler = adler32_combine(this->adler,
+                                  segment.adler,
+                                  static_cast<z_off_t>(segment.nbytes_raw));
+
+    return this->file.good();
+  }
+
+  bool close()
+  {
+    if (this->is_segmented)
+    {
+      // empty final block and checksum of the whole image
+      std::vector<uint8_t> trailer = {0x03, 0x00};
+      push_u32(trailer, static_cast<uint32_t>(this->adler));
+      this->write_chunk("IDAT", trailer.data(), trailer.size());
+    }
+    else if (!this->deflate_pending(Z_FINISH))
+      return false;
+
+    this->write_chunk("IEND", nullptr, 0);
+    this->file.close();
+
+    return !this->file.fail();
+  }
+
+private:
+  void append_row(const std::vector<float> &values, std::vector<uint8_t> &buffer) const
+  {
+    buffer.push_back(0); // filter type 'None'
+
+    for (float v : values)
+    {
+      v = std::clamp(v, 0.f, 1.f);
+
+      if (this->bit_depth == 8)
+        buffer.push_back(static_cast<uint8_t>(std::lround(v * 255.f)));
+      else
+      {
+        uint16_t u = static_cast<uint16_t>(std::lround(v * 65535.f));
+        buffer.push_back(static_cast<uint8_t>(u >> 8)); // big endian
+        buffer.push_back(static_cast<uint8_t>(u & 0xff));
+      }
+    }
+  }
+
+  static void push_u32(std::vector<uint8_t> &v, uint32_t x)
+  {
+    v.insert(v.end(),
+             {uint8_t(x >> 24), uint8_t((x >> 16) & 0xff), uint8_t((x >> 8) & 0xff),
+              uint8_t(x & 0xff)});
+  }
+
+  bool deflate_pending(int flush)
+  {
+    while (true)
+    {
+      this->zs.next_out = this->out_buffer.data();
+      this->zs.avail_out = static_cast<uInt>(this->out_buffer.size());
+
+      int ret = deflate(&this->zs, flush);
+
+      if (ret == Z_STREAM_ERROR)
+        return false;
+
+      size_t nbytes = this->out_buffer.size() - this->zs.avail_out;
+      if (nbytes)
+        this->write_chunk("IDAT", this->out_buffer.data(), nbytes);
+
+      bool done = flush == Z_FINISH ? ret == Z_STREAM_END
+                                    : (this->zs.avail_in == 0 && this->zs.avail_out != 0);
+      if (done)
+        return this->file.good();
+    }
+  }
+
+  void write_chunk(const char *type, const uint8_t *data, size_t size)
+  {
+    std::vector<uint8_t> header;
+    push_u32(header, static_cast<uint32_t>(size));
+    header.insert(header.end(), type, type + 4);
+
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef *>(type), 4);
+    if (size)
+      crc = crc32(crc, data, static_cast<uInt>(size));
+
+    std::vector<uint8_t> footer;
+    push_u32(footer, static_cast<uint32_t>(crc));
+
+    this->file.write(reinterpret_cast<const char *>(header.data()), header.size());
+    if (size)
+      this->file.write(reinterpret_cast<const char *>(data), size);
+    this->file.write(reinterpret_cast<const char *>(footer.data()), footer.size());
+  }
+
+  std::ofstream        file;
+  int                  bit_depth = 16;
+  z_stream             zs;
+  bool                 zs_initialized = false;
+  std::vector<uint8_t> row_buffer;
+  std::vector<uint8_t> out_buffer;
+  bool                 is_segmented = false;
+  uLong                adler = 1;
+};
+
+// horizontal bands of the heightmap, indexed from the image top (j = shape.y - 1)
+static std::vector<ExportBlock> get_row_bands(const glm::ivec2 &shape, int band_height)
+{
+  std::vector<ExportBlock> bands;
+
+  for (int j_hi = shape.y; j_hi > 0; j_hi -= band_height)
+  {
+    int j_lo = std::max(0, j_hi - band_height);
+    bands.push_back({glm::ivec2(0, j_lo), glm::ivec2(shape.x, j_hi - j_lo)});
+  }
+
+  return bands;
+}
+
+// row 'j' of a block, normalized
+static void get_block_row(const hmap::Array  &block,
+                          int                 j,
+                          float               vmin,
+                          float               scale,
+                          std::vector<float> &row)
+{
+  row.resize(block.shape.x);
+  for (int i = 0; i < block.shape.x; ++i)
+    row[i] = (block(i, j) - vmin) * scale;
+}
+
+static std::pair<float, float> get_normalization(hmap::VirtualArray      &array,
+                                                 const hmap::ComputeMode &cm)
+{
+  float vmin = array.min(cm);
+  float vmax = array.max(cm);
+  float scale = vmax > vmin ? 1.f / (vmax - vmin) : 0.f;
+  return {vmin, scale};
+}
+
+// encodes the output tile ('ij0', 'shape', relative to the block) of a block which may
+// be larger than the tile (margin)
+using TileEncoder = std::function<bool(const std::string              &fname_tile,
+                                       const std::vector<hmap::Array> &channels,
+                                       const glm::ivec2               &ij0,
+                                       const glm::ivec2               &shape)>;
+
+// writes the image rows of a tile, 'get_pixel' fills the channels of pixel (i, j)
+static bool write_png_tile(const std::string                           &fname_tile,
+                           const glm::ivec2                            &ij0,
+                           const glm::ivec2                            &shape,
+                           int                                          bit_depth,
+                           int                                          nchannels,
+                           const std::function<void(int, int, float *)> &get_pixel)
+{
+  PngWriter writer;
+  if (!writer.open(fname_tile, shape, bit_depth, nchannels))
+    return false;
+
+  std::vector<float> row(size_t(shape.x) * size_t(nchannels));
+
+  for (int j = ij0.y + shape.y - 1; j >= ij0.y; --j)
+  {
+    for (int i = 0; i < shape.x; ++i)
+      get_pixel(ij0.x + i, j, &row[size_t(i) * size_t(nchannels)]);
+
+    if (!writer.write_row(row))
+      return false;
+  }
+
+  return writer.close();
+}
+
+// common driver of the tiled writers: output tiles are gathered (plus 'margin' pixels
+// on each side when available) by the streaming pass and handed to the parallel writer
+static bool export_tiled_parallel(const std::vector<hmap::VirtualArray *> &arrays,
+                                  const glm::ivec2                        &tile_shape,
+                                  const std::string                       &fname,
+                                  const TiledExportLayout                 &layout,
+                                  int                                      margin,
+                                  const TileEncoder                       &encode,
+                                  const hmap::ComputeMode                 &cm)
+{
+  const glm::ivec2 shape = arrays.front()->shape;
+  const glm::ivec2 tiling = glm::max(layout.tiling, glm::ivec2(1));
+  const glm::ivec2 base_shape = shape / tiling;
+
+  // output tiles, overlapping tiles share their last row/column with the next tile
+  std::vector<ExportBlock> tiles;
+  std::vector<ExportBlock> blocks;
+  std::vector<std::string> fnames;
+
+  auto zfill = [&layout](int v)
+  {
+    std::string s = std::to_string(v);
+    return std::string(std::max(0, layout.leading_zeros - int(s.size())), '0') + s;
+  };
+
+  for (int ti = 0; ti < tiling.x; ++ti)
+    for (int tj = 0; tj < tiling.y; ++tj)
+    {
+      glm::ivec2 ij0 = {ti * base_shape.x, tj * base_shape.y};
+      glm::ivec2 ij1 = {ti == tiling.x - 1 ? shape.x : ij0.x + base_shape.x,
+                        tj == tiling.y - 1 ? shape.y : ij0.y + base_shape.y};
+
+      if (layout.overlapping_edges)
+        ij1 = glm::min(ij1 + 1, shape);
+
+      glm::ivec2 ij0_block = glm::max(ij0 - margin, glm::ivec2(0));
+      glm::ivec2 ij1_block = glm::min(ij1 + margin, shape);
+
+      int tj_file = layout.reverse_tile_y_indexing ? tiling.y - 1 - tj : tj;
+
+      tiles.push_back({ij0 - ij0_block, ij1 - ij0});
+      blocks.push_back({ij0_block, ij1_block - ij0_block});
+      fnames.push_back(std::format("{}_{}_{}.png", fname, zfill(ti), zfill(tj_file)));
+    }
+
+  ParallelTileWriter writer;
+
+  // the streaming pass waits when the writer queue is full, which also stops the tiles
+  // from being read ahead of the disk
+  auto write_block = [&](size_t k, std::vector<hmap::Array> &channels)
+  {
+    auto sp_channels = std::make_shared<std::vector<hmap::Array>>(std::move(channels));
+
+    writer.submit(
+        [&, k, sp_channels]()
+        {
+          Logger::log()->trace("export_tiled_parallel: writing {}", fnames[k]);
+          return encode(fnames[k], *sp_channels, tiles[k].ij0, tiles[k].shape);
+        });
+
+    return true;
+  };
+
+  bool ok = stream_export_blocks(arrays, tile_shape, blocks, write_block, cm);
+
+  return writer.wait() && ok;
+}
+
+// common driver of the single file PNG writers, channels interleaved
+static bool export_png_bands(const std::vector<hmap::VirtualArray *> &channels,
+                             const glm::ivec2                        &tile_shape,
+                             const std::string                       &fname,
+                             int                                      bit_depth,
+                             float                                    vmin,
+                             float                                    scale,
+                             const hmap::ComputeMode                 &cm)
+{
+  const glm::ivec2 shape = channels.front()->shape;
+  const size_t     nchannels = channels.size();
+
+  PngWriter writer;
+  if (!writer.open(fname, shape, bit_depth, int(nchannels)))
+    return false;
+
+  // the bands complete in tile order but are written from the image top: they are
+  // encoded as soon as they are complete and the encoded bands waiting for their turn
+  // are kept in memory up to 'max_pending', then moved to a spool file
+  using Segment = PngWriter::Segment;
+
+  const std::vector<ExportBlock> bands = get_row_bands(shape, tile_shape.y);
+  const std::string              fname_spool = fname + ".spool";
+  const size_t                   max_pending = 8;
+
+  std::map<size_t, Segment>                   pending;
+  std::map<size_t, std::pair<size_t, size_t>> spooled; // offset and size in the spool
+  std::fstream                                spool;
+  size_t                                      spool_size = 0;
+  size_t                                      next = 0;
+  std::mutex                                  mutex;
+  bool                                        ok = true;
+
+  auto spool_segment = [&](size_t k, Segment &segment) // lock must be held
+  {
+    if (!spool.is_open())
+      spool.open(fname_spool,
+                 std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+
+    spool.seekp(spool_size);
+    spool.write(reinterpret_cast<const char *>(segment.data.data()),
+                segment.data.size());
+
+    spooled[k] = {spool_size, segment.data.size()};
+    spool_size += segment.data.size();
+
+    segment.data.clear(); // checksum and raw size are kept
+    segment.data.shrink_to_fit();
+
+    return spool.good();
+  };
+
+  auto write_next = [&]() // lock must be held
+  {
+    for (; pending.contains(next); ++next)
+    {
+      Segment &segment = pending[next];
+
+      if (spooled.contains(next))
+      {
+        auto [offset, size] = spooled[next];
+        segment.data.resize(size);
+        spool.seekg(offset);
+        spool.read(reinterpret_cast<char *>(segment.data.data()), size);
+        ok = spool.good() && ok;
+        spooled.erase(next);
+      }
+
+      ok = writer.write_segment(segment) && ok;
+      pending.erase(next);
+    }
+  };
+
+  ParallelTileWriter encoder;
+
+  auto write_band = [&](size_t k, std::vector<hmap::Array> &band)
+  {
+    auto sp_band = std::make_shared<std::vector<hmap::Array>>(std::move(band));
+
+    encoder.submit(
+        [&, k, sp_band]()
+        {
+          Segment    segment;
+          const auto band_shape = sp_band->front().shape;
+
+          // image rows from the band top
+          auto get_row = [&](int r, std::vector<float> &row)
+          {
+            const int j = band_shape.y - 1 - r;
+
+            row.resize(size_t(band_shape.x) * nchannels);
+            for (int i = 0; i < band_shape.x; ++i)
+              for (size_t nch = 0; nch < nchannels; ++nch)
+                row[size_t(i) * nchannels + nch] = ((*sp_band)[nch](i, j) - vmin) * scale;
+          };
+
+          if (!writer.encode_segment(band_shape.y, get_row, segment))
+            return false;
+
+          std::lock_guard<std::mutex> lock(mutex);
+
+          size_t nmemory = pending.size() - spooled.size();
+          pending[k] = std::move(segment);
+
+          if (k != next && nmemory >= max_pending)
+            ok = spool_segment(k, pending[k]) && ok;
+
+          write_next();
+          return ok;
+        });
+
+    return true;
+  };
+
+  bool ok_stream = stream_export_blocks(channels, tile_shape, bands, write_band, cm);
+  bool ok_encode = encoder.wait();
+
+  if (spool.is_open())
+  {
+    spool.close();
+    std::error_code ec;
+    std::filesystem::remove(fname_spool, ec);
+  }
+
+  if (next != bands.size())
+  {
+    Logger::log()->error("export_png_streamed: {} band(s) missing", bands.size() - next);
+    ok = false;
+  }
+
+  return writer.close() && ok && ok_stream && ok_encode;
+}
+
+// =====================================
+// ParallelTileWriter
+// =====================================
+
+ParallelTileWriter::ParallelTileWriter(size_t nthreads, size_t max_in_flight)
+    : max_in_flight(max_in_flight), pool(nthreads)
+{
+  if (this->max_in_flight == 0)
+    this->max_in_flight = 2 * this->pool.get_nthreads();
+}
+
+void ParallelTileWriter::submit(std::function<bool()> task)
+{
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->cv.wait(lock, [this]() { return this->in_flight < this->max_in_flight; });
+    this->in_flight++;
+  }
+
+  this->pool.submit(
+      [this, task]()
+      {
+        bool success = false;
+
+        try
+        {
+          success = task();
+        }
+        catch (const std::exception &e)
+        {
+          Logger::log()->error("ParallelTileWriter: {}", e.what());
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->ok = this->ok && success;
+        this->in_flight--;
+        this->cv.notify_all();
+      });
+}
+
+bool ParallelTileWriter::wait()
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->cv.wait(lock, [this]() { return this->in_flight == 0; });
+  return this->ok;
+}
+
+// --- functions
+
+TileInterior get_tile_interior(const hmap::TileRegion &region,
+                               const glm::ivec2       &shape,
+                               const glm::ivec2       &tile_shape)
+{
+  TileInterior tile;
+
+  tile.ij0 = {int(std::lround(region.bbox.x * float(shape.x))),
+              int(std::lround(region.bbox.z * float(shape.y)))};
+  tile.tile_index = (tile.ij0 + region.shape / 2) / tile_shape;
+  tile.a = glm::max(tile.tile_index * tile_shape, tile.ij0);
+  tile.b = glm::min(glm::min(tile.a + tile_shape, shape), tile.ij0 + region.shape);
+
+  return tile;
+}
+
+hmap::Array downsample_2x(const hmap::Array &array)
+{
+  hmap::Array out(glm::ivec2((array.shape.x + 1) / 2, (array.shape.y + 1) / 2));
+
+  for (int i = 0; i < out.shape.x; ++i)
+    for (int j = 0; j < out.shape.y; ++j)
+    {
+      float sum = 0.f;
+      int   count = 0;
+
+      for (int p = 2 * i; p < std::min(2 * i + 2, array.shape.x); ++p)
+        for (int q = 2 * j; q < std::min(2 * j + 2, array.shape.y); ++q)
+        {
+          sum += array(p, q);
+          count++;
+        }
+
+      out(i, j) = sum / float(count);
+    }
+
+  return out;
+}
+
+bool export_lod_pyramid_streamed(const std::vector<hmap::VirtualArray *> &channels,
+                                 const glm::ivec2                        &tile_shape,
+                                 const std::filesystem::path             &dir,
+                                 int                                      chunk_size,
+                                 LodChunkFormat                           format,
+                                 float                                    vmin,
+                                 float                                    vmax,
+                                 const hmap::ComputeMode                 &cm)
+{
+  Logger::log()->trace("export_lod_pyramid_streamed: {}", dir.string());
+
+  // chunks are split in half at each level
+  chunk_size = std::max(2, chunk_size + chunk_size % 2);
+
+  const std::vector<LodLevel> levels = get_lod_pyramid_levels(channels.front()->shape,
+                                                              chunk_size);
+  const int                   nlevels = int(levels.size());
+  const int                   nchannels = int(channels.size());
+  const float                 scale = vmax > vmin ? 1.f / (vmax - vmin) : 0.f;
+
+  std::error_code ec;
+
+  for (int l = 0; l < nlevels; ++l)
+    std::filesystem::create_directories(dir / std::format("lod{}", l), ec);
+
+  auto write_chunk = [&](int                             l,
+                         const glm::ivec2               &c,
+                         const std::vector<hmap::Array> &arrays)
+  {
+    const glm::ivec2            shape = arrays.front().shape;
+    const bool                  raw = format == LodChunkFormat::RAW_FLOAT32;
+    const std::filesystem::path fname = dir / std::format("lod{}", l) /
+                                        std::format("{}_{}.{}",
+                                                    c.x,
+                                                    c.y,
+                                                    raw ? "raw" : "png");
+
+    if (!raw)
+      return write_png_tile(fname.string(),
+                            glm::ivec2(0),
+                            shape,
+                            format == LodChunkFormat::PNG_8BIT ? 8 : 16,
+                            nchannels,
+                            [&](int i, int j, float *px)
+                            {
+                              for (int nch = 0; nch < nchannels; ++nch)
+                                px[nch] = (arrays[nch](i, j) - vmin) * scale;
+                            });
+
+    std::ofstream      file(fname, std::ios::binary);
+    std::vector<float> row(size_t(shape.x) * size_t(nchannels));
+
+    for (int j = shape.y - 1; j >= 0; --j)
+    {
+      for (int i = 0; i < shape.x; ++i)
+        for (int nch = 0; nch < nchannels; ++nch)
+          row[size_t(i) * nchannels + nch] = arrays[nch](i, j);
+
+      file.write(reinterpret_cast<const char *>(row.data()), row.size() * sizeof(float));
+    }
+
+    return file.good();
+  };
+
+  // downsampled chunks waiting for their siblings, per level and parent chunk
+  struct PendingParent
+  {
+    std::vector<hmap::Array> quadrants[4]; // (0, 0), (1, 0), (0, 1), (1, 1)
+    int                      nreceived = 0;
+  };
+
+  std::vector<std::map<std::pair<int, int>, PendingParent>> pending(nlevels);
+  std::mutex                                                mutex;
+
+  // writes a chunk and goes up the quadtree as long as the parent chunks are complete,
+  // the thread completing a parent carries on with it
+  auto process_chunk = [&](glm::ivec2 c, std::vector<hmap::Array> arrays)
+  {
+    bool ok = true;
+
+    for (int l = 0; l < nlevels; ++l)
+    {
+      ok = write_chunk(l, c, arrays) && ok;
+
+      if (l + 1 == nlevels)
+        break;
+
+      for (auto &array : arrays)
+        array = downsample_2x(array);
+
+      const glm::ivec2 parent = c / 2;
+      const int        quadrant = (c.x % 2) + 2 * (c.y % 2);
+      const glm::ivec2 nchildren = glm::min(glm::ivec2(2),
+                                            levels[l].nchunks - 2 * parent);
+
+      PendingParent entry;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        PendingParent &p = pending[l + 1][{parent.x, parent.y}];
+        p.quadrants[quadrant] = std::move(arrays);
+
+        if (++p.nreceived < nchildren.x * nchildren.y)
+          return ok;
+
+        entry = std::move(p);
+        pending[l + 1].erase({parent.x, parent.y});
+      }
+
+      // assemble the parent chunk
+      const glm::ivec2 offset = entry.quadrants[0].front().shape;
+      const glm::ivec2 shape = glm::min(glm::ivec2(chunk_size),
+                                        levels[l + 1].shape - parent * chunk_size);
+
+      arrays.assign(nchannels, hmap::Array(shape));
+
+      for (int q = 0; q < 4; ++q)
+      {
+        if (entry.quadrants[q].empty())
+          continue;
+
+        const glm::ivec2 ij0 = {(q % 2) * offset.x, (q / 2) * offset.y};
+
+        for (int nch = 0; nch < nchannels; ++nch)
+        {
+          const hmap::Array &quad = entry.quadrants[q][nch];
+
+          for (int i = 0; i < quad.shape.x; ++i)
+            for (int j = 0; j < quad.shape.y; ++j)
+              arrays[nch](ij0.x + i, ij0.y + j) = quad(i, j);
+        }
+      }
+
+      c = parent;
+    }
+
+    return ok;
+  };
+
+  // level 0 chunks, from the heightmap tiles
+  std::vector<ExportBlock> blocks;
+  std::vector<glm::ivec2>  chunk_indices;
+
+  for (int ci = 0; ci < levels[0].nchunks.x; ++ci)
+    for (int cj = 0; cj < levels[0].nchunks.y; ++cj)
+    {
+      const glm::ivec2 ij0 = glm::ivec2(ci, cj) * chunk_size;
+
+      blocks.push_back({ij0, glm::min(glm::ivec2(chunk_size), levels[0].shape - ij0)});
+      chunk_indices.push_back({ci, cj});
+    }
+
+  ParallelTileWriter writer;
+
+  auto submit_chunk = [&](size_t k, std::vector<hmap::Array> &arrays)
+  {
+    auto sp_arrays = std::make_shared<std::vector<hmap::Array>>(std::move(arrays));
+
+    writer.submit([&, k, sp_arrays]()
+                  { return process_chunk(chunk_indices[k], std::move(*sp_arrays)); });
+    return true;
+  };
+
+  bool ok = stream_export_blocks(channels, tile_shape, blocks, submit_chunk, cm);
+  return writer.wait() && ok;
+}
+
+bool export_normal_map_tiled_streamed(hmap::VirtualArray      &array,
+                                      const glm::ivec2        &tile_shape,
+                                      const std::string       &fname,
+                                      const TiledExportLayout &layout,
+                                      int                      bit_depth,
+                                      const hmap::ComputeMode &cm)
+{
+  Logger::log()->trace("export_normal_map_tiled_streamed: {}", fname);
+
+  auto encode = [bit_depth](const std::string              &fname_tile,
+                            const std::vector<hmap::Array> &channels,
+                            const glm::ivec2               &ij0,
+                            const glm::ivec2               &shape)
+  {
+    // the margin makes the gradients at the tile borders match the ones of the full
+    // heightmap
+    hmap::Tensor             tn = hmap::normal_map(channels[0]);
+    std::vector<hmap::Array> n = {tn.get_slice(0), tn.get_slice(1), tn.get_slice(2)};
+
+    return write_png_tile(fname_tile,
+                          ij0,
+                          shape,
+                          bit_depth,
+                          3,
+                          [&n](int i, int j, float *rgb)
+                          {
+                            for (int c = 0; c < 3; ++c)
+                              rgb[c] = n[c](i, j);
+                          });
+  };
+
+  return export_tiled_parallel({&array}, tile_shape, fname, layout, 1, encode, cm);
+}
+
+bool export_png_streamed(hmap::VirtualArray      &array,
+                         const glm::ivec2        &tile_shape,
+                         const std::string       &fname,
+                         int                      bit_depth,
+                         const hmap::ComputeMode &cm)
+{
+  Logger::log()->trace("export_png_streamed: {}", fname);
+
+  float vmin, scale;
+  std::tie(vmin, scale) = get_normalization(array, cm);
+
+  return export_png_bands({&array}, tile_shape, fname, bit_depth, vmin, scale, cm);
+}
+
+bool export_png_streamed(const std::vector<hmap::VirtualArray *> &channels,
+                         const glm::ivec2                        &tile_shape,
+                         const std::string                       &fname,
+                         int                                      bit_depth,
+                         const hmap::ComputeMode                 &cm)
+{
+  Logger::log()->trace("export_png_streamed: {}, {} channel(s)", fname, channels.size());
+
+  return export_png_bands(channels, tile_shape, fname, bit_depth, 0.f, 1.f, cm);
+}
+
+bool export_raw_16bit_streamed(hmap::VirtualArray      &array,
+                               const glm::ivec2        &tile_shape,
+                               const std::string       &fname,
+                               const hmap::ComputeMode &cm)
+{
+  Logger::log()->trace("export_raw_16bit_streamed: {}", fname);
+
+  std::ofstream file(fname, std::ios::binary);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("export_raw_16bit_streamed: could not open file {}", fname);
+    return false;
+  }
+
+  float vmin, scale;
+  std::tie(vmin, scale) = get_normalization(array, cm);
+
+  const std::vector<ExportBlock> bands = get_row_bands(array.shape, tile_shape.y);
+  std::vector<float>             row;
+  std::vector<uint16_t>          row_u16;
+
+  // little endian, as expected by most terrain tools. Fixed size rows, so that each band
+  // is written at its place as soon as it is complete, whatever the tile order
+  auto write_band = [&](size_t k, std::vector<hmap::Array> &channels)
+  {
+    const hmap::Array &band = channels[0];
+    const size_t       row_top = size_t(array.shape.y - bands[k].ij0.y - band.shape.y);
+
+    file.seekp(std::streamoff(row_top * size_t(array.shape.x) * sizeof(uint16_t)));
+
+    for (int j = band.shape.y - 1; j >= 0; --j)
+    {
+      get_block_row(band, j, vmin, scale, row);
+
+      row_u16.resize(row.size());
+      for (size_t i = 0; i < row.size(); ++i)
+        row_u16[i] = static_cast<uint16_t>(
+            std::lround(std::clamp(row[i], 0.f, 1.f) * 65535.f));
+
+      file.write(reinterpret_cast<const char *>(row_u16.data()),
+                 row_u16.size() * sizeof(uint16_t));
+    }
+    return file.good();
+  };
+
+  return stream_export_blocks({&array}, tile_shape, bands, write_band, cm);
+}
+
+bool export_texture_tiled_streamed(hmap::VirtualTexture    &texture,
+                                   const glm::ivec2        &tile_shape,
+                                   const std::string       &fname,
+                                   const TiledExportLayout &layout,
+                                   int                      bit_depth,
+                                   const hmap::ComputeMode &cm)
+{
+  Logger::log()->trace("export_texture_tiled_streamed: {}", fname);
+
+  std::vector<hmap::VirtualArray *> arrays;
+  for (int nch = 0; nch < 4; ++nch)
+    arrays.push_back(&texture.channel(nch));
+
+  auto encode = [bit_depth](const std::string              &fname_tile,
+                            const std::vector<hmap::Array> &channels,
+                            const glm::ivec2               &ij0,
+                            const glm::ivec2               &shape)
+  {
+    return write_png_tile(fname_tile,
+                          ij0,
+                          shape,
+                          bit_depth,
+                          4,
+                          [&channels](int i, int j, float *rgba)
+                          {
+                            for (int c = 0; c < 4; ++c)
+                              rgba[c] = channels[c](i, j);
+                          });
+  };
+
+  return export_tiled_parallel(arrays, tile_shape, fname, layout, 0, encode, cm);
+}
+
+bool export_tiled_streamed(hmap::VirtualArray      &array,
+                           const glm::ivec2        &tile_shape,
+                           const std::string       &fname,
+                           const TiledExportLayout &layout,
+                           int                      bit_depth,
+                           const hmap::ComputeMode &cm)
+{
+  Logger::log()->trace("export_tiled_streamed: {}", fname);
+
+  float vmin, scale;
+  std::tie(vmin, scale) = get_normalization(array, cm);
+
+  auto encode = [bit_depth, vmin, scale](const std::string              &fname_tile,
+                                         const std::vector<hmap::Array> &channels,
+                                         const glm::ivec2               &ij0,
+                                         const glm::ivec2               &shape)
+  {
+    return write_png_tile(fname_tile,
+                          ij0,
+                          shape,
+                          bit_depth,
+                          1,
+                          [&channels, vmin, scale](int i, int j, float *v)
+                          { *v = (channels[0](i, j) - vmin) * scale; });
+  };
+
+  return export_tiled_parallel({&array}, tile_shape, fname, layout, 0, encode, cm);
+}
+
+std::vector<LodLevel> get_lod_pyramid_levels(const glm::ivec2 &shape, int chunk_size)
+{
+  std::vector<LodLevel> levels;
+  LodLevel              level = {shape, (shape + chunk_size - 1) / chunk_size};
+
+  levels.push_back(level);
+
+  while (level.nchunks.x > 1 || level.nchunks.y > 1)
+  {
+    level.shape = (level.shape + 1) / 2;
+    level.nchunks = (level.shape + chunk_size - 1) / chunk_size;
+    levels.push_back(level);
+  }
+
+  return levels;
+}
+
+bool stream_export_blocks(const std::vector<hmap::VirtualArray *> &arrays,
+                          const glm::ivec2                        &tile_shape,
+                          const std::vector<ExportBlock>          &blocks,
+                          const ExportBlockWriter                 &write_block,
+                          const hmap::ComputeMode                 &cm)
+{
+  struct PendingBlock
+  {
+    std::vector<hmap::Array> channels;
+    size_t                   remaining = 0; // pixels not received yet
+    bool                     written = false;
+  };
+
+  const glm::ivec2 shape = arrays.front()->shape;
+  const size_t     nchannels = arrays.size();
+
+  std::vector<PendingBlock> pending(blocks.size());
+  std::mutex                mutex;       // pending blocks
+  std::mutex                write_mutex; // writer, never called concurrently
+  bool                      ok = true;
+
+  for (size_t k = 0; k < blocks.size(); ++k)
+    pending[k].remaining = size_t(blocks[k].shape.x) * size_t(blocks[k].shape.y);
+
+  auto allocate = [&](size_t k) // lock must be held
+  {
+    if (pending[k].channels.empty())
+      pending[k].channels.assign(nchannels, hmap::Array(blocks[k].shape));
+  };
+
+  // the blocks are handed over to the writer without holding the lock, so that the
+  // other threads keep gathering tiles while a block is being encoded
+  auto write = [&](size_t k, std::vector<hmap::Array> &channels)
+  {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    ok = write_block(k, channels) && ok;
+  };
+
+  // read-only pass over the tiles, one at a time per thread
+  hmap::ComputeMode cm_stream = cm;
+  cm_stream.mode = hmap::ForEachMode::VA_DISTRIBUTED;
+
+  hmap::for_each_tile(
+      arrays,
+      [&](std::vector<hmap::Array *> p_arrays, const hmap::TileRegion &region)
+      {
+        const TileInterior interior = get_tile_interior(region, shape, tile_shape);
+        const glm::ivec2  &tile_ij0 = interior.ij0;
+        const glm::ivec2  &a = interior.a;
+        const glm::ivec2  &b = interior.b;
+
+        std::vector<std::pair<size_t, std::vector<hmap::Array>>> complete;
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+
+          for (size_t k = 0; k < blocks.size(); ++k)
+          {
+            glm::ivec2 c = glm::max(a, blocks[k].ij0);
+            glm::ivec2 d = glm::min(b, blocks[k].ij0 + blocks[k].shape);
+
+            if (c.x >= d.x || c.y >= d.y || pending[k].written)
+              continue;
+
+            PendingBlock &block = pending[k];
+            allocate(k);
+
+            for (size_t nch = 0; nch < nchannels; ++nch)
+            {
+              const hmap::Array &tile = *p_arrays[nch];
+              hmap::Array       &data = block.channels[nch];
+
+              for (int i = c.x; i < d.x; ++i)
+                for (int j = c.y; j < d.y; ++j)
+                  data(i - blocks[k].ij0.x, j - blocks[k].ij0.y) = tile(i - tile_ij0.x,
+                                                                        j - tile_ij0.y);
+            }
+
+            size_t npixels = size_t(d.x - c.x) * size_t(d.y - c.y);
+            block.remaining -= std::min(block.remaining, npixels);
+
+            if (block.remaining == 0)
+            {
+              block.written = true;
+              complete.push_back({k, std::move(block.channels)});
+              block.channels.clear();
+            }
+          }
+        }
+
+        for (auto &[k, channels] : complete)
+          write(k, channels);
+      },
+      cm_stream);
+
+  // blocks left incomplete, if the tiling grid does not partition the heightmap
+  for (size_t k = 0; k < blocks.size(); ++k)
+    if (!pending[k].written)
+    {
+      Logger::log()->warn("stream_export_blocks: block {} incomplete", k);
+      allocate(k);
+      write(k, pending[k].channels);
+    }
+
+  return ok;
+}
+
+} // namespace hesiod
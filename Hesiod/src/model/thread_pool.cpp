@@ -0,0 +1,98 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include "hesiod/model/thread_pool.hpp"
+#include "hesiod/logger.hpp"
+
+namespace hesiod
+{
+
+ThreadPool::ThreadPool(size_t nthreads)
+{
+  nthreads = nthreads ? nthreads : get_default_thread_count();
+
+  Logger::log()->trace("ThreadPool::ThreadPool: nthreads = {}", nthreads);
+
+  this->workers.reserve(nthreads);
+  for (size_t k = 0; k < nthreads; ++k)
+    this->workers.emplace_back([this]() { this->worker_loop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->cv_task.notify_all();
+
+  for (auto &w : this->workers)
+    if (w.joinable())
+      w.join();
+}
+
+size_t ThreadPool::get_nthreads() const { return this->workers.size(); }
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+  // packaged task is shared since std::function requires a copyable target
+  auto sp_task = std::make_shared<std::packaged_task<void()>>(std::move(task));
+  std::future<void> future = sp_task->get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->tasks.emplace_back([sp_task]() { (*sp_task)(); });
+  }
+  this->cv_task.notify_one();
+
+  return future;
+}
+
+void ThreadPool::wait_idle()
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->cv_idle.wait(lock,
+                     [this]() { return this->tasks.empty() && this->active_count == 0; });
+}
+
+void ThreadPool::worker_loop()
+{
+  while (true)
+  {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cv_task.wait(lock, [this]() { return this->stop || !this->tasks.empty(); });
+
+      if (this->stop && this->tasks.empty())
+        return;
+
+      task = std::move(this->tasks.front());
+      this->tasks.pop_front();
+      this->active_count++;
+    }
+
+    // exceptions are stored in the future by the packaged task
+    task();
+
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->active_count--;
+    }
+    this->cv_idle.notify_all();
+  }
+}
+
+// --- helper
+
+size_t get_default_thread_count(int requested)
+{
+  if (requested > 0)
+    return static_cast<size_t>(requested);
+
+  size_t n = static_cast<size_t>(std::thread::hardware_concurrency());
+  return n > 0 ? n : 1;
+}
+
+} // namespace hesiod
@@ -0,0 +1,412 @@
+/* Copyright (c) 2025 Otto Link. Distributed under the terms of the GNU General
+ * Public License. The full license is in the file LICENSE, distributed with
+ * this software. */
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#include <zlib.h>
+
+#include "hesiod/logger.hpp"
+#include "hesiod/model/streaming_export.hpp"
+
+// TIFF 6.0 and BigTIFF tags and types, see https://www.awaresystems.be/imaging/tiff
+#define TIFF_SHORT 3
+#define TIFF_LONG 4
+#define TIFF_LONG8 16
+
+namespace hesiod
+{
+
+// --- helpers
+
+// one resolution level of the pyramid, tiles are indexed row-major from the image top
+struct TiffLevel
+{
+  glm::ivec2            shape;
+  glm::ivec2            ntiles;
+  std::vector<uint64_t> offsets;
+  std::vector<uint64_t> byte_counts;
+};
+
+static void push_le(std::vector<uint8_t> &bytes, uint64_t value, size_t size)
+{
+  for (size_t k = 0; k < size; ++k)
+    bytes.push_back(static_cast<uint8_t>(value >> (8 * k)));
+}
+
+// image file directory of a level, with the tag values which do not fit in the entries
+// stored right after it
+static std::vector<uint8_t> get_ifd_bytes(const TiffLevel  &level,
+                                          bool              is_overview,
+                                          const glm::ivec2 &tile,
+                                          bool              compress,
+                                          bool              bigtiff,
+                                          uint64_t          ifd_offset,
+                                          uint64_t          next_ifd_offset)
+{
+  struct Entry
+  {
+    uint16_t              tag;
+    uint16_t              type;
+    std::vector<uint64_t> values;
+  };
+
+  const uint16_t offset_type = bigtiff ? TIFF_LONG8 : TIFF_LONG;
+
+  // sorted by tag, as required: NewSubfileType (reduced resolution or not),
+  // ImageWidth, ImageLength, BitsPerSample, Compression (deflate or none),
+  // PhotometricInterpretation (min is black), SamplesPerPixel, PlanarConfiguration,
+  // Predictor (floating point), TileWidth, TileLength, TileOffsets, TileByteCounts and
+  // SampleFormat (float)
+  std::vector<Entry> entries = {{254, TIFF_LONG, {is_overview ? 1u : 0u}},
+                                {256, TIFF_LONG, {uint64_t(level.shape.x)}},
+                                {257, TIFF_LONG, {uint64_t(level.shape.y)}},
+                                {258, TIFF_SHORT, {32}},
+                                {259, TIFF_SHORT, {compress ? 8u : 1u}},
+                                {262, TIFF_SHORT, {1}},
+                                {277, TIFF_SHORT, {1}},
+                                {284, TIFF_SHORT, {1}}};
+
+  if (compress)
+    entries.push_back({317, TIFF_SHORT, {3}});
+
+  entries.push_back({322, TIFF_LONG, {uint64_t(tile.x)}});
+  entries.push_back({323, TIFF_LONG, {uint64_t(tile.y)}});
+  entries.push_back({324, offset_type, level.offsets});
+  entries.push_back({325, offset_type, level.byte_counts});
+  entries.push_back({339, TIFF_SHORT, {3}});
+
+  const size_t count_size = bigtiff ? 8 : 2;
+  const size_t entry_size = bigtiff ? 20 : 12;
+  const size_t value_size = bigtiff ? 8 : 4; // inline capacity, or offset size
+
+  // out-of-line values, right after the directory
+  const uint64_t ifd_size = count_size + entries.size() * entry_size + value_size;
+  const uint64_t extra_offset = ifd_offset + ifd_size;
+
+  std::vector<uint8_t> bytes;
+  std::vector<uint8_t> extra;
+
+  push_le(bytes, entries.size(), count_size);
+
+  for (auto &e : entries)
+  {
+    const size_t type_size = e.type == TIFF_SHORT ? 2 : (e.type == TIFF_LONG ? 4 : 8);
+
+    push_le(bytes, e.tag, 2);
+    push_le(bytes, e.type, 2);
+    push_le(bytes, e.values.size(), value_size);
+
+    if (e.values.size() * type_size <= value_size)
+    {
+      for (uint64_t v : e.values)
+        push_le(bytes, v, type_size);
+      push_le(bytes, 0, value_size - e.values.size() * type_size); // padding
+    }
+    else
+    {
+      push_le(bytes, extra_offset + extra.size(), value_size);
+      for (uint64_t v : e.values)
+        push_le(extra, v, type_size);
+    }
+  }
+
+  push_le(bytes, next_ifd_offset, value_size);
+  bytes.insert(bytes.end(), extra.begin(), extra.end());
+
+  return bytes;
+}
+
+// tile pixels, rows from the image top, from the region ('ij0', 'shape') of the array
+// (heightmap orientation, j = shape.y - 1 is the top row). Partial tiles are padded by
+// replicating the edges
+static std::vector<float> get_tile_values(const hmap::Array &array,
+                                          const glm::ivec2  &ij0,
+                                          const glm::ivec2  &shape,
+                                          const glm::ivec2  &tile)
+{
+  std::vector<float> values(size_t(tile.x) * size_t(tile.y));
+
+  for (int r = 0; r < tile.y; ++r)
+  {
+    int j = ij0.y + shape.y - 1 - std::min(r, shape.y - 1);
+
+    for (int c = 0; c < tile.x; ++c)
+    {
+      int i = ij0.x + std::min(c, shape.x - 1);
+      values[size_t(r) * size_t(tile.x) + c] = array(i, j);
+    }
+  }
+
+  return values;
+}
+
+static bool encode_tile(const std::vector<float> &values,
+                        const glm::ivec2         &tile,
+                        bool                      compress,
+                        std::vector<uint8_t>     &out)
+{
+  const size_t         row_size = size_t(tile.x) * 4;
+  std::vector<uint8_t> bytes(values.size() * 4);
+
+  for (int r = 0; r < tile.y; ++r)
+  {
+    uint8_t *row = &bytes[r * row_size];
+
+    for (int c = 0; c < tile.x; ++c)
+    {
+      uint32_t u;
+      std::memcpy(&u, &values[size_t(r) * size_t(tile.x) + c], 4);
+
+      if (compress)
+      {
+        // floating point predictor: byte planes, most significant first...
+        for (int b = 0; b < 4; ++b)
+          row[b * tile.x + c] = static_cast<uint8_t>(u >> (8 * (3 - b)));
+      }
+      else
+      {
+        // little endian, as announced in the header
+        for (int b = 0; b < 4; ++b)
+          row[4 * c + b] = static_cast<uint8_t>(u >> (8 * b));
+      }
+    }
+
+    // ...then byte-wise horizontal differencing
+    if (compress)
+      for (size_t k = row_size - 1; k > 0; --k)
+        row[k] -= row[k - 1];
+  }
+
+  if (!compress)
+  {
+    out = std::move(bytes);
+    return true;
+  }
+
+  uLongf size = compressBound(static_cast<uLong>(bytes.size()));
+  out.resize(size);
+
+  if (compress2(out.data(), &size, bytes.data(), static_cast<uLong>(bytes.size()), 6) !=
+      Z_OK)
+    return false;
+
+  out.resize(size);
+  return true;
+}
+
+// --- function
+
+bool export_tiff_float32_streamed(hmap::VirtualArray      &array,
+                                  const glm::ivec2        &tile_shape,
+                                  const std::string       &fname,
+                                  bool                     compress,
+                                  const hmap::ComputeMode &cm)
+{
+  Logger::log()->trace("export_tiff_float32_streamed: {}", fname);
+
+  // TIFF tile dimensions must be multiples of 16
+  const glm::ivec2 tile = ((glm::max(tile_shape, glm::ivec2(1)) + 15) / 16) * 16;
+
+  // pyramid, halving the resolution until the image fits in a single tile
+  std::vector<TiffLevel> levels;
+  glm::ivec2             shape = array.shape;
+
+  while (true)
+  {
+    TiffLevel level;
+    level.shape = shape;
+    level.ntiles = (shape + tile - 1) / tile;
+    level.offsets.resize(size_t(level.ntiles.x) * size_t(level.ntiles.y));
+    level.byte_counts.resize(level.offsets.size());
+    levels.push_back(level);
+
+    if (shape.x <= tile.x && shape.y <= tile.y)
+      break;
+
+    shape = (shape + 1) / 2;
+  }
+
+  // BigTIFF when the uncompressed size gets close to the 4 GB offset limit
+  uint64_t raw_size = 0;
+  for (auto &level : levels)
+    raw_size += level.offsets.size() * uint64_t(tile.x) * uint64_t(tile.y) * 4;
+
+  const bool     bigtiff = raw_size > 0xF0000000ULL;
+  const uint64_t header_size = bigtiff ? 16 : 8;
+
+  // directories first (cloud optimized layout), their size does not depend on the
+  // offset values
+  std::vector<uint64_t> ifd_offsets;
+  uint64_t              data_offset = header_size;
+
+  for (size_t l = 0; l < levels.size(); ++l)
+  {
+    ifd_offsets.push_back(data_offset);
+    data_offset += get_ifd_bytes(levels[l], l > 0, tile, compress, bigtiff, 0, 0).size();
+  }
+
+  std::fstream file(fname, std::ios::binary | std::ios::in | std::ios::out |
+                               std::ios::trunc);
+
+  if (!file.is_open())
+  {
+    Logger::log()->error("export_tiff_float32_streamed: could not open file {}", fname);
+    return false;
+  }
+
+  std::vector<char> placeholder(data_offset, 0);
+  file.write(placeholder.data(), placeholder.size());
+
+  // tiles are appended as they are encoded, in any order
+  std::mutex file_mutex;
+  uint64_t   file_end = data_offset;
+
+  auto append_tile = [&](TiffLevel &level, size_t index, const std::vector<float> &values)
+  {
+    std::vector<uint8_t> bytes;
+    if (!encode_tile(values, tile, compress, bytes))
+      return false;
+
+    std::lock_guard<std::mutex> lock(file_mutex);
+
+    file.seekp(static_cast<std::streamoff>(file_end));
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+
+    level.offsets[index] = file_end;
+    level.byte_counts[index] = bytes.size();
+    file_end += bytes.size();
+
+    return file.good();
+  };
+
+  // --- full resolution, one block per TIFF tile, the first overview being
+  // --- accumulated along the way
+
+  TiffLevel &level0 = levels.front();
+
+  std::vector<ExportBlock> blocks;
+  for (int ty = 0; ty < level0.ntiles.y; ++ty)
+    for (int tx = 0; tx < level0.ntiles.x; ++tx)
+    {
+      int r0 = ty * tile.y;
+      int r1 = std::min(r0 + tile.y, level0.shape.y);
+      int i0 = tx * tile.x;
+      int i1 = std::min(i0 + tile.x, level0.shape.x);
+
+      blocks.push_back({{i0, level0.shape.y - r1}, {i1 - i0, r1 - r0}});
+    }
+
+  hmap::Array overview;
+
+  if (levels.size() > 1)
+    overview = hmap::Array(levels[1].shape);
+
+  bool ok;
+
+  {
+    ParallelTileWriter writer;
+
+    auto write_block = [&](size_t k, std::vector<hmap::Array> &channels)
+    {
+      auto sp_block = std::make_shared<hmap::Array>(std::move(channels[0]));
+
+      // called under the streaming lock, the overview needs no additional one
+      if (levels.size() > 1)
+        for (int i = 0; i < sp_block->shape.x; ++i)
+          for (int j = 0; j < sp_block->shape.y; ++j)
+          {
+            int p = (blocks[k].ij0.x + i) / 2;
+            int q = (blocks[k].ij0.y + j) / 2;
+
+            // averaged over the number of contributing pixels at the edges
+            int nx = std::min(2, level0.shape.x - 2 * p);
+            int ny = std::min(2, level0.shape.y - 2 * q);
+            overview(p, q) += (*sp_block)(i, j) / float(nx * ny);
+          }
+
+      writer.submit(
+          [&, k, sp_block]()
+          {
+            return append_tile(
+                level0,
+                k,
+                get_tile_values(*sp_block, glm::ivec2(0), sp_block->shape, tile));
+          });
+
+      return true;
+    };
+
+    ok = stream_export_blocks({&array}, tile_shape, blocks, write_block, cm);
+    ok = writer.wait() && ok;
+  }
+
+  // --- overviews, from the in-memory first overview
+
+  for (size_t l = 1; l < levels.size(); ++l)
+  {
+    if (l > 1)
+      overview = downsample_2x(overview);
+
+    TiffLevel         &level = levels[l];
+    ParallelTileWriter writer;
+
+    for (int ty = 0; ty < level.ntiles.y; ++ty)
+      for (int tx = 0; tx < level.ntiles.x; ++tx)
+        writer.submit(
+            [&, tx, ty]()
+            {
+              int r0 = ty * tile.y;
+              int r1 = std::min(r0 + tile.y, level.shape.y);
+              int i0 = tx * tile.x;
+              int i1 = std::min(i0 + tile.x, level.shape.x);
+
+              return append_tile(level,
+                                 size_t(ty) * size_t(level.ntiles.x) + tx,
+                                 get_tile_values(overview,
+                                                 {i0, level.shape.y - r1},
+                                                 {i1 - i0, r1 - r0},
+                                                 tile));
+            });
+
+    ok = writer.wait() && ok;
+  }
+
+  // --- header and directories, now that the tile offsets are known
+
+  std::vector<uint8_t> header = {'I', 'I'};
+
+  if (bigtiff)
+  {
+    push_le(header, 43, 2);
+    push_le(header, 8, 2); // offset size
+    push_le(header, 0, 2);
+    push_le(header, ifd_offsets.front(), 8);
+  }
+  else
+  {
+    push_le(header, 42, 2);
+    push_le(header, ifd_offsets.front(), 4);
+  }
+
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(header.data()), header.size());
+
+  for (size_t l = 0; l < levels.size(); ++l)
+  {
+    uint64_t next = l + 1 < levels.size() ? ifd_offsets[l + 1] : 0;
+
+    std::vector<uint8_t> bytes =
+        get_ifd_bytes(levels[l], l > 0, tile, compress, bigtiff, ifd_offsets[l], next);
+
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+  }
+
+  file.close();
+
+  return ok && !file.fail();
+}
+
+} // namespace hesiod
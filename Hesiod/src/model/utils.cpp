@@ -2,6 +2,7 @@
  * Public License. The full license is in the file LICENSE, distributed with
  * this software. */
 #include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
@@ -74,6 +75,50 @@ std::filesystem::path ensure_extension(std::filesystem::path fname,
   return fname;
 }
 
+uint64_t hash_combine(uint64_t seed, uint64_t value)
+{
+  for (int k = 0; k < 8; ++k)
+  {
+    seed ^= (value >> (8 * k)) & 0xffULL;
+    seed *= 0x100000001b3ULL;
+  }
+  return seed;
+}
+
+uint64_t hash_data(const void *data, size_t size, uint64_t seed)
+{
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  size_t               nwords = size / sizeof(uint64_t);
+
+  // 8 bytes at a time, then the remaining bytes
+  for (size_t k = 0; k < nwords; ++k)
+  {
+    uint64_t word;
+    std::memcpy(&word, p + k * sizeof(uint64_t), sizeof(uint64_t));
+    seed ^= word;
+    seed *= 0x100000001b3ULL;
+    seed ^= seed >> 32;
+  }
+
+  for (size_t k = nwords * sizeof(uint64_t); k < size; ++k)
+  {
+    seed ^= static_cast<uint64_t>(p[k]);
+    seed *= 0x100000001b3ULL;
+  }
+
+  return seed;
+}
+
+uint64_t hash_string(const std::string &str, uint64_t seed)
+{
+  for (unsigned char c : str)
+  {
+    seed ^= static_cast<uint64_t>(c);
+    seed *= 0x100000001b3ULL;
+  }
+  return seed;
+}
+
 std::filesystem::path insert_before_basename(const std::filesystem::path &original_path,
                                              const std::string           &insert_str)
 {
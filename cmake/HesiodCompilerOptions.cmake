@@ -60,3 +60,9 @@ if(MSVC)
   target_compile_options(hesiod_options INTERFACE /W4)
   add_compile_definitions(M_PI=3.14159265358979323846)
 endif()
+
+# Debug checks (any compiler)
+if(HESIOD_DEBUG_CHECKS)
+  message(STATUS "HESIOD_DEBUG_CHECKS is enabled")
+  target_compile_definitions(hesiod_options INTERFACE HESIOD_DEBUG_CHECKS)
+endif()